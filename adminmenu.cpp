@@ -1,4 +1,9 @@
 #include "adminmenu.h"
+#include "pagedmodels.h"
+#include "timetableexport.h"
+#include "timetablerenderer.h"
+#include "imageassets.h"
+#include "records.h"
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -8,14 +13,27 @@
 #include <QFont>
 #include <QPixmap>
 #include <QPainter>
+#include <QResizeEvent>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QTableView>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QApplication>
+#include <QListWidget>
+#include <QLineEdit>
+#include <QElapsedTimer>
+#include <map>
+#include <numeric>
 
 AdminMenu::AdminMenu(Database *db, QWidget *parent)
-    : QWidget(parent), db(db)
+    : QWidget(parent), db(db), impacts(*db), search(*db)
 {
     setWindowTitle("Admin Menu");
     setMinimumSize(1000, 700);
 
     setAttribute(Qt::WA_StyledBackground, true);
+    background = new ScaledBackground(this, AssetPath::adminBackground, Qt::IgnoreAspectRatio);
 
     auto mainLayout = new QVBoxLayout(this);
     mainLayout->setContentsMargins(20, 10, 20, 20);
@@ -25,7 +43,7 @@ AdminMenu::AdminMenu(Database *db, QWidget *parent)
     header->setAlignment(Qt::AlignCenter);
     QFont headerFont("Georgia", 50, QFont::Bold);
     header->setFont(headerFont);
-    header->setStyleSheet("color: white; background: transparent;");
+    header->setObjectName("adminHeader");
     header->setContentsMargins(0, 30, 0, 20);
     mainLayout->addWidget(header);
 
@@ -88,9 +106,9 @@ AdminMenu::AdminMenu(Database *db, QWidget *parent)
     logoLayout->setSpacing(20);
     logoLayout->setContentsMargins(50, 0, 50, 0);
 
-    QPixmap logo("/Users/sufianzahid/Desktop/Qt/OOP/logo.png");
+    QPixmap logo = ImageAssets::instance().scaledNow(AssetPath::logo,
+                                                     QSize(220, 220), Qt::KeepAspectRatio);
     if (!logo.isNull()) {
-        logo = logo.scaled(220, 220, Qt::KeepAspectRatio, Qt::SmoothTransformation);
         auto logoLabel = new QLabel();
         logoLabel->setPixmap(logo);
         logoLabel->setAlignment(Qt::AlignCenter);
@@ -98,23 +116,18 @@ AdminMenu::AdminMenu(Database *db, QWidget *parent)
         logoLayout->addWidget(logoLabel, 0, Qt::AlignHCenter);
     }
 
+    auto exportAllTimetablesBtn = new QPushButton("Export All Timetables");
+    logoLayout->addWidget(exportAllTimetablesBtn, 0, Qt::AlignHCenter);
+    auto renderAllTimetablesBtn = new QPushButton("Print All Timetables");
+    logoLayout->addWidget(renderAllTimetablesBtn, 0, Qt::AlignHCenter);
+    auto bulkImportBtn = new QPushButton("Bulk Import");
+    logoLayout->addWidget(bulkImportBtn, 0, Qt::AlignHCenter);
+    auto bulkRemoveBtn = new QPushButton("Bulk Remove");
+    logoLayout->addWidget(bulkRemoveBtn, 0, Qt::AlignHCenter);
+
     // Add logout button below the logo
     auto logoutBtn = new QPushButton("Logout");
-    logoutBtn->setStyleSheet("QPushButton {"
-                             "background-color: rgba(32, 71, 245, 200);"
-                             "color: white;"
-                             "border: none;"
-                             "border-radius: 15px;"
-                             "padding: 12px 20px;"
-                             "min-width: 220px;"
-                             "min-height: 45px;"
-                             "font-size: 15px;"
-                             "margin: 5px;"
-                             "}"
-                             "QPushButton:hover {"
-                             "background-color: rgba(0, 46, 207, 200);"
-                             "font-weight: bold;"
-                             "}");
+    logoutBtn->setProperty("menuStyle", "admin");
     logoutBtn->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     logoLayout->addWidget(logoutBtn, 0, Qt::AlignHCenter);
 
@@ -128,29 +141,14 @@ AdminMenu::AdminMenu(Database *db, QWidget *parent)
 
     mainLayout->addWidget(contentWidget);
 
-    QString buttonStyle = "QPushButton {"
-                          "background-color: rgba(32, 71, 245, 200);"
-                          "color: white;"
-                          "border: none;"
-                          "border-radius: 15px;"
-                          "padding: 12px 20px;"
-                          "min-width: 220px;"
-                          "min-height: 45px;"
-                          "font-size: 15px;"
-                          "margin: 5px;"
-                          "}"
-                          "QPushButton:hover {"
-                          "background-color: rgba(0, 46, 207, 200);"
-                          "font-weight: bold;"
-                          "}";
-
     QList<QPushButton*> buttons = {addStudentBtn, removeStudentBtn, addFacultyBtn, removeFacultyBtn,
                                     addCourseBtn, removeCourseBtn, addClassroomBtn, removeClassroomBtn,
                                     addTimeslotBtn, removeTimeslotBtn, assignCourseScheduleBtn,
-                                    removeCourseAssignmentBtn, resetStudentPasswordBtn, resetFacultyPasswordBtn};
+                                    removeCourseAssignmentBtn, resetStudentPasswordBtn, resetFacultyPasswordBtn,
+                                    exportAllTimetablesBtn, renderAllTimetablesBtn, bulkImportBtn, bulkRemoveBtn};
 
     for (auto btn : buttons) {
-        btn->setStyleSheet(buttonStyle);
+        btn->setProperty("menuStyle", "admin");
         btn->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     }
 
@@ -168,20 +166,173 @@ AdminMenu::AdminMenu(Database *db, QWidget *parent)
     connect(removeCourseAssignmentBtn, &QPushButton::clicked, this, &AdminMenu::removeCourseAssignment);
     connect(resetStudentPasswordBtn, &QPushButton::clicked, this, &AdminMenu::resetStudentPassword);
     connect(resetFacultyPasswordBtn, &QPushButton::clicked, this, &AdminMenu::resetFacultyPassword);
+    connect(exportAllTimetablesBtn, &QPushButton::clicked, this, &AdminMenu::exportAllTimetables);
+    connect(renderAllTimetablesBtn, &QPushButton::clicked, this, &AdminMenu::renderAllTimetables);
+    connect(bulkImportBtn, &QPushButton::clicked, this, &AdminMenu::bulkImport);
+    connect(bulkRemoveBtn, &QPushButton::clicked, this, &AdminMenu::bulkRemove);
     connect(logoutBtn, &QPushButton::clicked, [this]() { this->close(); });
 }
 
+void AdminMenu::resizeEvent(QResizeEvent *event)
+{
+    background->resized(event->size());
+    QWidget::resizeEvent(event);
+}
+
 void AdminMenu::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
     QPainter painter(this);
-    QPixmap bg("/Users/sufianzahid/Desktop/Qt/OOP/admin.png");
-    if (!bg.isNull()) {
-        painter.drawPixmap(rect(), bg);
+    if (!background->isNull()) {
+        painter.drawPixmap(rect(), background->pixmap());
     }
 }
 
 
+// Lists the sections and students a removal takes with it and asks before
+// going ahead. Removals that affect nothing go through without a prompt.
+bool AdminMenu::confirmImpact(const QString &title, const QString &what, const Impact &impact)
+{
+    if (impact.empty())
+        return true;
+    auto students = impact.students();
+    QString details;
+    for (const auto &s : impact.sections) {
+        const ScheduledCourse &c = s.section;
+        details += QString("Section %1: %2 - %3, %4 %5-%6, Room %7 %8, %9 (%10 students)\n")
+                       .arg(c.schedule_id)
+                       .arg(QString::fromStdString(c.course_code))
+                       .arg(QString::fromStdString(c.course_name))
+                       .arg(QString::fromStdString(c.day))
+                       .arg(QString::fromStdString(c.start_time))
+                       .arg(QString::fromStdString(c.end_time))
+                       .arg(QString::fromStdString(c.room_number))
+                       .arg(QString::fromStdString(c.building))
+                       .arg(QString::fromStdString(c.faculty_name))
+                       .arg(s.students.size());
+    }
+    if (!students.empty()) {
+        details += "\nStudents losing an enrollment:\n";
+        for (const auto &id : students)
+            details += QString::fromStdString(id) + "\n";
+    }
+
+    QMessageBox box(QMessageBox::Warning, title,
+                    QString("Removing %1 also removes %2 scheduled section(s) and %3 enrollment(s) of %4 student(s).\nContinue?")
+                        .arg(what)
+                        .arg(impact.sections.size())
+                        .arg(std::accumulate(impact.sections.begin(), impact.sections.end(), std::size_t(0),
+                                             [](std::size_t n, const ImpactedSection &s) { return n + s.students.size(); }))
+                        .arg(students.size()),
+                    QMessageBox::Yes | QMessageBox::No, this);
+    box.setDetailedText(details);
+    box.setDefaultButton(QMessageBox::No);
+    return box.exec() == QMessageBox::Yes;
+}
+
+// Lists what removing the students deletes with them and always asks, since
+// unlike a section the student record itself is the data being lost.
+bool AdminMenu::confirmStudentRemoval(const QString &title, const QStringList &ids)
+{
+    int enrollments = 0, waitlists = 0, marks = 0, results = 0;
+    QString details, single;
+    for (const auto &id : ids) {
+        auto f = db->getStudentFootprint(id.toStdString());
+        if (!f)
+            continue;
+        enrollments += f->enrollments;
+        waitlists += f->waitlists;
+        marks += f->marks;
+        results += f->results;
+        single = QString::fromStdString(f->student_id + " - " + f->name);
+        details += QString("%1: %2 enrollment(s), %3 waitlist place(s), %4 mark(s), %5 result(s)\n")
+                       .arg(single)
+                       .arg(f->enrollments)
+                       .arg(f->waitlists)
+                       .arg(f->marks)
+                       .arg(f->results);
+    }
+    QString what = ids.size() != 1 ? QString("%1 students").arg(ids.size())
+                                   : "student " + (single.isEmpty() ? ids.front() : single);
+
+    QMessageBox box(QMessageBox::Warning, title,
+                    QString("Removing %1 also deletes %2 enrollment(s), %3 waitlist place(s), %4 mark(s) and %5 course result(s).\nContinue?")
+                        .arg(what)
+                        .arg(enrollments)
+                        .arg(waitlists)
+                        .arg(marks)
+                        .arg(results),
+                    QMessageBox::Yes | QMessageBox::No, this);
+    box.setDetailedText(details);
+    box.setDefaultButton(QMessageBox::No);
+    return box.exec() == QMessageBox::Yes;
+}
+
+// Type-ahead picker over the search index. Returns the key of the record
+// picked from the list, or of the record whose key is exactly what was
+// typed; anything else returns an empty string. The index is brought up to
+// date once here, so typing does not query the database.
+QString AdminMenu::pickRecord(const QString &title, const QString &prompt, SearchKind kind,
+                              const std::function<bool(const SearchHit &)> &accept)
+{
+    search.refresh();
+
+    QDialog dlg(this);
+    dlg.setWindowTitle(title);
+    dlg.resize(600, 450);
+    QVBoxLayout layout(&dlg);
+    QLabel label(prompt);
+    layout.addWidget(&label);
+    QLineEdit edit;
+    layout.addWidget(&edit);
+    QListWidget list;
+    layout.addWidget(&list);
+    QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    QString chosen;
+    auto choose = [&](QListWidgetItem *item) {
+        if (item && list.hasFocus())
+            chosen = item->data(Qt::UserRole).toString();
+    };
+    QObject::connect(&list, &QListWidget::currentItemChanged, &dlg, choose);
+    QObject::connect(&list, &QListWidget::itemClicked, &dlg, choose);
+    QObject::connect(&buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    QObject::connect(&buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    QObject::connect(&list, &QListWidget::itemDoubleClicked, &dlg, &QDialog::accept);
+    QObject::connect(&edit, &QLineEdit::returnPressed, &dlg, &QDialog::accept);
+    layout.addWidget(&buttons);
+
+    auto update = [&]() {
+        chosen.clear();
+        list.clear();
+        for (const auto &hit : search.find(edit.text().toStdString(), 50, kind, accept)) {
+            auto item = new QListWidgetItem(QString::fromStdString(hit.label), &list);
+            item->setData(Qt::UserRole, QString::fromStdString(hit.key));
+        }
+    };
+    QObject::connect(&edit, &QLineEdit::textChanged, &dlg, update);
+    update();
+    if (dlg.exec() != QDialog::Accepted) return QString();
+
+    if (!chosen.isEmpty())
+        return chosen;
+    const QString typed = edit.text().trimmed();
+    auto exact = search.lookup(kind, typed.toStdString());
+    if (exact && (!accept || accept(*exact)))
+        return typed;
+    if (!typed.isEmpty())
+        QMessageBox::information(this, title, "No record has the key \"" + typed + "\". Pick one from the list.");
+    return QString();
+}
+
+// Shows the record a key resolved to and asks before acting on it.
+bool AdminMenu::confirmRecord(const QString &title, const QString &action, SearchKind kind, const QString &key)
+{
+    auto hit = search.lookup(kind, key.toStdString());
+    QString record = hit ? QString::fromStdString(hit->label) : key;
+    return QMessageBox::question(this, title, action + "\n\n" + record, QMessageBox::Yes | QMessageBox::No,
+                                 QMessageBox::No) == QMessageBox::Yes;
+}
+
 void AdminMenu::addStudent() {
     bool ok;
     QString id = QInputDialog::getText(this, "Add Student", "Student ID:", QLineEdit::Normal, "", &ok);
@@ -197,14 +348,16 @@ void AdminMenu::addStudent() {
     int semester = QInputDialog::getInt(this, "Add Student", "Semester:", 1, 1, 20, 1, &ok);
     if (!ok) return;
     db->addStudent(id.toStdString(), fname.toStdString(), lname.toStdString(), email.toStdString(), degree.toStdString(), semester);
+    search.addStudent({id.toStdString(), fname.toStdString(), lname.toStdString(), email.toStdString(), semester, degree.toStdString()});
     QMessageBox::information(this, "Add Student", "Student added (default password 'bnu').");
 }
 
 void AdminMenu::removeStudent() {
-    bool ok;
-    QString id = QInputDialog::getText(this, "Remove Student", "Student ID:", QLineEdit::Normal, "", &ok);
-    if (!ok || id.isEmpty()) return;
+    QString id = pickRecord("Remove Student", "Student (ID, name or email):", SearchKind::Student);
+    if (id.isEmpty()) return;
+    if (!confirmStudentRemoval("Remove Student", {id})) return;
     db->removeStudent(id.toStdString());
+    search.remove(SearchKind::Student, id.toStdString());
     QMessageBox::information(this, "Remove Student", "Student removed.");
 }
 
@@ -227,6 +380,7 @@ void AdminMenu::addFaculty() {
     QString designation = QInputDialog::getText(this, "Add Faculty", "Designation:", QLineEdit::Normal, "", &ok);
     if (!ok || designation.isEmpty()) return;
     db->addFaculty(faculty_id, fname.toStdString(), lname.toStdString(), email.toStdString(), degree.toStdString(), qualification.toStdString(), expertise_sub.toStdString(), designation.toStdString());
+    search.addFaculty({faculty_id, fname.toStdString(), lname.toStdString(), email.toStdString()});
     QMessageBox::information(this, "Add Faculty", "Faculty added.");
 }
 
@@ -234,6 +388,7 @@ void AdminMenu::removeFaculty() {
     bool ok;
     int faculty_id = QInputDialog::getInt(this, "Remove Faculty", "Faculty ID:", 1, 1, 99999, 1, &ok);
     if (!ok) return;
+    if (!confirmImpact("Remove Faculty", QString("faculty %1").arg(faculty_id), impacts.ofFaculty(faculty_id))) return;
     db->removeFaculty(faculty_id);
     QMessageBox::information(this, "Remove Faculty", "Faculty removed.");
 }
@@ -255,14 +410,19 @@ void AdminMenu::addCourse() {
     QString prereq = QInputDialog::getText(this, "Add Course", "Prerequisites:", QLineEdit::Normal, "", &ok);
     if (!ok) return;
     db->addCourse(code.toStdString(), name.toStdString(), credits, semester, dept.toStdString(), max, prereq.toStdString());
+    search.addCourse(code.toStdString(), name.toStdString());
     QMessageBox::information(this, "Add Course", "Course added.");
 }
 
 void AdminMenu::removeCourse() {
-    bool ok;
-    QString code = QInputDialog::getText(this, "Remove Course", "Course Code:", QLineEdit::Normal, "", &ok);
-    if (!ok || code.isEmpty()) return;
+    QString code = pickRecord("Remove Course", "Course (code or name):", SearchKind::Course);
+    if (code.isEmpty()) return;
+    Impact impact = impacts.ofCourse(code.toStdString());
+    if (impact.empty() ? !confirmRecord("Remove Course", "Remove this course?", SearchKind::Course, code)
+                       : !confirmImpact("Remove Course", "course " + code, impact))
+        return;
     db->removeCourse(code.toStdString());
+    search.remove(SearchKind::Course, code.toStdString());
     QMessageBox::information(this, "Remove Course", "Course removed.");
 }
 
@@ -286,6 +446,7 @@ void AdminMenu::removeClassroom() {
     bool ok;
     QString id = QInputDialog::getText(this, "Remove Classroom", "Room ID:", QLineEdit::Normal, "", &ok);
     if (!ok || id.isEmpty()) return;
+    if (!confirmImpact("Remove Classroom", "room " + id, impacts.ofClassroom(id.toStdString()))) return;
     db->removeClassroom(id.toStdString());
     QMessageBox::information(this, "Remove Classroom", "Classroom removed.");
 }
@@ -306,6 +467,7 @@ void AdminMenu::removeTimeslot() {
     bool ok;
     int id = QInputDialog::getInt(this, "Remove Timeslot", "Timeslot ID:", 1, 1, 99999, 1, &ok);
     if (!ok) return;
+    if (!confirmImpact("Remove Timeslot", QString("timeslot %1").arg(id), impacts.ofTimeslot(id))) return;
     db->removeTimeslot(id);
     QMessageBox::information(this, "Remove Timeslot", "Timeslot removed.");
 }
@@ -316,15 +478,17 @@ void AdminMenu::assignCourseSchedule() {
         QMessageBox::information(this, "Assign Course", "All courses already assigned. Remove an assignment to reassign.");
         return;
     }
-    QStringList courseNames;
-    for (const auto& c : courses)
-        courseNames << QString::fromStdString(c.second);
+    std::map<std::string, std::size_t> unscheduled;
+    for (std::size_t i = 0; i < courses.size(); ++i)
+        unscheduled.emplace(courses[i].first, i);
 
-    bool ok;
-    QString selectedCourse = QInputDialog::getItem(this, "Assign Course", "Select course:", courseNames, 0, false, &ok);
-    if (!ok || selectedCourse.isEmpty()) return;
-    int cidx = courseNames.indexOf(selectedCourse);
+    QString selectedCourse = pickRecord("Assign Course", "Select course (code or name):", SearchKind::Course,
+                                        [&](const SearchHit &hit) { return unscheduled.count(hit.key) > 0; });
+    auto course = unscheduled.find(selectedCourse.toStdString());
+    if (course == unscheduled.end()) return;
+    std::size_t cidx = course->second;
 
+    bool ok;
     auto timeslots = db->getAllTimeslots();
     QStringList timeslotNames;
     for (const auto& ts : timeslots)
@@ -369,27 +533,47 @@ void AdminMenu::assignCourseSchedule() {
 }
 
 void AdminMenu::removeCourseAssignment() {
-    auto assignments = db->getAllCourseSchedules();
-    if (assignments.empty()) {
+    ScheduleModel model(db);
+    model.fetchMore(QModelIndex());
+    if (model.rowCount() == 0) {
         QMessageBox::information(this, "Remove Assignment", "No assigned courses.");
         return;
     }
-    QStringList assignmentNames;
-    for (const auto& a : assignments)
-        assignmentNames << QString::fromStdString(a.course_code + " - " + a.course_name + " | " + a.faculty_name + " | " + a.room + " | " + a.timeslot);
 
-    bool ok;
-    QString selectedAssignment = QInputDialog::getItem(this, "Remove Assignment", "Select assignment to remove:", assignmentNames, 0, false, &ok);
-    if (!ok || selectedAssignment.isEmpty()) return;
-    int idx = assignmentNames.indexOf(selectedAssignment);
-    db->removeCourseSchedule(assignments[idx].schedule_id);
+    QDialog dlg(this);
+    dlg.setWindowTitle("Remove Assignment");
+    dlg.resize(900, 500);
+    QVBoxLayout layout(&dlg);
+    QLabel label("Select assignment to remove:");
+    layout.addWidget(&label);
+    QTableView view;
+    view.setModel(&model);
+    view.setSelectionBehavior(QAbstractItemView::SelectRows);
+    view.setSelectionMode(QAbstractItemView::SingleSelection);
+    view.setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view.horizontalHeader()->setStretchLastSection(true);
+    view.verticalHeader()->setDefaultSectionSize(24);
+    layout.addWidget(&view);
+    QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    QObject::connect(&buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    QObject::connect(&buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    QObject::connect(&view, &QTableView::doubleClicked, &dlg, &QDialog::accept);
+    layout.addWidget(&buttons);
+    if (dlg.exec() != QDialog::Accepted) return;
+
+    auto selected = view.selectionModel()->selectedRows();
+    if (selected.isEmpty()) return;
+    int schedule_id = model.assignmentAt(selected.first().row()).schedule_id;
+    if (!confirmImpact("Remove Assignment", QString("section %1").arg(schedule_id), impacts.ofSchedule(schedule_id))) return;
+    db->removeCourseSchedule(schedule_id);
     QMessageBox::information(this, "Remove Assignment", "Assignment removed.");
 }
 
 void AdminMenu::resetStudentPassword() {
-    bool ok;
-    QString studentId = QInputDialog::getText(this, "Reset Student Password", "Enter Student ID to reset password:", QLineEdit::Normal, "", &ok);
-    if (!ok || studentId.isEmpty()) return;
+    QString studentId = pickRecord("Reset Student Password", "Student (ID, name or email):", SearchKind::Student);
+    if (studentId.isEmpty()) return;
+    if (!confirmRecord("Reset Password", "Reset this student's password to 'bnu'?", SearchKind::Student, studentId))
+        return;
 
     if (db->studentExists(studentId.toStdString())) {
         db->resetStudentPassword(studentId.toStdString());
@@ -400,9 +584,10 @@ void AdminMenu::resetStudentPassword() {
 }
 
 void AdminMenu::resetFacultyPassword() {
-    bool ok;
-    QString facultyEmail = QInputDialog::getText(this, "Reset Faculty Password", "Enter Faculty Email:", QLineEdit::Normal, "", &ok);
-    if (!ok || facultyEmail.isEmpty()) return;
+    QString facultyEmail = pickRecord("Reset Faculty Password", "Faculty (name or email):", SearchKind::Faculty);
+    if (facultyEmail.isEmpty()) return;
+    if (!confirmRecord("Reset Password", "Reset this faculty member's password to 'faculty_scit'?", SearchKind::Faculty, facultyEmail))
+        return;
 
     if (db->facultyExists(facultyEmail.toStdString())) {
         if (db->resetFacultyPassword(facultyEmail.toStdString()))
@@ -413,3 +598,207 @@ void AdminMenu::resetFacultyPassword() {
         QMessageBox::warning(this, "Reset Password", "Faculty not found.");
     }
 }
+
+void AdminMenu::exportAllTimetables() {
+    QStringList formats = {"CSV", "iCalendar (.ics)", "JSON"};
+    bool ok;
+    QString format = QInputDialog::getItem(this, "Export All Timetables", "Format:", formats, 0, false, &ok);
+    if (!ok || format.isEmpty()) return;
+
+    TimetableExportOptions options;
+    options.format = format == "JSON" ? TimetableFormat::Json
+                     : format == "CSV" ? TimetableFormat::Csv
+                                       : TimetableFormat::ICalendar;
+    if (options.format == TimetableFormat::ICalendar) {
+        QString start = QInputDialog::getText(this, "Export All Timetables", "Term start (Monday, YYYY-MM-DD):",
+                                              QLineEdit::Normal, QString::fromStdString(options.termStart), &ok);
+        if (!ok || start.isEmpty()) return;
+        if (!TimetableExporter::validTermStart(start.toStdString())) {
+            QMessageBox::warning(this, "Export All Timetables", "The term start must be a Monday written as YYYY-MM-DD.");
+            return;
+        }
+        options.termStart = start.toStdString();
+        options.termWeeks = QInputDialog::getInt(this, "Export All Timetables", "Weeks in term:", options.termWeeks, 1, 52, 1, &ok);
+        if (!ok) return;
+    }
+
+    QString dir = QFileDialog::getExistingDirectory(this, "Export All Timetables");
+    if (dir.isEmpty()) return;
+    options.directory = dir.toStdString();
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    TimetableExportSummary summary = TimetableExporter(*db).exportAll(options);
+    QApplication::restoreOverrideCursor();
+
+    QString message = QString("Exported %1 timetables (%2 rows) in %3 s to %4")
+                          .arg(summary.files)
+                          .arg(summary.rows)
+                          .arg(QString::number(summary.seconds, 'f', 2))
+                          .arg(dir);
+    if (!summary.errors.empty())
+        QMessageBox::warning(this, "Export All Timetables",
+                             message + QString("\n%1 files failed, first: %2")
+                                           .arg(summary.errors.size())
+                                           .arg(QString::fromStdString(summary.errors.front())));
+    else
+        QMessageBox::information(this, "Export All Timetables", message);
+}
+
+void AdminMenu::renderAllTimetables() {
+    QStringList formats = {"PDF", "PNG"};
+    bool ok;
+    QString format = QInputDialog::getItem(this, "Print All Timetables", "Format:", formats, 0, false, &ok);
+    if (!ok || format.isEmpty()) return;
+    QString dir = QFileDialog::getExistingDirectory(this, "Print All Timetables");
+    if (dir.isEmpty()) return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    TimetableRenderSummary summary = TimetableRenderer::renderAll(
+        *db, dir.toStdString(), format == "PDF" ? TimetableImageFormat::Pdf : TimetableImageFormat::Png);
+    QApplication::restoreOverrideCursor();
+
+    QString message = QString("Rendered %1 student and room timetables in %2 s to %3")
+                          .arg(summary.files)
+                          .arg(QString::number(summary.seconds, 'f', 2))
+                          .arg(dir);
+    if (!summary.errors.empty())
+        QMessageBox::warning(this, "Print All Timetables",
+                             message + QString("\n%1 files failed, first: %2")
+                                           .arg(summary.errors.size())
+                                           .arg(QString::fromStdString(summary.errors.front())));
+    else
+        QMessageBox::information(this, "Print All Timetables", message);
+}
+
+void AdminMenu::bulkImport() {
+    bool ok;
+    QStringList kinds = {"Students", "Faculty", "Courses"};
+    QString kind = QInputDialog::getItem(this, "Bulk Import", "Import:", kinds, 0, false, &ok);
+    if (!ok || kind.isEmpty()) return;
+    QString path = QFileDialog::getOpenFileName(this, "Bulk Import", "Data", "CSV files (*.csv)");
+    if (path.isEmpty()) return;
+
+    auto records = readRecords(path.toStdString());
+    if (records.empty()) {
+        QMessageBox::information(this, "Bulk Import", "No rows found in " + path);
+        return;
+    }
+    if (QMessageBox::question(this, "Bulk Import", QString("Import %1 %2 in one transaction?").arg(records.size()).arg(kind.toLower()))
+        != QMessageBox::Yes)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    try {
+        Database::Transaction tx(*db);
+        stageRecords(tx, kind == "Students" ? RecordKind::Students
+                         : kind == "Faculty" ? RecordKind::Faculty
+                                             : RecordKind::Courses, records);
+        tx.commit();
+    }
+    catch (const std::exception &e) {
+        QMessageBox::warning(this, "Bulk Import", QString("Import failed, nothing was changed.\n%1").arg(e.what()));
+        return;
+    }
+    QMessageBox::information(this, "Bulk Import",
+                             QString("Imported %1 %2 in %3 ms.").arg(records.size()).arg(kind.toLower()).arg(timer.elapsed()));
+}
+
+void AdminMenu::bulkRemove() {
+    bool ok;
+    QStringList kinds = {"Students", "Faculty", "Courses", "Course Assignments"};
+    QString kind = QInputDialog::getItem(this, "Bulk Remove", "Remove:", kinds, 0, false, &ok);
+    if (!ok || kind.isEmpty()) return;
+
+    QStringList labels;
+    QList<QVariant> keys;
+    if (kind == "Students") {
+        for (const auto &s : db->getAllStudents()) {
+            labels << QString::fromStdString(s.student_id + " - " + s.first_name + " " + s.last_name + " (" + s.degree + ")");
+            keys << QString::fromStdString(s.student_id);
+        }
+    } else if (kind == "Faculty") {
+        for (const auto &f : db->getAllFaculty()) {
+            labels << QString("%1 - %2").arg(f.first).arg(QString::fromStdString(f.second));
+            keys << f.first;
+        }
+    } else if (kind == "Courses") {
+        for (const auto &c : db->getAllCourses()) {
+            labels << QString::fromStdString(c.first + " - " + c.second);
+            keys << QString::fromStdString(c.first);
+        }
+    } else {
+        for (const auto &a : db->getAllCourseSchedules()) {
+            labels << QString::fromStdString(a.course_code + " - " + a.course_name + " | " + a.faculty_name + " | " + a.room + " | " + a.timeslot);
+            keys << a.schedule_id;
+        }
+    }
+    if (labels.isEmpty()) {
+        QMessageBox::information(this, "Bulk Remove", "Nothing to remove.");
+        return;
+    }
+
+    QDialog dlg(this);
+    dlg.setWindowTitle("Bulk Remove - " + kind);
+    dlg.resize(700, 500);
+    QVBoxLayout layout(&dlg);
+    QLabel label("Select the rows to remove (Ctrl/Shift for several):");
+    layout.addWidget(&label);
+    QListWidget list;
+    list.setSelectionMode(QAbstractItemView::ExtendedSelection);
+    list.addItems(labels);
+    layout.addWidget(&list);
+    QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    QObject::connect(&buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    QObject::connect(&buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    layout.addWidget(&buttons);
+    if (dlg.exec() != QDialog::Accepted) return;
+
+    QList<int> rows;
+    for (const auto &index : list.selectionModel()->selectedRows())
+        rows << index.row();
+    if (rows.isEmpty()) return;
+
+    QString what = QString("%1 %2").arg(rows.size()).arg(kind.toLower());
+    if (kind == "Students") {
+        QStringList ids;
+        for (int row : rows)
+            ids << keys[row].toString();
+        if (!confirmStudentRemoval("Bulk Remove", ids))
+            return;
+    } else {
+        Impact impact;
+        for (int row : rows) {
+            Impact one;
+            if (kind == "Faculty") one = impacts.ofFaculty(keys[row].toInt());
+            else if (kind == "Courses") one = impacts.ofCourse(keys[row].toString().toStdString());
+            else one = impacts.ofSchedule(keys[row].toInt());
+            for (auto &section : one.sections)
+                impact.sections.push_back(std::move(section));
+        }
+        if (impact.empty()) {
+            if (QMessageBox::question(this, "Bulk Remove", "Remove " + what + "?") != QMessageBox::Yes)
+                return;
+        } else if (!confirmImpact("Bulk Remove", what, impact)) {
+            return;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    try {
+        Database::Transaction tx(*db);
+        for (int row : rows) {
+            if (kind == "Students") tx.removeStudent(keys[row].toString().toStdString());
+            else if (kind == "Faculty") tx.removeFaculty(keys[row].toInt());
+            else if (kind == "Courses") tx.removeCourse(keys[row].toString().toStdString());
+            else tx.removeCourseSchedule(keys[row].toInt());
+        }
+        tx.commit();
+    }
+    catch (const std::exception &e) {
+        QMessageBox::warning(this, "Bulk Remove", QString("Remove failed, nothing was changed.\n%1").arg(e.what()));
+        return;
+    }
+    QMessageBox::information(this, "Bulk Remove", QString("Removed %1 in %2 ms.").arg(what).arg(timer.elapsed()));
+}
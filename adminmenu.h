@@ -1,17 +1,33 @@
 #pragma once
+#include <QStringList>
 #include <QWidget>
 #include "database.h"
+#include "impactqueries.h"
+#include "searchindex.h"
+#include <functional>
+
+class ScaledBackground;
 
 class AdminMenu : public QWidget
 {
     Q_OBJECT
     Database *db;
+    ScaledBackground *background;
+    ImpactQueries impacts;
+    SearchIndex search;
+
+    bool confirmImpact(const QString &title, const QString &what, const Impact &impact);
+    bool confirmStudentRemoval(const QString &title, const QStringList &ids);
+    bool confirmRecord(const QString &title, const QString &action, SearchKind kind, const QString &key);
+    QString pickRecord(const QString &title, const QString &prompt, SearchKind kind,
+                       const std::function<bool(const SearchHit &)> &accept = {});
 
 public:
     AdminMenu(Database *db, QWidget *parent = nullptr);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
 private slots:
     void addStudent();
@@ -28,4 +44,8 @@ private slots:
     void removeCourseAssignment();
     void resetStudentPassword();
     void resetFacultyPassword();
+    void exportAllTimetables();
+    void renderAllTimetables();
+    void bulkImport();
+    void bulkRemove();
 };
@@ -0,0 +1,181 @@
+#include "admission.h"
+#include <algorithm>
+#include <utility>
+
+void TokenBucket::refill(Clock::time_point now)
+{
+    tokens = std::min(burst, tokens + rate * std::chrono::duration<double>(now - last).count());
+    last = now;
+}
+
+bool TokenBucket::take(Clock::time_point now)
+{
+    refill(now);
+    if (tokens < 1.0)
+        return false;
+    tokens -= 1.0;
+    return true;
+}
+
+bool TokenBucket::full(Clock::time_point now)
+{
+    refill(now);
+    return tokens >= burst;
+}
+
+TokenBucket::Clock::duration TokenBucket::untilNext(Clock::time_point now)
+{
+    refill(now);
+    if (tokens >= 1.0 || rate <= 0.0)
+        return Clock::duration::zero();
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((1.0 - tokens) / rate));
+}
+
+AdmissionControl::AdmissionControl(const AdmissionLimits& limits)
+    : limits(limits), global(limits.globalRate, limits.globalBurst, Clock::now())
+{
+    waitMs.reserve(waitSamples);
+    dispatcher = std::thread(&AdmissionControl::dispatch, this);
+}
+
+AdmissionControl::~AdmissionControl()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    dispatcher.join();
+}
+
+// The first position is sent before the request is queued, so it reaches
+// the client ahead of the dispatcher's reports and of the job's reply.
+bool AdmissionControl::enqueue(const std::string& key, Job job, Progress progress)
+{
+    std::lock_guard<std::mutex> arrival(arrivalMutex);
+    std::size_t position;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (depth >= limits.maxQueue) {
+            ++rejected;
+            return false;
+        }
+        position = depth + 1;
+    }
+    if (progress && position > 1)
+        progress(position, position);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = students.find(key);
+        if (it == students.end())
+            it = students.emplace(key, Student{{}, TokenBucket(limits.studentRate, limits.studentBurst, Clock::now())}).first;
+        if (it->second.waiting.empty())
+            ring.push_back(key);
+        it->second.waiting.push_back({nextSeq++, Clock::now(), std::move(job), progress});
+        ++depth;
+        peakDepth = std::max(peakDepth, depth);
+    }
+    changed.notify_one();
+    return true;
+}
+
+AdmissionStats AdmissionControl::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    AdmissionStats s;
+    s.depth = depth;
+    s.peakDepth = peakDepth;
+    s.admitted = admitted;
+    s.rejected = rejected;
+    if (!waitMs.empty()) {
+        std::vector<double> sorted = waitMs;
+        std::sort(sorted.begin(), sorted.end());
+        s.waitP50Ms = sorted[sorted.size() / 2];
+        s.waitP99Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+        s.waitMaxMs = sorted.back();
+    }
+    return s;
+}
+
+// Tells every waiting request where it stands. Runs the callbacks without
+// the lock, since they write to sockets.
+void AdmissionControl::reportPositions(std::unique_lock<std::mutex>& lock)
+{
+    std::vector<std::pair<std::uint64_t, Progress>> waiting;
+    waiting.reserve(depth);
+    for (const auto& entry : students)
+        for (const auto& w : entry.second.waiting)
+            if (w.progress)
+                waiting.emplace_back(w.seq, w.progress);
+    const std::size_t total = depth;
+    lock.unlock();
+    std::sort(waiting.begin(), waiting.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (std::size_t i = 0; i < waiting.size(); ++i)
+        waiting[i].second(i + 1, total);
+    lock.lock();
+}
+
+// Buckets that have refilled completely carry no state worth keeping.
+void AdmissionControl::prune(Clock::time_point now)
+{
+    for (auto it = students.begin(); it != students.end();) {
+        if (it->second.waiting.empty() && it->second.bucket.full(now))
+            it = students.erase(it);
+        else
+            ++it;
+    }
+}
+
+void AdmissionControl::dispatch()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto nextReport = Clock::now() + progressEvery;
+    while (!stopping) {
+        auto now = Clock::now();
+        if (now >= nextReport) {
+            if (depth)
+                reportPositions(lock);
+            else
+                prune(now);
+            nextReport = Clock::now() + progressEvery;
+            continue;
+        }
+
+        // One pass over the ring: release the first student whose bucket
+        // allows it and move them to the back.
+        Job job;
+        auto wake = nextReport;
+        for (std::size_t i = 0; i < ring.size() && !job; ++i) {
+            Student& student = students.at(ring.front());
+            if (!global.untilNext(now).count() && student.bucket.take(now)) {
+                global.take(now);
+                Waiting w = std::move(student.waiting.front());
+                student.waiting.pop_front();
+                --depth;
+                ++admitted;
+                double waited = std::chrono::duration<double, std::milli>(now - w.since).count();
+                if (waitMs.size() < waitSamples)
+                    waitMs.push_back(waited);
+                else
+                    waitMs[waitNext++ % waitSamples] = waited;
+                job = std::move(w.job);
+                if (student.waiting.empty()) {
+                    ring.pop_front();
+                    break;
+                }
+            } else {
+                wake = std::min(wake, now + std::max(global.untilNext(now), student.bucket.untilNext(now)));
+            }
+            ring.push_back(std::move(ring.front()));
+            ring.pop_front();
+        }
+        if (job) {
+            lock.unlock();
+            job();
+            lock.lock();
+            continue;
+        }
+        changed.wait_until(lock, wake);
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Refills at rate tokens per second up to burst; take() spends one.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(double rate, double burst, Clock::time_point now)
+        : rate(rate), burst(burst), tokens(burst), last(now) {}
+
+    bool take(Clock::time_point now);
+    bool full(Clock::time_point now);
+    // Time until take() can succeed.
+    Clock::duration untilNext(Clock::time_point now);
+
+private:
+    double rate, burst, tokens;
+    Clock::time_point last;
+
+    void refill(Clock::time_point now);
+};
+
+struct AdmissionLimits {
+    double studentRate = 0.5;       // requests per second per student
+    double studentBurst = 4;
+    double globalRate = 100;        // requests per second into the database
+    double globalBurst = 20;
+    std::size_t maxQueue = 5000;    // waiting requests before new ones are refused
+};
+
+struct AdmissionStats {
+    std::size_t depth = 0;
+    std::size_t peakDepth = 0;
+    std::uint64_t admitted = 0;
+    std::uint64_t rejected = 0;
+    double waitP50Ms = 0.0;
+    double waitP99Ms = 0.0;
+    double waitMaxMs = 0.0;
+};
+
+// Gate in front of the enrollment writes. Requests wait in a bounded queue
+// and are released round-robin across students, each release spending a
+// token from the student's bucket and from the global one; a student who
+// clicks ten times does not get ahead of ten students who clicked once.
+// Waiting requests are told their position every progressMs.
+class AdmissionControl {
+public:
+    using Job = std::function<void()>;
+    // position is 1-based in arrival order among the waiting requests.
+    using Progress = std::function<void(std::size_t position, std::size_t depth)>;
+
+    explicit AdmissionControl(const AdmissionLimits& limits);
+    ~AdmissionControl();
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    // Queues job for key; false, without running it, when the queue is full.
+    bool enqueue(const std::string& key, Job job, Progress progress);
+    AdmissionStats stats() const;
+
+private:
+    using Clock = TokenBucket::Clock;
+    static constexpr auto progressEvery = std::chrono::milliseconds(500);
+    static constexpr std::size_t waitSamples = 4096;
+
+    struct Waiting {
+        std::uint64_t seq;
+        Clock::time_point since;
+        Job job;
+        Progress progress;
+    };
+    struct Student {
+        std::deque<Waiting> waiting;
+        TokenBucket bucket;
+    };
+
+    AdmissionLimits limits;
+    // Serialises enqueue, which only depth's growth goes through, so the
+    // place announced outside mutex still holds when the request is queued.
+    std::mutex arrivalMutex;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping = false;
+
+    std::unordered_map<std::string, Student> students;
+    std::deque<std::string> ring;           // students with waiting requests
+    TokenBucket global;
+    std::uint64_t nextSeq = 0;
+    std::size_t depth = 0;
+
+    std::size_t peakDepth = 0;
+    std::uint64_t admitted = 0;
+    std::uint64_t rejected = 0;
+    std::vector<double> waitMs;             // ring buffer of recent waits
+    std::size_t waitNext = 0;
+
+    std::thread dispatcher;
+
+    void dispatch();
+    void reportPositions(std::unique_lock<std::mutex>& lock);
+    void prune(Clock::time_point now);
+};
@@ -0,0 +1,74 @@
+#include "appstyle.h"
+
+QString appStyleSheet()
+{
+    return QStringLiteral(R"(
+        QLabel#logo { background: transparent; }
+        QLabel#mainHeading {
+            color: #2047f5;
+            background: transparent;
+            padding: 14px 36px;
+            letter-spacing: 2px;
+        }
+        QLabel#statusLabel { color: white; background: transparent; font-size: 16px; }
+        QLabel#bottomBar { background-color: #2047f5; border-radius: 5px; }
+        QLabel#ball { background-color: #f54291; border-radius: 10px; }
+
+        QPushButton[menuStyle="main"] {
+            background-color: rgba(255, 59, 59, 180);
+            color: white;
+            padding: 14px 34px;
+            border: none;
+            border-radius: 8px;
+            font-size: 18px;
+            font-weight: bold;
+        }
+        QPushButton[menuStyle="main"]:hover { background-color: rgba(213, 0, 0, 200); }
+        QPushButton[menuStyle="main"]:disabled { background-color: rgba(120, 120, 120, 160); }
+
+        QLabel#studentTitle, QLabel#facultyTitle {
+            font-family: 'Georgia';
+            font-weight: bold;
+            color: white;
+            background: transparent;
+        }
+        QLabel#studentTitle { font-size: 50px; }
+        QLabel#facultyTitle { font-size: 48px; }
+        QLabel#adminHeader { color: white; background: transparent; }
+
+        QPushButton[menuStyle="round"] {
+            border-radius: 75px;
+            background-color: rgba(32, 71, 245, 200);
+            color: white;
+            font-size: 15px;
+            font-family: 'Arial Black', 'Arial', sans-serif;
+        }
+        QPushButton[menuStyle="round"]:hover { background-color: rgba(0, 46, 207, 200); }
+
+        QPushButton[menuStyle="wide"] {
+            background-color: rgba(32, 71, 245, 200);
+            color: white;
+            border: none;
+            border-radius: 15px;
+            min-width: 340px;
+            min-height: 48px;
+            font-size: 15px;
+            font-family: 'Arial Black', 'Arial', sans-serif;
+            font-weight: bold;
+        }
+        QPushButton[menuStyle="wide"]:hover { background-color: rgba(0, 46, 207, 200); font-weight: bold; }
+
+        QPushButton[menuStyle="admin"] {
+            background-color: rgba(32, 71, 245, 200);
+            color: white;
+            border: none;
+            border-radius: 15px;
+            padding: 12px 20px;
+            min-width: 220px;
+            min-height: 45px;
+            font-size: 15px;
+            margin: 5px;
+        }
+        QPushButton[menuStyle="admin"]:hover { background-color: rgba(0, 46, 207, 200); font-weight: bold; }
+    )");
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <QString>
+
+// The single stylesheet installed on QApplication. Widgets opt in through
+// their objectName or the "menuStyle" dynamic property instead of carrying
+// their own setStyleSheet() strings, so Qt parses the rules once per process.
+QString appStyleSheet();
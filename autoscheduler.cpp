@@ -0,0 +1,55 @@
+#include "autoscheduler.h"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace {
+
+struct FreeSlot {
+    int timeslot_id;
+    std::string label;
+    std::vector<std::pair<std::string, std::string>> rooms;
+    std::vector<std::pair<int, std::string>> faculty;
+    int placed = 0;
+};
+
+}
+
+SchedulePlan AutoScheduler::plan()
+{
+    SchedulePlan plan;
+    std::vector<FreeSlot> slots;
+    for (const auto& ts : db.getAllTimeslots())
+        slots.push_back({ts.first, ts.second, db.getAvailableRooms(ts.first), db.getAvailableFaculty(ts.first)});
+    std::map<int, int> load;    // faculty_id -> sections placed in this run
+
+    auto courses = db.getUnscheduledCourses();
+    std::sort(courses.begin(), courses.end());
+    for (const auto& course : courses) {
+        FreeSlot* best = nullptr;
+        for (auto& slot : slots)
+            if (!slot.rooms.empty() && !slot.faculty.empty() && (!best || slot.placed < best->placed))
+                best = &slot;
+        if (!best) {
+            plan.unplaced.push_back(course.first);
+            continue;
+        }
+        auto teacher = std::min_element(best->faculty.begin(), best->faculty.end(),
+            [&](const auto& a, const auto& b) { return load[a.first] < load[b.first]; });
+        plan.sections.push_back({course.first, course.second, teacher->first, teacher->second,
+                                 best->timeslot_id, best->label, best->rooms.front().first, best->rooms.front().second});
+        ++load[teacher->first];
+        ++best->placed;
+        best->faculty.erase(teacher);
+        best->rooms.erase(best->rooms.begin());
+    }
+    return plan;
+}
+
+void AutoScheduler::apply(const SchedulePlan& plan)
+{
+    Database::Transaction tx(db);
+    for (const auto& s : plan.sections)
+        tx.addCourseSchedule(s.course_code, s.faculty_id, s.timeslot_id, s.room_id);
+    tx.commit();
+}
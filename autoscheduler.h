@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "database.h"
+
+struct PlannedSection {
+    std::string course_code, course_name;
+    int faculty_id;
+    std::string faculty_name;
+    int timeslot_id;
+    std::string timeslot;
+    std::string room_id, room;
+};
+
+struct SchedulePlan {
+    std::vector<PlannedSection> sections;
+    std::vector<std::string> unplaced;      // course codes with no free slot
+};
+
+// Assigns every course that has no section yet to a timeslot, room and
+// faculty member that are still free. Courses are spread over the timeslots
+// and the faculty with the fewest sections placed so far in this run. Free
+// rooms and faculty are read once per timeslot and then tracked in memory,
+// and the plan is written in one Transaction.
+class AutoScheduler {
+    Database& db;
+
+public:
+    explicit AutoScheduler(Database& db) : db(db) {}
+
+    SchedulePlan plan();
+    void apply(const SchedulePlan& plan);
+};
@@ -0,0 +1,469 @@
+// Non-interactive front end for the jobs the admin menu runs one dialog at a
+// time, for cron and scripts:
+//
+//   cms_cli import KIND=FILE...                students/faculty/courses, one
+//                                              connection and transaction per
+//                                              file, all files in parallel
+//   cms_cli export DIR [--format csv|ics|json] [--threads N]
+//   cms_cli schedule [--dry-run]               place unscheduled courses
+//   cms_cli grades DIR [--threads N]           one grade sheet per course
+//   cms_cli stats [--threads N]                mark statistics per course and
+//                                              department
+//   cms_cli results [--full] [--policy FILE] [--threads N]
+//                                              grade the marks changed since
+//                                              the last run, or all of them,
+//                                              into course_results
+//   cms_cli exams [--slots N] [--per-day N] [--seconds S] [--threads N]
+//                                              clash-free final exam timetable
+//                                              with rooms from enrollments
+//   cms_cli search QUERY [--kind students|faculty|courses] [--limit N]
+//                                              type-ahead lookup by id, name,
+//                                              email or course code
+//   cms_cli term [start NAME | close ID | archive ID]
+//                                              list terms, open a new current
+//                                              term, stop enrollment in one,
+//                                              or move a closed one into the
+//                                              archive tables
+//   cms_cli transcript STUDENT [--term ID]     published results, or the
+//                                              student's marks in one term
+//   cms_cli replicas                           check that every replica serves
+//                                              a write made just before
+//   cms_cli maintain                           refresh table statistics
+//   cms_cli migrate                            apply the schema changes this
+//                                              build needs; run once after
+//                                              upgrading, before the others
+//
+// Connection settings come from CMS_DB_HOST / CMS_DB_PORT / CMS_DB_USER /
+// CMS_DB_PASSWORD / CMS_DB_NAME; reads go to the replicas listed in
+// CMS_DB_REPLICAS (host:port,...) when it is set. Exits 0 on success, 1 when a
+// job failed and 2 on a usage error.
+
+#include "autoscheduler.h"
+#include "database.h"
+#include "examscheduler.h"
+#include "gradereport.h"
+#include "grading.h"
+#include "markstats.h"
+#include "records.h"
+#include "searchindex.h"
+#include "timetableexport.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const usage =
+    "usage: cms_cli import KIND=FILE...            (KIND: students, faculty, courses)\n"
+    "       cms_cli export DIR [--format csv|ics|json] [--threads N]\n"
+    "       cms_cli schedule [--dry-run]\n"
+    "       cms_cli grades DIR [--threads N]\n"
+    "       cms_cli stats [--threads N]\n"
+    "       cms_cli results [--full] [--policy FILE] [--threads N]\n"
+    "       cms_cli exams [--slots N] [--per-day N] [--seconds S] [--threads N]\n"
+    "       cms_cli search QUERY [--kind students|faculty|courses] [--limit N]\n"
+    "       cms_cli term [start NAME | close ID | archive ID]\n"
+    "       cms_cli transcript STUDENT [--term ID]\n"
+    "       cms_cli replicas\n"
+    "       cms_cli maintain\n"
+    "       cms_cli migrate\n";
+
+struct UsageError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct Arguments {
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> options;
+
+    Arguments(int argc, char** argv, int first, std::initializer_list<const char*> valued) {
+        for (int i = first; i < argc; ++i) {
+            if (std::strncmp(argv[i], "--", 2)) {
+                positional.push_back(argv[i]);
+                continue;
+            }
+            const std::string name = argv[i];
+            bool takesValue = false;
+            for (const char* v : valued)
+                takesValue |= name == v;
+            if (takesValue && i + 1 >= argc)
+                throw UsageError(name + " needs a value");
+            options[name] = takesValue ? argv[++i] : "";
+        }
+    }
+
+    bool has(const char* name) const { return options.count(name) > 0; }
+    std::string value(const char* name, const std::string& fallback) const {
+        auto it = options.find(name);
+        return it == options.end() ? fallback : it->second;
+    }
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runImport(const DatabaseConfig& config, const Arguments& args) {
+    struct Job {
+        RecordKind kind;
+        std::string path;
+        std::size_t rows = 0;
+        std::string error;
+    };
+    std::vector<Job> jobs;
+    for (const auto& arg : args.positional) {
+        auto eq = arg.find('=');
+        std::string kind = arg.substr(0, eq);
+        if (eq == std::string::npos)
+            throw UsageError("expected KIND=FILE, got " + arg);
+        Job job;
+        if (kind == "students") job.kind = RecordKind::Students;
+        else if (kind == "faculty") job.kind = RecordKind::Faculty;
+        else if (kind == "courses") job.kind = RecordKind::Courses;
+        else throw UsageError("unknown import kind " + kind);
+        job.path = arg.substr(eq + 1);
+        jobs.push_back(std::move(job));
+    }
+    if (jobs.empty())
+        throw UsageError("nothing to import");
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (auto& job : jobs) {
+        pool.emplace_back([&config, &job]() {
+            try {
+                auto records = readRecords(job.path);
+                if (records.empty())
+                    throw std::runtime_error("no rows found");
+                Database db(config);
+                Database::Transaction tx(db);
+                stageRecords(tx, job.kind, records);
+                tx.commit();
+                job.rows = records.size();
+            }
+            catch (const std::exception& e) {
+                job.error = e.what();
+            }
+        });
+    }
+    for (auto& t : pool)
+        t.join();
+
+    int status = 0;
+    for (const auto& job : jobs) {
+        if (job.error.empty()) {
+            std::printf("%s: imported %zu rows\n", job.path.c_str(), job.rows);
+        } else {
+            std::printf("%s: failed, nothing was changed: %s\n", job.path.c_str(), job.error.c_str());
+            status = 1;
+        }
+    }
+    std::printf("%.2f s\n", secondsSince(started));
+    return status;
+}
+
+int runExport(Database& db, const Arguments& args) {
+    if (args.positional.size() != 1)
+        throw UsageError("export needs one output directory");
+    TimetableExportOptions options;
+    options.directory = args.positional.front();
+    options.threads = static_cast<unsigned>(std::atoi(args.value("--threads", "0").c_str()));
+    std::string format = args.value("--format", "csv");
+    if (format == "csv") options.format = TimetableFormat::Csv;
+    else if (format == "ics") options.format = TimetableFormat::ICalendar;
+    else if (format == "json") options.format = TimetableFormat::Json;
+    else throw UsageError("unknown format " + format);
+
+    TimetableExportSummary summary = TimetableExporter(db).exportAll(options);
+    std::printf("Exported %zu timetables (%zu rows) in %.2f s to %s\n", summary.files, summary.rows, summary.seconds,
+                options.directory.c_str());
+    for (const auto& error : summary.errors)
+        std::printf("  %s\n", error.c_str());
+    return summary.errors.empty() ? 0 : 1;
+}
+
+int runSchedule(Database& db, const Arguments& args) {
+    AutoScheduler scheduler(db);
+    SchedulePlan plan = scheduler.plan();
+    for (const auto& s : plan.sections)
+        std::printf("%-10s %-32s %-20s %-24s %s\n", s.course_code.c_str(), s.course_name.c_str(), s.timeslot.c_str(),
+                    s.faculty_name.c_str(), s.room.c_str());
+    for (const auto& code : plan.unplaced)
+        std::printf("%-10s no free timeslot, room and faculty\n", code.c_str());
+    if (args.has("--dry-run")) {
+        std::printf("%zu sections planned, nothing written (--dry-run)\n", plan.sections.size());
+    } else if (!plan.sections.empty()) {
+        scheduler.apply(plan);
+        std::printf("%zu sections scheduled\n", plan.sections.size());
+    }
+    return plan.unplaced.empty() ? 0 : 1;
+}
+
+int runGrades(Database& db, const Arguments& args) {
+    if (args.positional.size() != 1)
+        throw UsageError("grades needs one output directory");
+    GradeReportOptions options;
+    options.directory = args.positional.front();
+    options.threads = static_cast<unsigned>(std::atoi(args.value("--threads", "0").c_str()));
+
+    GradeReportSummary summary = GradeReporter(db).writeAll(options);
+    std::printf("Wrote %zu grade sheets (%zu marks) in %.2f s to %s\n", summary.files, summary.marks, summary.seconds,
+                options.directory.c_str());
+    for (const auto& error : summary.errors)
+        std::printf("  %s\n", error.c_str());
+    return summary.errors.empty() ? 0 : 1;
+}
+
+void printStats(const char* name, std::size_t groups, const MarkStats& s) {
+    std::printf("%-12s %7zu %8zu %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f\n", name, groups, s.count, s.mean, s.median,
+                s.stddev, s.p10, s.p90, s.min, s.max);
+}
+
+int runStats(Database& db, const Arguments& args) {
+    if (!args.positional.empty())
+        throw UsageError("stats takes no arguments");
+    auto started = std::chrono::steady_clock::now();
+    MarksColumns marks;
+    marks.loadAll(db);
+    const double loaded = secondsSince(started);
+    MarksSummary summary = marks.summarize(static_cast<unsigned>(std::atoi(args.value("--threads", "0").c_str())));
+
+    const char* header = "%-12s %7s %8s %7s %7s %7s %7s %7s %7s %7s\n";
+    std::printf(header, "Course", "Tasks", "Students", "Mean", "Median", "StdDev", "P10", "P90", "Min", "Max");
+    for (const auto& course : summary.courses)
+        printStats(course.course_code.c_str(), course.assignments.size(), course.overall);
+    std::printf("\n");
+    std::printf(header, "Department", "Courses", "Grades", "Mean", "Median", "StdDev", "P10", "P90", "Min", "Max");
+    for (const auto& department : summary.departments)
+        printStats(department.department.c_str(), department.courses, department.overall);
+    std::printf("\nLoaded in %.2f s, summarized in %.3f s\n", loaded, summary.seconds);
+    return 0;
+}
+
+int runResults(Database& db, const Arguments& args) {
+    if (!args.positional.empty())
+        throw UsageError("results takes no arguments");
+    GradingPolicy policy = args.has("--policy") ? GradingPolicy::fromFile(args.value("--policy", ""))
+                                                : GradingPolicy::standard();
+    GradingRunSummary summary = GradingEngine(db, std::move(policy))
+                                    .run(args.has("--full"), static_cast<unsigned>(std::atoi(args.value("--threads", "0").c_str())));
+    std::printf("%s run: graded %zu student courses from %zu marks in %.2f s\n", summary.full ? "Full" : "Incremental",
+                summary.results, summary.marks, summary.seconds);
+    return 0;
+}
+
+int runExams(Database& db, const Arguments& args) {
+    if (!args.positional.empty())
+        throw UsageError("exams takes no arguments");
+    ExamOptions options;
+    options.slots = std::atoi(args.value("--slots", "0").c_str());
+    options.slotsPerDay = std::atoi(args.value("--per-day", "0").c_str());
+    options.seconds = std::atof(args.value("--seconds", "2").c_str());
+    options.threads = static_cast<unsigned>(std::atoi(args.value("--threads", "0").c_str()));
+
+    ExamTimetable timetable = ExamScheduler(db).plan(options);
+    for (std::size_t s = 0; s < timetable.slots.size(); ++s) {
+        if (options.slotsPerDay > 0 && s % options.slotsPerDay == 0)
+            std::printf("Day %zu\n", s / options.slotsPerDay + 1);
+        for (const auto& sitting : timetable.slots[s]) {
+            std::string rooms;
+            for (const auto& room : sitting.rooms)
+                rooms += (rooms.empty() ? "" : ", ") + room;
+            std::printf("  Slot %-4zu %-10s %5d  %s\n", s + 1, sitting.course_code.c_str(), sitting.students, rooms.c_str());
+        }
+    }
+    for (const auto& code : timetable.unplaced)
+        std::printf("%-10s more students than all rooms seat\n", code.c_str());
+    std::printf("%zu courses, %zu students, %zu conflicting pairs: %zu slots, %zu back-to-back exams (%zu students), "
+                "%zu clashes\n",
+                timetable.courses, timetable.students, timetable.conflicts, timetable.slots.size(), timetable.backToBack,
+                timetable.backToBackStudents, timetable.clashes);
+    std::printf("Loaded in %.2f s, %zu search runs in %.2f s\n", timetable.loadSeconds, timetable.runs,
+                timetable.solveSeconds);
+    if (options.slots > 0 && timetable.slots.size() > static_cast<std::size_t>(options.slots))
+        std::printf("Needs %zu slots, more than --slots %d\n", timetable.slots.size(), options.slots);
+    return timetable.unplaced.empty() && (options.slots <= 0 || timetable.slots.size() <= static_cast<std::size_t>(options.slots))
+               ? 0 : 1;
+}
+
+int runSearch(Database& db, const Arguments& args) {
+    if (args.positional.empty())
+        throw UsageError("search needs a query");
+    std::string query;
+    for (const auto& word : args.positional)
+        query += (query.empty() ? "" : " ") + word;
+    std::optional<SearchKind> kind;
+    const std::string kindName = args.value("--kind", "");
+    if (kindName == "students") kind = SearchKind::Student;
+    else if (kindName == "faculty") kind = SearchKind::Faculty;
+    else if (kindName == "courses") kind = SearchKind::Course;
+    else if (!kindName.empty()) throw UsageError("unknown kind " + kindName);
+    const int limit = std::atoi(args.value("--limit", "20").c_str());
+    if (limit <= 0)
+        throw UsageError("--limit must be positive");
+
+    auto started = std::chrono::steady_clock::now();
+    SearchIndex index(db);
+    index.refresh();
+    const double built = secondsSince(started);
+    started = std::chrono::steady_clock::now();
+    auto hits = index.find(query, static_cast<std::size_t>(limit), kind);
+    const double searched = secondsSince(started);
+    for (const auto& hit : hits)
+        std::printf("%s\n", hit.label.c_str());
+    std::printf("%zu hits among %zu records; indexed in %.2f s, searched in %.3f ms\n", hits.size(), index.size(),
+                built, searched * 1000.0);
+    return 0;
+}
+
+int runTerm(Database& db, const Arguments& args) {
+    if (args.positional.empty()) {
+        const int current = db.currentTerm();
+        for (const auto& term : db.getTerms())
+            std::printf("%4d  %-24s %-8s%s\n", term.term_id, term.name.c_str(), term.state.c_str(),
+                        term.term_id == current ? "  current" : "");
+        return 0;
+    }
+    if (args.positional.size() != 2)
+        throw UsageError("term takes an action and its argument");
+    const std::string& action = args.positional[0];
+    if (action == "start") {
+        std::printf("Started term %d\n", db.startTerm(args.positional[1]));
+        return 0;
+    }
+    const int term_id = std::atoi(args.positional[1].c_str());
+    if (action == "close") {
+        if (!db.closeTerm(term_id)) {
+            std::fprintf(stderr, "Term %d is not open\n", term_id);
+            return 1;
+        }
+        std::printf("Closed term %d\n", term_id);
+        return 0;
+    }
+    if (action == "archive") {
+        TermArchiveSummary summary = db.archiveTerm(term_id);
+        std::printf("Archived term %d: %zu sections, %zu enrollments, %zu marks in %.2f s\n", term_id,
+                    summary.sections, summary.enrollments, summary.marks, summary.seconds);
+        return 0;
+    }
+    throw UsageError("unknown term action " + action);
+}
+
+int runTranscript(Database& db, const Arguments& args) {
+    if (args.positional.size() != 1)
+        throw UsageError("transcript needs a student id");
+    const std::string& student = args.positional[0];
+    if (args.has("--term")) {
+        for (const auto& m : db.getStudentTermMarks(student, std::atoi(args.value("--term", "0").c_str())))
+            std::printf("%-10s %-32s %4d / %d\n", m.course_code.c_str(), m.assignment_name.c_str(), m.obtained_marks,
+                        m.total_marks);
+        return 0;
+    }
+    Transcript transcript = Transcript::of(db.getCourseResults(student));
+    std::size_t next = 0;
+    for (const auto& term : transcript.semesters) {
+        std::printf("Semester %d\n", term.semester);
+        for (; next < transcript.courses.size() && transcript.courses[next].semester == term.semester; ++next) {
+            const auto& c = transcript.courses[next];
+            std::printf("  %-10s term %-4d %2d cr  %6.2f%%  %-2s  %.2f\n", c.course_code.c_str(), c.term_id, c.credits,
+                        c.percent, c.letter.c_str(), c.points);
+        }
+        std::printf("  GPA %.2f (%d credits)\n", term.gpa, term.credits);
+    }
+    std::printf("CGPA %.2f (%d credits)\n", transcript.cgpa, transcript.credits);
+    return 0;
+}
+
+int runReplicas(Database& db, const Arguments& args) {
+    if (!args.positional.empty())
+        throw UsageError("replicas takes no arguments");
+    auto report = db.checkReplicas();
+    if (report.empty()) {
+        std::printf("No replicas configured; reads go to the primary\n");
+        return 0;
+    }
+    bool ok = true;
+    for (const auto& replica : report) {
+        if (!replica.reachable)
+            std::printf("%-24s unreachable\n", replica.address.c_str());
+        else if (replica.caughtUp)
+            std::printf("%-24s read its write after %.1f ms\n", replica.address.c_str(), replica.seconds * 1000.0);
+        else
+            std::printf("%-24s still behind after %.2f s; reads fall back to the primary\n", replica.address.c_str(),
+                        replica.seconds);
+        ok = ok && replica.caughtUp;
+    }
+    return ok ? 0 : 1;
+}
+
+int runMaintain(Database& db) {
+    auto started = std::chrono::steady_clock::now();
+    for (const auto& line : db.analyzeTables())
+        std::printf("%s\n", line.c_str());
+    std::printf("%.2f s\n", secondsSince(started));
+    return 0;
+}
+
+int runMigrate(const DatabaseConfig& config) {
+    const int from = Database::migrate(config);
+    if (from == Database::schemaVersion)
+        std::printf("Schema already at version %d\n", from);
+    else
+        std::printf("Schema migrated from version %d to %d\n", from, Database::schemaVersion);
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << usage;
+        return 2;
+    }
+    const std::string command = argv[1];
+    const DatabaseConfig config = DatabaseConfig::fromEnvironment(DatabaseConfig());
+    try {
+        Arguments args(argc, argv, 2, {"--format", "--threads", "--policy", "--kind", "--limit", "--slots",
+                                        "--per-day", "--seconds", "--term"});
+        if (command == "import")
+            return runImport(config, args);
+        if (command == "migrate")
+            return runMigrate(config);
+
+        std::unique_ptr<Database> db;
+        if (command == "export" || command == "schedule" || command == "grades" || command == "stats" ||
+            command == "results" || command == "exams" || command == "search" || command == "term" ||
+            command == "transcript" || command == "replicas" || command == "maintain")
+            db = std::make_unique<Database>(config);
+        if (command == "export") return runExport(*db, args);
+        if (command == "schedule") return runSchedule(*db, args);
+        if (command == "grades") return runGrades(*db, args);
+        if (command == "stats") return runStats(*db, args);
+        if (command == "results") return runResults(*db, args);
+        if (command == "exams") return runExams(*db, args);
+        if (command == "search") return runSearch(*db, args);
+        if (command == "term") return runTerm(*db, args);
+        if (command == "transcript") return runTranscript(*db, args);
+        if (command == "replicas") return runReplicas(*db, args);
+        if (command == "maintain") return runMaintain(*db);
+        throw UsageError("unknown command " + command);
+    }
+    catch (const UsageError& e) {
+        std::cerr << e.what() << "\n" << usage;
+        return 2;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,134 +1,767 @@
 #include "database.h"
+#include "querycatalog.h"
+#include "serviceclient.h"
+#include "trace.h"
 #include <stdexcept>
+#include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <sstream>
 
-Database::Database(const std::string& host, const std::string& user, const std::string& pass, const std::string& dbname)
-try : session(mysqlx::SessionOption::HOST, host,
-              mysqlx::SessionOption::PORT, 33060,
-              mysqlx::SessionOption::USER, user,
-              mysqlx::SessionOption::PWD, pass,
-              mysqlx::SessionOption::DB, dbname),
-    db(session.getSchema(dbname))
+template <typename Query, typename... Args>
+std::vector<typename Query::Row> Database::fetchRows(Args&&... args) {
+    std::vector<typename Query::Row> result;
+    mysqlx::SqlStatement stmt = reader().sql(catalog::text<Query>());
+    (stmt.bind(std::forward<Args>(args)), ...);
+    auto res = stmt.execute();
+    result.reserve(res.count());
+    mysqlx::Row row;
+    while ((row = res.fetchOne()))
+        catalog::decode<Query>(result.emplace_back(), row);
+    return result;
+}
+template <typename Query, typename... Args>
+void Database::streamRows(const std::function<void(typename Query::Row&)>& fn, Args&&... args) {
+    mysqlx::SqlStatement stmt = reader().sql(catalog::text<Query>());
+    (stmt.bind(std::forward<Args>(args)), ...);
+    auto res = stmt.execute();
+    mysqlx::Row row;
+    while ((row = res.fetchOne())) {
+        typename Query::Row out;
+        catalog::decode<Query>(out, row);
+        fn(out);
+    }
+}
+
+// Runs fn as a single-statement unit of work: fn writes directly and returns
+// whether it changed anything, and nothing is bumped when it did not.
+template <typename Fn>
+bool Database::mutate(std::initializer_list<ChangeFeed> feeds, Fn&& fn) {
+    Transaction tx(*this);
+    bool changed = fn();
+    if (changed)
+        tx.touch(feeds);
+    tx.commit();
+    return changed;
+}
+
+bool ChangeVersions::changedSince(const ChangeVersions& older, std::initializer_list<ChangeFeed> feeds) const {
+    for (ChangeFeed feed : feeds)
+        if ((*this)[feed] != older[feed])
+            return true;
+    return false;
+}
+
+DatabaseConfig DatabaseConfig::fromEnvironment(DatabaseConfig base) {
+    DatabaseConfig config = std::move(base);
+    if (const char* v = std::getenv("CMS_DB_HOST")) config.host = v;
+    if (const char* v = std::getenv("CMS_DB_PORT")) config.port = std::atoi(v);
+    if (const char* v = std::getenv("CMS_DB_USER")) config.user = v;
+    if (const char* v = std::getenv("CMS_DB_PASSWORD")) config.password = v;
+    if (const char* v = std::getenv("CMS_DB_NAME")) config.schema = v;
+    if (const char* v = std::getenv("CMS_DB_REPLICAS")) {
+        config.replicas.clear();
+        std::istringstream list(v);
+        std::string address;
+        while (std::getline(list, address, ','))
+            if (!address.empty())
+                config.replicas.push_back(address);
+    }
+    if (const char* v = std::getenv("CMS_DB_REPLICA_WAIT")) config.replicaWaitSeconds = std::atof(v);
+    if (const char* v = std::getenv("CMS_TRACE")) config.tracePath = v;
+    if (const char* v = std::getenv("CMS_SERVICE")) config.serviceSocket = v;
+    return config;
+}
+
+namespace {
+
+// Version 1: change feeds, the waitlist, results, terms and the term
+// archive. Schemas from before terms put every existing row in term 1.
+void addTerms(mysqlx::Session& session)
+{
+    session.sql("CREATE TABLE IF NOT EXISTS change_versions ("
+                "feed VARCHAR(32) NOT NULL PRIMARY KEY, "
+                "version BIGINT UNSIGNED NOT NULL DEFAULT 0)").execute();
+    session.sql("CREATE TABLE IF NOT EXISTS waitlist ("
+                "seq BIGINT UNSIGNED NOT NULL AUTO_INCREMENT PRIMARY KEY, "
+                "schedule_id INT NOT NULL, "
+                "student_id VARCHAR(32) NOT NULL, "
+                "UNIQUE KEY (schedule_id, student_id), "
+                "KEY (student_id))").execute();
+    session.sql("CREATE TABLE IF NOT EXISTS results_dirty ("
+                "seq BIGINT UNSIGNED NOT NULL AUTO_INCREMENT PRIMARY KEY, "
+                "student_id VARCHAR(32) NOT NULL, "
+                "course_code VARCHAR(32) NOT NULL)").execute();
+    session.sql("CREATE TABLE IF NOT EXISTS course_results ("
+                "student_id VARCHAR(32) NOT NULL, "
+                "course_code VARCHAR(32) NOT NULL, "
+                "term_id INT NOT NULL DEFAULT 1, "
+                "semester INT NOT NULL, "
+                "credits INT NOT NULL, "
+                "percent DOUBLE NOT NULL, "
+                "letter VARCHAR(4) NOT NULL, "
+                "points DOUBLE NOT NULL, "
+                "PRIMARY KEY (student_id, course_code, term_id))").execute();
+
+    session.sql("CREATE TABLE IF NOT EXISTS terms ("
+                "term_id INT NOT NULL AUTO_INCREMENT PRIMARY KEY, "
+                "name VARCHAR(64) NOT NULL UNIQUE, "
+                "state VARCHAR(16) NOT NULL DEFAULT 'open', "
+                "KEY (state, term_id))").execute();
+    session.sql("INSERT IGNORE INTO terms (term_id, name) VALUES (1, 'Term 1')").execute();
+    std::vector<std::string> termColumns;
+    {
+        auto res = session.sql("SELECT table_name FROM information_schema.columns "
+                               "WHERE table_schema = DATABASE() AND column_name = 'term_id' "
+                               "AND table_name IN ('course_schedule', 'marks', 'course_results', 'current_term')").execute();
+        mysqlx::Row row;
+        while ((row = res.fetchOne()))
+            termColumns.push_back(row[0].get<std::string>());
+    }
+    auto hasTermColumn = [&](const char* table) {
+        return std::find(termColumns.begin(), termColumns.end(), table) != termColumns.end();
+    };
+    if (!hasTermColumn("course_schedule"))
+        session.sql("ALTER TABLE course_schedule ADD COLUMN term_id INT NOT NULL DEFAULT 1, "
+                    "ADD KEY term_timeslot (term_id, timeslot_id)").execute();
+    if (!hasTermColumn("marks"))
+        session.sql("ALTER TABLE marks ADD COLUMN term_id INT NOT NULL DEFAULT 1, ADD KEY term (term_id)").execute();
+    if (!hasTermColumn("course_results"))
+        session.sql("ALTER TABLE course_results ADD COLUMN term_id INT NOT NULL DEFAULT 1 AFTER course_code, "
+                    "DROP PRIMARY KEY, ADD PRIMARY KEY (student_id, course_code, term_id)").execute();
+    // addMarks upserts on (student, course, assignment). That key has to be
+    // per term too, or a retake overwrites the earlier term's marks.
+    {
+        auto res = session.sql("SELECT index_name, MAX(column_name = 'term_id') FROM information_schema.statistics "
+                               "WHERE table_schema = DATABASE() AND table_name = 'marks' AND non_unique = 0 "
+                               "GROUP BY index_name HAVING MAX(column_name = 'assignment_name') = 1").execute();
+        std::vector<std::string> termless;
+        mysqlx::Row row;
+        while ((row = res.fetchOne()))
+            if (row[1].get<int>() == 0)
+                termless.push_back(row[0].get<std::string>());
+        for (const auto& index : termless)
+            session.sql(index == "PRIMARY"
+                            ? "ALTER TABLE marks DROP PRIMARY KEY, "
+                              "ADD PRIMARY KEY (student_id, course_code, assignment_name, term_id)"
+                            : "ALTER TABLE marks DROP INDEX `" + index + "`, "
+                              "ADD UNIQUE KEY `" + index + "` (student_id, course_code, assignment_name, term_id)").execute();
+    }
+    if (!hasTermColumn("current_term"))
+        session.sql("CREATE VIEW current_term AS "
+                    "SELECT MAX(term_id) AS term_id FROM terms WHERE state = 'open'").execute();
+
+    // Filled only by archiveTerm and never updated. Compressed, since each
+    // term is written once and read rarely, and partitioned by term so
+    // reading one term touches one partition.
+    session.sql("CREATE TABLE IF NOT EXISTS course_schedule_archive ("
+                "term_id INT NOT NULL, "
+                "schedule_id INT NOT NULL, "
+                "course_code VARCHAR(32) NOT NULL, "
+                "faculty_id INT NOT NULL, "
+                "timeslot_id INT NOT NULL, "
+                "room_id VARCHAR(32) NOT NULL, "
+                "PRIMARY KEY (term_id, schedule_id)) "
+                "ROW_FORMAT=COMPRESSED PARTITION BY HASH (term_id) PARTITIONS 8").execute();
+    session.sql("CREATE TABLE IF NOT EXISTS enrollments_archive ("
+                "term_id INT NOT NULL, "
+                "schedule_id INT NOT NULL, "
+                "student_id VARCHAR(32) NOT NULL, "
+                "PRIMARY KEY (term_id, schedule_id, student_id), "
+                "KEY (student_id)) "
+                "ROW_FORMAT=COMPRESSED PARTITION BY HASH (term_id) PARTITIONS 8").execute();
+    session.sql("CREATE TABLE IF NOT EXISTS marks_archive ("
+                "term_id INT NOT NULL, "
+                "course_code VARCHAR(32) NOT NULL, "
+                "student_id VARCHAR(32) NOT NULL, "
+                "assignment_name VARCHAR(255) NOT NULL, "
+                "total_marks INT NOT NULL, "
+                "obtained_marks INT NOT NULL, "
+                "PRIMARY KEY (term_id, student_id, course_code, assignment_name)) "
+                "ROW_FORMAT=COMPRESSED PARTITION BY HASH (term_id) PARTITIONS 8").execute();
+}
+
+// Version 2: one enrollment per student and section. Duplicates left by
+// earlier races keep their oldest row.
+void uniqueEnrollments(mysqlx::Session& session)
+{
+    session.sql("DELETE e FROM enrollments e JOIN enrollments k "
+                "ON k.student_id = e.student_id AND k.schedule_id = e.schedule_id "
+                "AND k.enrollment_id < e.enrollment_id").execute();
+    session.sql("ALTER TABLE enrollments ADD UNIQUE KEY student_schedule (student_id, schedule_id)").execute();
+}
+
+// Step n brings the schema from version n to n + 1.
+void (*const migrations[])(mysqlx::Session&) = {
+    addTerms,
+    uniqueEnrollments,
+};
+static_assert(sizeof(migrations) / sizeof(migrations[0]) == Database::schemaVersion,
+              "one migration per schema version");
+
+// 0 for a schema that has never been migrated.
+int storedSchemaVersion(mysqlx::Session& session)
+{
+    auto res = session.sql("SELECT COUNT(*) FROM information_schema.tables "
+                           "WHERE table_schema = DATABASE() AND table_name = 'schema_version'").execute();
+    auto row = res.fetchOne();
+    if (!row || row[0].get<int>() == 0)
+        return 0;
+    row = session.sql("SELECT COALESCE(MAX(version), 0) FROM schema_version").execute().fetchOne();
+    return row ? row[0].get<int>() : 0;
+}
+
+}
+
+int Database::migrate(const DatabaseConfig& config)
 {
+    std::unique_ptr<mysqlx::Session> session;
     try {
-        db = session.getSchema(dbname);
-        if (!db.existsInDatabase()) {
-            throw std::runtime_error("Database " + dbname + " does not exist");
+        session = std::make_unique<mysqlx::Session>(mysqlx::SessionOption::HOST, config.host,
+                                                    mysqlx::SessionOption::PORT, config.port,
+                                                    mysqlx::SessionOption::USER, config.user,
+                                                    mysqlx::SessionOption::PWD, config.password,
+                                                    mysqlx::SessionOption::DB, config.schema);
+    }
+    catch (const mysqlx::Error& err) {
+        throw std::runtime_error("Connection failed: " + std::string(err.what()));
+    }
+    // One migration at a time; a second one waits and then finds nothing
+    // left to do. The lock goes with the session if a step throws.
+    auto lock = session->sql("SELECT GET_LOCK('cms_schema_migration', 600)").execute().fetchOne();
+    if (!lock || lock[0].isNull() || lock[0].get<int>() != 1)
+        throw std::runtime_error("Another migration is still running");
+    session->sql("CREATE TABLE IF NOT EXISTS schema_version ("
+                 "version INT NOT NULL PRIMARY KEY, "
+                 "applied_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP)").execute();
+    const int from = storedSchemaVersion(*session);
+    for (int version = from; version < schemaVersion; ++version) {
+        migrations[version](*session);
+        session->sql("INSERT INTO schema_version (version) VALUES (?)").bind(version + 1).execute();
+    }
+    session->sql("SELECT RELEASE_LOCK('cms_schema_migration')").execute();
+    return from;
+}
+
+Database::Database(const DatabaseConfig& config)
+{
+    if (!config.tracePath.empty() && !TraceWriter::start(config.tracePath))
+        std::cerr << "Cannot open trace file " << config.tracePath << std::endl;
+    if (!config.serviceSocket.empty()) {
+        remote = std::make_unique<ServiceClient>(config.serviceSocket);
+        return;
+    }
+    try {
+        session.emplace(mysqlx::SessionOption::HOST, config.host,
+                        mysqlx::SessionOption::PORT, config.port,
+                        mysqlx::SessionOption::USER, config.user,
+                        mysqlx::SessionOption::PWD, config.password,
+                        mysqlx::SessionOption::DB, config.schema);
+    }
+    catch (const mysqlx::Error& err) {
+        throw std::runtime_error("Connection failed: " + std::string(err.what()));
+    }
+    schemaName = config.schema;
+    try {
+        db.emplace(session->getSchema(config.schema));
+        if (!db->existsInDatabase()) {
+            throw std::runtime_error("Database " + config.schema + " does not exist");
         }
     }
     catch (const mysqlx::Error& err) {
         throw std::runtime_error("Failed to get schema: " + std::string(err.what()));
     }
+    // Schema changes are cms_cli migrate's job; a connection only makes sure
+    // they have been made.
+    const int version = storedSchemaVersion(*session);
+    if (version < schemaVersion)
+        throw std::runtime_error("Database " + config.schema + " is at schema version " + std::to_string(version) +
+                                 ", this build needs " + std::to_string(schemaVersion) + "; run cms_cli migrate");
+
+    // An unreachable replica is left out rather than failing the start;
+    // checkReplicas reports it. Without GTIDs there is no way to tell that a
+    // replica has this process's writes, so then none are used.
+    replicaWait = config.replicaWaitSeconds;
+    std::vector<std::string> replicaAddresses = config.replicas;
+    if (!replicaAddresses.empty()) {
+        auto res = session->sql("SELECT @@GLOBAL.gtid_mode").execute();
+        auto row = res.fetchOne();
+        const std::string mode = row ? row[0].get<std::string>() : std::string();
+        if (mode != "ON") {
+            std::cerr << "gtid_mode is " << (mode.empty() ? "unknown" : mode)
+                      << " on the primary; reading from the primary only" << std::endl;
+            replicaAddresses.clear();
+        }
+    }
+    for (const auto& address : replicaAddresses) {
+        Replica& replica = replicas.emplace_back();
+        replica.address = address;
+        const auto colon = address.rfind(':');
+        try {
+            replica.session = std::make_unique<mysqlx::Session>(
+                mysqlx::SessionOption::HOST, address.substr(0, colon),
+                mysqlx::SessionOption::PORT, colon == std::string::npos ? config.port : std::atoi(address.c_str() + colon + 1),
+                mysqlx::SessionOption::USER, config.user,
+                mysqlx::SessionOption::PWD, config.password,
+                mysqlx::SessionOption::DB, config.schema);
+        }
+        catch (const mysqlx::Error& err) {
+            std::cerr << "Replica " << address << " unavailable: " << err.what() << std::endl;
+        }
+    }
+    advanceReadFloor();
+}
+
+static DatabaseConfig configFor(const std::string& host, const std::string& user, const std::string& pass, const std::string& dbname) {
+    DatabaseConfig config;
+    config.host = host;
+    config.user = user;
+    config.password = pass;
+    config.schema = dbname;
+    return config;
 }
-catch (const mysqlx::Error& err) {
-    throw std::runtime_error("Connection failed: " + std::string(err.what()));
+
+Database::Database(const std::string& host, const std::string& user, const std::string& pass, const std::string& dbname)
+    : Database(configFor(host, user, pass, dbname))
+{
 }
 
 Database::~Database() {
-    try { session.close(); } catch (...) {}
+    for (auto& replica : replicas)
+        if (replica.session)
+            try { replica.session->close(); } catch (...) {}
+    if (session)
+        try { session->close(); } catch (...) {}
+}
+
+// The pinned snapshot when one is open; the primary inside a transaction or
+// without replicas; else the next reachable replica, once it has applied
+// the read floor. A replica that does not get there within replicaWait, or
+// fails, leaves the read to the primary.
+mysqlx::Session& Database::reader() {
+    if (pinned)
+        return *pinned;
+    if (transactionDepth > 0 || replicas.empty())
+        return *session;
+    std::string floor;
+    {
+        std::lock_guard<std::mutex> lock(readFloor->mutex);
+        floor = readFloor->gtids;
+    }
+    for (std::size_t tried = 0; tried < replicas.size(); ++tried) {
+        Replica& replica = replicas[nextReplica++ % replicas.size()];
+        if (!replica.session)
+            continue;
+        if (replica.applied == floor)
+            return *replica.session;
+        const auto now = std::chrono::steady_clock::now();
+        if (now < replica.laggingUntil)
+            continue;
+        try {
+            auto res = replica.session->sql("SELECT WAIT_FOR_EXECUTED_GTID_SET(?, ?)").bind(floor, replicaWait).execute();
+            auto row = res.fetchOne();
+            if (row && row[0].get<int>() == 0) {
+                replica.applied = floor;
+                return *replica.session;
+            }
+        }
+        catch (const mysqlx::Error&) {
+        }
+        // Later reads go straight to the primary instead of each waiting
+        // out the timeout again.
+        replica.laggingUntil = now + laggingBackoff;
+        break;
+    }
+    return *session;
+}
+mysqlx::Table Database::readTable(const char* name) {
+    return reader().getSchema(schemaName).getTable(name);
+}
+// Called after a write commits, and before reads that must not be older
+// than something just read on the primary.
+void Database::advanceReadFloor() {
+    if (replicas.empty())
+        return;
+    std::lock_guard<std::mutex> lock(readFloor->mutex);
+    auto res = session->sql("SELECT @@GLOBAL.gtid_executed").execute();
+    if (auto row = res.fetchOne())
+        readFloor->gtids = row[0].get<std::string>();
+}
+
+std::vector<Database::ReplicaStatus> Database::checkReplicas() {
+    std::vector<ReplicaStatus> report;
+    session->sql("INSERT INTO change_versions (feed, version) VALUES ('replica_probe', 1) "
+                 "ON DUPLICATE KEY UPDATE version = version + 1").execute();
+    std::uint64_t written = 0;
+    {
+        auto res = session->sql("SELECT version FROM change_versions WHERE feed = 'replica_probe'").execute();
+        if (auto row = res.fetchOne())
+            written = row[0].get<std::uint64_t>();
+    }
+    advanceReadFloor();
+    for (std::size_t i = 0; i < replicas.size(); ++i) {
+        ReplicaStatus status;
+        status.address = replicas[i].address;
+        status.reachable = replicas[i].session != nullptr;
+        if (status.reachable) {
+            auto started = std::chrono::steady_clock::now();
+            try {
+                nextReplica = i;
+                replicas[i].laggingUntil = {};
+                mysqlx::Session& read = reader();
+                auto res = read.sql("SELECT version FROM change_versions WHERE feed = 'replica_probe'").execute();
+                auto row = res.fetchOne();
+                status.caughtUp = &read == replicas[i].session.get() && row && row[0].get<std::uint64_t>() == written;
+            }
+            catch (const mysqlx::Error&) {
+            }
+            status.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        }
+        report.push_back(status);
+    }
+    return report;
+}
+
+void Database::setQueueListener(std::function<void(std::size_t position, std::size_t depth)> listener) {
+    if (remote)
+        remote->setQueueListener(std::move(listener));
+}
+
+// Runs the statements behind login and the first menu screen once so the
+// server has the tables open and their index pages cached, and fills the
+// timeslot reference cache.
+void Database::warmUp() {
+    if (remote)
+        return;
+    session->sql("SELECT 1").execute();
+    studentExists("");
+    facultyExists("");
+    getAvailableScheduledCourses(0, "");
+    getEnrolledCourses("");
+    getFacultyTimetable(0);
+    getAllTimeslots();
+}
+
+std::vector<std::string> Database::analyzeTables() {
+    std::vector<std::string> report;
+    auto res = session->sql("ANALYZE TABLE students, faculty, courses, classrooms, timeslots, "
+                           "course_schedule, enrollments, waitlist, marks, course_results, terms, change_versions").execute();
+    mysqlx::Row row;
+    while ((row = res.fetchOne()))
+        report.push_back(row[0].get<std::string>() + ": " + row[3].get<std::string>());
+    return report;
+}
+
+const char* Database::feedName(ChangeFeed feed) {
+    static const char* names[] = {"students", "faculty", "courses", "classrooms", "timeslots", "schedule", "enrollments", "marks", "waitlist", "results", "terms"};
+    return names[static_cast<std::size_t>(feed)];
+}
+ChangeVersions Database::changeVersions() {
+    TraceScope trace(TraceMethod::ChangeVersions);
+    if (remote) return remote->call<ChangeVersions>(TraceMethod::ChangeVersions);
+    ChangeVersions versions;
+    // Outside a snapshot the versions come from the primary and the read
+    // floor moves past them, so the slices a caller reads next are at least
+    // as new as the versions it will remember for them.
+    auto res = (pinned ? *pinned : *session).sql("SELECT feed, version FROM change_versions").execute();
+    mysqlx::Row row;
+    while ((row = res.fetchOne())) {
+        std::string feed = row[0].get<std::string>();
+        for (std::size_t i = 0; i < versions.version.size(); ++i)
+            if (feed == feedName(static_cast<ChangeFeed>(i)))
+                versions.version[i] = row[1].get<std::uint64_t>();
+    }
+    if (!pinned)
+        advanceReadFloor();
+    return versions;
+}
+void Database::bumpVersions(const std::vector<ChangeFeed>& feeds) {
+    std::string query = "INSERT INTO change_versions (feed, version) VALUES ";
+    bool first = true;
+    for (ChangeFeed feed : feeds) {
+        query += first ? "('" : ", ('";
+        query += feedName(feed);
+        query += "', 1)";
+        first = false;
+    }
+    query += " ON DUPLICATE KEY UPDATE version = version + 1";
+    session->sql(query).execute();
+}
+
+namespace {
+
+std::string placeholders(std::size_t count) {
+    std::string out = "(";
+    for (std::size_t i = 0; i < count; ++i)
+        out += i ? ", ?" : "?";
+    return out + ")";
+}
+
+}
+
+void Database::insertRows(const char* table, std::initializer_list<const char*> columns, const Rows& rows) {
+    std::string head = std::string("INSERT INTO ") + table + " (";
+    bool first = true;
+    for (const char* column : columns) {
+        if (!first) head += ", ";
+        head += column;
+        first = false;
+    }
+    head += ") VALUES ";
+    const std::string tuple = placeholders(columns.size());
+    for (std::size_t begin = 0; begin < rows.size(); begin += batchRows) {
+        const std::size_t end = std::min(rows.size(), begin + batchRows);
+        std::string query = head;
+        for (std::size_t i = begin; i < end; ++i)
+            query += i == begin ? tuple : ", " + tuple;
+        mysqlx::SqlStatement stmt = session->sql(query);
+        for (std::size_t i = begin; i < end; ++i)
+            for (const auto& value : rows[i])
+                stmt.bind(value);
+        stmt.execute();
+    }
+}
+void Database::deleteWhereIn(const char* table, const char* column, const std::vector<mysqlx::Value>& keys) {
+    for (std::size_t begin = 0; begin < keys.size(); begin += batchRows) {
+        const std::size_t end = std::min(keys.size(), begin + batchRows);
+        mysqlx::SqlStatement stmt = session->sql(std::string("DELETE FROM ") + table + " WHERE " + column + " IN " + placeholders(end - begin));
+        for (std::size_t i = begin; i < end; ++i)
+            stmt.bind(keys[i]);
+        stmt.execute();
+    }
+}
+
+Database::Transaction::Transaction(Database& db)
+    : db(db), outer(db.transactionDepth == 0)
+{
+    if (outer) {
+        db.session->startTransaction();
+        db.rollbackOnly = false;
+    }
+    ++db.transactionDepth;
+}
+Database::Transaction::~Transaction() {
+    if (!done)
+        abandon();
+}
+void Database::Transaction::abandon() {
+    done = true;
+    --db.transactionDepth;
+    if (outer) {
+        try { db.session->rollback(); } catch (...) {}
+    } else {
+        db.rollbackOnly = true;
+    }
+}
+void Database::Transaction::touch(std::initializer_list<ChangeFeed> feeds) {
+    for (ChangeFeed feed : feeds)
+        touched[static_cast<std::size_t>(feed)] = true;
+}
+std::size_t Database::Transaction::pending() const {
+    return students.size() + faculty.size() + courses.size() + schedules.size()
+           + removedStudents.size() + removedFaculty.size() + removedCourses.size() + removedSchedules.size();
+}
+
+void Database::Transaction::addStudent(const std::string& id, const std::string& fname, const std::string& lname, const std::string& email, const std::string& degree, int semester, const std::string& password) {
+    students.push_back({id, fname, lname, email, degree, semester, password.empty() ? "bnu" : password});
+    touch({ChangeFeed::Students});
+}
+void Database::Transaction::removeStudent(const std::string& id) {
+    removedStudents.emplace_back(id);
+    touch({ChangeFeed::Students, ChangeFeed::Enrollments, ChangeFeed::Marks, ChangeFeed::Results});
+}
+void Database::Transaction::addFaculty(int faculty_id, const std::string& fname, const std::string& lname, const std::string& email, const std::string& degree, const std::string& qualification, const std::string& expertise_sub, const std::string& designation, const std::string& password) {
+    faculty.push_back({faculty_id, fname, lname, email, degree, qualification, expertise_sub, designation, password.empty() ? "faculty_scit" : password});
+    touch({ChangeFeed::Faculty});
+}
+void Database::Transaction::removeFaculty(int faculty_id) {
+    removedFaculty.emplace_back(faculty_id);
+    touch({ChangeFeed::Faculty, ChangeFeed::Schedule, ChangeFeed::Enrollments});
+}
+void Database::Transaction::addCourse(const std::string& code, const std::string& name, int credits, int sem, const std::string& dept, int max, const std::string& prereq) {
+    courses.push_back({code, name, credits, sem, dept, max, prereq});
+    touch({ChangeFeed::Courses});
+}
+void Database::Transaction::removeCourse(const std::string& code) {
+    removedCourses.emplace_back(code);
+    touch({ChangeFeed::Courses, ChangeFeed::Schedule, ChangeFeed::Enrollments, ChangeFeed::Marks, ChangeFeed::Results});
+}
+void Database::Transaction::addCourseSchedule(const std::string& course_code, int faculty_id, int timeslot_id, const std::string& room_id) {
+    schedules.push_back({course_code, faculty_id, timeslot_id, room_id});
+    touch({ChangeFeed::Schedule});
+}
+void Database::Transaction::removeCourseSchedule(int schedule_id) {
+    removedSchedules.emplace_back(schedule_id);
+    touch({ChangeFeed::Schedule, ChangeFeed::Enrollments});
+}
+
+// Removals go first so a bulk edit can drop and re-add the same keys;
+// dependents are cleared before the rows they reference.
+void Database::Transaction::flush() {
+    if (!schedules.empty()) {
+        const int term = db.currentTerm();
+        if (!term)
+            throw std::runtime_error("No open term to schedule sections in");
+        for (auto& row : schedules)
+            row.emplace_back(term);
+    }
+    db.removeSectionsWhere("schedule_id", removedSchedules);
+    db.removeSectionsWhere("faculty_id", removedFaculty);
+    db.deleteWhereIn("faculty", "faculty_id", removedFaculty);
+    db.removeSectionsWhere("course_code", removedCourses);
+    db.deleteWhereIn("course_results", "course_code", removedCourses);
+    db.deleteWhereIn("courses", "course_code", removedCourses);
+    db.deleteWhereIn("waitlist", "student_id", removedStudents);
+    db.deleteWhereIn("course_results", "student_id", removedStudents);
+    db.deleteWhereIn("students", "student_id", removedStudents);
+
+    db.insertRows("students", {"student_id", "first_name", "last_name", "email", "degree", "semester", "password"}, students);
+    db.insertRows("faculty", {"faculty_id", "first_name", "last_name", "email", "degree", "qualification", "expertise_sub", "designation", "password"}, faculty);
+    db.insertRows("courses", {"course_code", "course_name", "credits", "semester", "department", "max_students", "prerequisites"}, courses);
+    db.insertRows("course_schedule", {"course_code", "faculty_id", "timeslot_id", "room_id", "term_id"}, schedules);
+
+    students.clear(); faculty.clear(); courses.clear(); schedules.clear();
+    removedStudents.clear(); removedFaculty.clear(); removedCourses.clear(); removedSchedules.clear();
+}
+void Database::Transaction::commit() {
+    if (done)
+        return;
+    try {
+        flush();
+        std::vector<ChangeFeed> feeds;
+        for (std::size_t i = 0; i < touched.size(); ++i)
+            if (touched[i]) feeds.push_back(static_cast<ChangeFeed>(i));
+        if (!feeds.empty())
+            db.bumpVersions(feeds);
+    }
+    catch (...) {
+        abandon();
+        throw;
+    }
+    if (!outer) {
+        done = true;
+        --db.transactionDepth;
+        return;
+    }
+    if (db.rollbackOnly) {
+        abandon();
+        throw std::runtime_error("Transaction rolled back: a nested unit of work failed");
+    }
+    try {
+        db.session->commit();
+    }
+    catch (...) {
+        abandon();
+        throw;
+    }
+    done = true;
+    --db.transactionDepth;
+    db.advanceReadFloor();
 }
 
 bool Database::studentExists(const std::string& studentId) {
-    auto students = db.getTable("students");
+    TraceScope trace(TraceMethod::StudentExists, studentId);
+    if (remote) return remote->call<bool>(TraceMethod::StudentExists, studentId);
+    auto students = readTable("students");
     auto res = students.select("COUNT(*)").where("student_id = :sid").bind("sid", studentId).execute();
     auto row = res.fetchOne();
     return row && row[0].get<int>() > 0;
 }
 bool Database::validateStudentPassword(const std::string& studentId, const std::string& password) {
-    auto students = db.getTable("students");
+    TraceScope trace(TraceMethod::ValidateStudentPassword, studentId, std::string());
+    if (remote) return remote->call<bool>(TraceMethod::ValidateStudentPassword, studentId, password);
+    auto students = readTable("students");
     auto res = students.select("password").where("student_id = :sid").bind("sid", studentId).execute();
     auto row = res.fetchOne();
     return row && row[0].get<std::string>() == password;
 }
 bool Database::changeStudentPassword(const std::string& studentId, const std::string& newPassword) {
-    auto students = db.getTable("students");
-    auto res = students.update().set("password", newPassword).where("student_id = :sid").bind("sid", studentId).execute();
-    return res.getAffectedItemsCount() > 0;
+    TraceScope trace(TraceMethod::ChangeStudentPassword, studentId, std::string());
+    if (remote) return remote->call<bool>(TraceMethod::ChangeStudentPassword, studentId, newPassword);
+    return mutate({ChangeFeed::Students}, [&] {
+        auto students = db->getTable("students");
+        auto res = students.update().set("password", newPassword).where("student_id = :sid").bind("sid", studentId).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
 }
 bool Database::resetStudentPassword(const std::string& studentId) {
+    TraceScope trace(TraceMethod::ResetStudentPassword, studentId);
     return changeStudentPassword(studentId, "bnu");
 }
 int Database::getStudentSemester(const std::string& studentId) {
-    auto students = db.getTable("students");
+    TraceScope trace(TraceMethod::GetStudentSemester, studentId);
+    if (remote) return remote->call<int>(TraceMethod::GetStudentSemester, studentId);
+    auto students = readTable("students");
     auto res = students.select("semester").where("student_id = :sid").bind("sid", studentId).execute();
     auto row = res.fetchOne();
     return row ? row[0].get<int>() : -1;
 }
 std::string Database::getStudentDegree(const std::string& studentId) {
-    auto students = db.getTable("students");
+    TraceScope trace(TraceMethod::GetStudentDegree, studentId);
+    if (remote) return remote->call<std::string>(TraceMethod::GetStudentDegree, studentId);
+    auto students = readTable("students");
     auto res = students.select("degree").where("student_id = :sid").bind("sid", studentId).execute();
     auto row = res.fetchOne();
     return row ? std::string(row[0].get<std::string>()) : "";
 }
 
 bool Database::facultyExists(const std::string& email) {
-    auto faculty = db.getTable("faculty");
+    TraceScope trace(TraceMethod::FacultyExists, email);
+    if (remote) return remote->call<bool>(TraceMethod::FacultyExists, email);
+    auto faculty = readTable("faculty");
     auto res = faculty.select("COUNT(*)").where("email = :email").bind("email", email).execute();
     auto row = res.fetchOne();
     return row && row[0].get<int>() > 0;
 }
 bool Database::validateFacultyPassword(const std::string& email, const std::string& password) {
-    auto faculty = db.getTable("faculty");
+    TraceScope trace(TraceMethod::ValidateFacultyPassword, email, std::string());
+    if (remote) return remote->call<bool>(TraceMethod::ValidateFacultyPassword, email, password);
+    auto faculty = readTable("faculty");
     auto res = faculty.select("password").where("email = :email").bind("email", email).execute();
     auto row = res.fetchOne();
     return row && row[0].get<std::string>() == password;
 }
 std::string Database::getFacultyId(const std::string& email) {
-    auto faculty = db.getTable("faculty");
+    TraceScope trace(TraceMethod::GetFacultyId, email);
+    if (remote) return remote->call<std::string>(TraceMethod::GetFacultyId, email);
+    auto faculty = readTable("faculty");
     auto res = faculty.select("faculty_id").where("email = :email").bind("email", email).execute();
     auto row = res.fetchOne();
     return row ? std::to_string(row[0].get<int>()) : "";
 }
 std::string Database::getFacultyName(const std::string& email) {
-    auto faculty = db.getTable("faculty");
+    TraceScope trace(TraceMethod::GetFacultyName, email);
+    if (remote) return remote->call<std::string>(TraceMethod::GetFacultyName, email);
+    auto faculty = readTable("faculty");
     auto res = faculty.select("first_name", "last_name").where("email = :email").bind("email", email).execute();
     auto row = res.fetchOne();
     return row ? (row[0].get<std::string>() + " " + row[1].get<std::string>()) : "";
 }
 bool Database::changeFacultyPassword(const std::string& email, const std::string& newPassword) {
-    auto faculty = db.getTable("faculty");
-    auto res = faculty.update().set("password", newPassword).where("email = :email").bind("email", email).execute();
-    return res.getAffectedItemsCount() > 0;
+    TraceScope trace(TraceMethod::ChangeFacultyPassword, email, std::string());
+    if (remote) return remote->call<bool>(TraceMethod::ChangeFacultyPassword, email, newPassword);
+    return mutate({ChangeFeed::Faculty}, [&] {
+        auto faculty = db->getTable("faculty");
+        auto res = faculty.update().set("password", newPassword).where("email = :email").bind("email", email).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
 }
 bool Database::resetFacultyPassword(const std::string& email) {
+    TraceScope trace(TraceMethod::ResetFacultyPassword, email);
     return changeFacultyPassword(email, "faculty_scit");
 }
 
 std::vector<ScheduledCourse> Database::getAvailableScheduledCourses(int semester, const std::string& degree) {
-    std::vector<ScheduledCourse> result;
-    std::string query =
-        "SELECT cs.schedule_id, cs.course_code, c.course_name, f.first_name, f.last_name, "
-        "t.day_of_week, CAST(t.start_time AS CHAR), CAST(t.end_time AS CHAR), "
-        "cl.room_number, cl.building, cs.timeslot_id "
-        "FROM course_schedule cs "
-        "JOIN courses c ON cs.course_code = c.course_code "
-        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
-        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
-        "JOIN classrooms cl ON cs.room_id = cl.room_id "
-        "WHERE c.semester = ? AND c.department = ?";
-    auto res = session.sql(query).bind(semester, degree).execute();
-    mysqlx::Row row;
-    while ((row = res.fetchOne())) {
-        ScheduledCourse sc;
-        sc.schedule_id   = row[0].get<int>();
-        sc.course_code   = row[1].get<std::string>();
-        sc.course_name   = row[2].get<std::string>();
-        sc.faculty_name  = row[3].get<std::string>() + " " + row[4].get<std::string>();
-        sc.day           = row[5].get<std::string>();
-        sc.start_time    = row[6].get<std::string>();
-        sc.end_time      = row[7].get<std::string>();
-        sc.room_number   = row[8].get<std::string>();
-        sc.building      = row[9].get<std::string>();
-        sc.timeslot_id   = row[10].get<int>();
-        result.push_back(sc);
-    }
-    return result;
+    TraceScope trace(TraceMethod::GetAvailableScheduledCourses, semester, degree);
+    if (remote) return remote->call<std::vector<ScheduledCourse>>(TraceMethod::GetAvailableScheduledCourses, semester, degree);
+    return fetchRows<catalog::AvailableScheduledCourses>(semester, degree);
 }
 bool Database::isAlreadyEnrolled(const std::string& studentId, int schedule_id) {
-    auto enrollments = db.getTable("enrollments");
+    TraceScope trace(TraceMethod::IsAlreadyEnrolled, studentId, schedule_id);
+    if (remote) return remote->call<bool>(TraceMethod::IsAlreadyEnrolled, studentId, schedule_id);
+    auto enrollments = readTable("enrollments");
     auto res = enrollments.select("COUNT(*)")
                    .where("student_id = :sid AND schedule_id = :scid")
                    .bind("sid", studentId)
@@ -138,335 +771,655 @@ bool Database::isAlreadyEnrolled(const std::string& studentId, int schedule_id)
     return row && row[0].get<int>() > 0;
 }
 bool Database::hasClash(const std::string& studentId, int timeslot_id) {
+    TraceScope trace(TraceMethod::HasClash, studentId, timeslot_id);
+    if (remote) return remote->call<bool>(TraceMethod::HasClash, studentId, timeslot_id);
     std::string query =
         "SELECT COUNT(*) FROM enrollments e "
         "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
         "WHERE e.student_id = ? AND cs.timeslot_id = ?";
-    auto res = session.sql(query).bind(studentId, timeslot_id).execute();
+    auto res = reader().sql(query).bind(studentId, timeslot_id).execute();
     auto row = res.fetchOne();
     return row && row[0].get<int>() > 0;
 }
 bool Database::addEnrollment(const std::string& studentId, int schedule_id) {
-    std::string course_code;
-    {
-        std::string query = "SELECT course_code FROM course_schedule WHERE schedule_id = ?";
-        auto res = session.sql(query).bind(schedule_id).execute();
-        auto row = res.fetchOne();
-        if (!row) return false;
-        course_code = row[0].get<std::string>();
-    }
-    int max_students = 0;
-    {
-        std::string query = "SELECT max_students FROM courses WHERE course_code = ?";
-        auto res = session.sql(query).bind(course_code).execute();
-        auto row = res.fetchOne();
-        if (!row) return false;
-        max_students = row[0].get<int>();
+    TraceScope trace(TraceMethod::AddEnrollment, studentId, schedule_id);
+    if (remote) return remote->call<bool>(TraceMethod::AddEnrollment, studentId, schedule_id);
+    Transaction tx(*this);
+    int promoted = 0;
+    int free = fillFromWaitlist(schedule_id, promoted);
+    if (promoted)
+        tx.touch({ChangeFeed::Enrollments, ChangeFeed::Waitlist});
+    // With the section locked, the student's row serializes their own adds,
+    // and the locking read below sees every enrollment committed before
+    // it, so neither a duplicate nor a clash in the section's timeslot can
+    // slip in between the check and the insert.
+    if (free < 0 || !session->sql("SELECT student_id FROM students WHERE student_id = ? FOR UPDATE")
+                         .bind(studentId).execute().fetchOne()) {
+        tx.commit();
+        return false;
     }
-    int enrolled = 0;
-    {
-        std::string query = "SELECT COUNT(*) FROM enrollments WHERE schedule_id = ?";
-        auto res = session.sql(query).bind(schedule_id).execute();
-        auto row = res.fetchOne();
-        if (!row) return false;
-        enrolled = row[0].get<int>();
+    auto held = session->sql(catalog::text<catalog::HeldSlot>()).bind(studentId, schedule_id).execute().fetchOne();
+    bool added = false;
+    if (held && held[0].get<int>() > 0) {
+        added = held[1].get<int>() > 0;
+    } else if (free > 0) {
+        auto enrollments = db->getTable("enrollments");
+        enrollments.insert("student_id", "schedule_id").values(studentId, schedule_id).execute();
+        tx.touch({ChangeFeed::Enrollments});
+        auto waitlist = db->getTable("waitlist");
+        auto res = waitlist.remove()
+                       .where("student_id = :sid AND schedule_id = :scid")
+                       .bind("sid", studentId)
+                       .bind("scid", schedule_id)
+                       .execute();
+        if (res.getAffectedItemsCount() > 0)
+            tx.touch({ChangeFeed::Waitlist});
+        added = true;
     }
-    if (enrolled >= max_students)
-        return false;
-    auto enrollments = db.getTable("enrollments");
-    enrollments.insert("student_id", "schedule_id").values(studentId, schedule_id).execute();
-    return true;
+    tx.commit();
+    return added;
 }
 bool Database::dropEnrollment(const std::string& studentId, int schedule_id) {
-    auto enrollments = db.getTable("enrollments");
+    TraceScope trace(TraceMethod::DropEnrollment, studentId, schedule_id);
+    if (remote) return remote->call<bool>(TraceMethod::DropEnrollment, studentId, schedule_id);
+    Transaction tx(*this);
+    // Section first, then its enrollment rows: the order addEnrollment takes
+    // them in. Sections of closed terms keep their enrollments.
+    if (!session->sql(catalog::text<catalog::SectionSeats>()).bind(schedule_id).execute().fetchOne())
+        return false;
+    auto enrollments = db->getTable("enrollments");
     auto res = enrollments.remove()
                    .where("student_id = :sid AND schedule_id = :scid")
                    .bind("sid", studentId)
                    .bind("scid", schedule_id)
                    .execute();
-    return res.getAffectedItemsCount() > 0;
+    bool dropped = res.getAffectedItemsCount() > 0;
+    if (dropped) {
+        tx.touch({ChangeFeed::Enrollments});
+        int promoted = 0;
+        fillFromWaitlist(schedule_id, promoted);
+        if (promoted)
+            tx.touch({ChangeFeed::Waitlist});
+    }
+    tx.commit();
+    return dropped;
+}
+// Locks the section and hands its free seats to the eligible students at the
+// front of its waitlist. Returns the seats still free afterwards, or -1 when
+// the section does not exist or its term is closed; promoted counts the students moved in. Callers
+// run it inside their transaction and touch the feeds.
+int Database::fillFromWaitlist(int schedule_id, int& promoted) {
+    promoted = 0;
+    int free = 0, timeslot_id = 0, term_id = 0;
+    {
+        auto res = session->sql(catalog::text<catalog::SectionSeats>()).bind(schedule_id).execute();
+        auto row = res.fetchOne();
+        if (!row) return -1;
+        free = row[0].get<int>();
+        timeslot_id = row[1].get<int>();
+        term_id = row[2].get<int>();
+    }
+    {
+        std::string query = "SELECT COUNT(*) FROM enrollments WHERE schedule_id = ? FOR SHARE";
+        auto res = session->sql(query).bind(schedule_id).execute();
+        if (auto row = res.fetchOne())
+            free -= row[0].get<int>();
+    }
+    if (free <= 0)
+        return 0;
+
+    Rows seats;
+    std::vector<mysqlx::Value> served;
+    {
+        auto res = session->sql(catalog::text<catalog::EligibleWaitlisted>()).bind(schedule_id, timeslot_id, term_id, free).execute();
+        mysqlx::Row row;
+        while ((row = res.fetchOne())) {
+            served.push_back(row[0]);
+            seats.push_back({row[1], schedule_id});
+        }
+    }
+    insertRows("enrollments", {"student_id", "schedule_id"}, seats);
+    deleteWhereIn("waitlist", "seq", served);
+    promoted = static_cast<int>(served.size());
+    return free - promoted;
+}
+int Database::joinWaitlist(const std::string& studentId, int schedule_id) {
+    TraceScope trace(TraceMethod::JoinWaitlist, studentId, schedule_id);
+    if (remote) return remote->call<int>(TraceMethod::JoinWaitlist, studentId, schedule_id);
+    Transaction tx(*this);
+    int promoted = 0;
+    int free = fillFromWaitlist(schedule_id, promoted);
+    if (promoted)
+        tx.touch({ChangeFeed::Enrollments, ChangeFeed::Waitlist});
+    int position = free < 0 ? -1 : 0;
+    if (free >= 0 && !isAlreadyEnrolled(studentId, schedule_id)) {
+        std::string insert = "INSERT IGNORE INTO waitlist (schedule_id, student_id) VALUES (?, ?)";
+        if (session->sql(insert).bind(schedule_id, studentId).execute().getAffectedItemsCount() > 0)
+            tx.touch({ChangeFeed::Waitlist});
+        // A seat nobody ahead could take goes to the newcomer straight away.
+        if (free > 0) {
+            fillFromWaitlist(schedule_id, promoted);
+            if (promoted)
+                tx.touch({ChangeFeed::Enrollments});
+        }
+        std::string query =
+            "SELECT COUNT(*) FROM waitlist ahead JOIN waitlist w "
+            "ON ahead.schedule_id = w.schedule_id AND ahead.seq <= w.seq "
+            "WHERE w.schedule_id = ? AND w.student_id = ?";
+        auto res = session->sql(query).bind(schedule_id, studentId).execute();
+        if (auto row = res.fetchOne())
+            position = row[0].get<int>();
+    }
+    tx.commit();
+    return position;
+}
+bool Database::leaveWaitlist(const std::string& studentId, int schedule_id) {
+    TraceScope trace(TraceMethod::LeaveWaitlist, studentId, schedule_id);
+    if (remote) return remote->call<bool>(TraceMethod::LeaveWaitlist, studentId, schedule_id);
+    return mutate({ChangeFeed::Waitlist}, [&] {
+        auto waitlist = db->getTable("waitlist");
+        auto res = waitlist.remove()
+                       .where("student_id = :sid AND schedule_id = :scid")
+                       .bind("sid", studentId)
+                       .bind("scid", schedule_id)
+                       .execute();
+        return res.getAffectedItemsCount() > 0;
+    });
+}
+std::vector<WaitlistEntry> Database::getStudentWaitlists(const std::string& studentId) {
+    TraceScope trace(TraceMethod::GetStudentWaitlists, studentId);
+    if (remote) return remote->call<std::vector<WaitlistEntry>>(TraceMethod::GetStudentWaitlists, studentId);
+    return fetchRows<catalog::StudentWaitlists>(studentId);
 }
 std::vector<ScheduledCourse> Database::getEnrolledCourses(const std::string& studentId) {
-    std::vector<ScheduledCourse> result;
-    std::string query =
-        "SELECT cs.schedule_id, c.course_code, c.course_name, c.department, c.semester, "
-        "f.faculty_id, CONCAT(f.first_name,' ',f.last_name) AS faculty_name, "
-        "t.timeslot_id, t.day_of_week, CAST(t.start_time AS CHAR), CAST(t.end_time AS CHAR), "
-        "cl.room_id, cl.room_number, cl.building "
-        "FROM enrollments e "
-        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
-        "JOIN courses c ON cs.course_code = c.course_code "
-        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
-        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
-        "JOIN classrooms cl ON cs.room_id = cl.room_id "
-        "WHERE e.student_id = ?";
-    auto res = session.sql(query).bind(studentId).execute();
-    mysqlx::Row row;
-    while ((row = res.fetchOne()))
+    TraceScope trace(TraceMethod::GetEnrolledCourses, studentId);
+    if (remote) return remote->call<std::vector<ScheduledCourse>>(TraceMethod::GetEnrolledCourses, studentId);
+    return fetchRows<catalog::EnrolledCourses>(studentId);
+}
+void Database::streamEnrolledTimetables(const std::function<void(EnrolledTimetableRow&)>& fn) {
+    streamRows<catalog::AllEnrolledTimetables>(fn);
+}
+void Database::streamScheduledCourses(const std::function<void(ScheduledCourse&)>& fn) {
+    streamRows<catalog::AllScheduledCourses>(fn);
+}
+std::vector<EnrolledTimetableRow> Database::getScheduleRoster(int schedule_id) {
+    TraceScope trace(TraceMethod::GetScheduleRoster, schedule_id);
+    return fetchRows<catalog::ScheduleRoster>(schedule_id);
+}
+std::vector<EnrolledTimetableRow> Database::getTimeslotRosters(int timeslot_id) {
+    TraceScope trace(TraceMethod::GetTimeslotRosters, timeslot_id);
+    return fetchRows<catalog::TimeslotRosters>(timeslot_id);
+}
+std::vector<EnrolledTimetableRow> Database::getClassroomRosters(const std::string& room_id) {
+    TraceScope trace(TraceMethod::GetClassroomRosters, room_id);
+    return fetchRows<catalog::ClassroomRosters>(room_id);
+}
+std::vector<EnrolledTimetableRow> Database::getFacultyRosters(int faculty_id) {
+    TraceScope trace(TraceMethod::GetFacultyRosters, faculty_id);
+    return fetchRows<catalog::FacultyRosters>(faculty_id);
+}
+std::vector<EnrolledTimetableRow> Database::getCourseRosters(const std::string& course_code) {
+    TraceScope trace(TraceMethod::GetCourseRosters, course_code);
+    return fetchRows<catalog::CourseRosters>(course_code);
+}
+void Database::streamMarks(const std::function<void(MarkRecord&)>& fn) {
+    streamRows<catalog::AllMarks>(fn);
+}
+void Database::streamStudentCourses(const std::function<void(StudentCourse&)>& fn) {
+    streamRows<catalog::AllStudentCourses>(fn);
+}
+void Database::streamClassrooms(const std::function<void(Classroom&)>& fn) {
+    streamRows<catalog::AllClassrooms>(fn);
+}
+void Database::logResultsDirty(const std::string& student_id, const std::string& course_code) {
+    session->sql("INSERT INTO results_dirty (student_id, course_code) VALUES (?, ?)").bind(student_id, course_code).execute();
+}
+// Read on the primary; the marks streamed for it may come from a replica,
+// which then has to hold every mark logged up to the returned entry.
+std::uint64_t Database::resultsDirtyMark() {
+    auto res = session->sql("SELECT COALESCE(MAX(seq), 0) FROM results_dirty").execute();
+    auto row = res.fetchOne();
+    const std::uint64_t mark = row ? row[0].get<std::uint64_t>() : 0;
+    advanceReadFloor();
+    return mark;
+}
+void Database::streamDirtyMarks(std::uint64_t upTo, const std::function<void(MarkRecord&)>& fn) {
+    streamRows<catalog::DirtyMarks>(fn, upTo);
+}
+void Database::storeCourseResults(const std::vector<CourseResult>& results, bool full, std::uint64_t upTo) {
+    Transaction tx(*this);
+    // Archived terms have no marks left to regrade from, so their results
+    // stay as they are.
+    if (full) {
+        session->sql("DELETE r FROM course_results r "
+                     "JOIN terms t ON t.term_id = r.term_id AND t.state <> 'archived'").execute();
+    } else {
+        session->sql("DELETE r FROM course_results r "
+                     "JOIN terms t ON t.term_id = r.term_id AND t.state <> 'archived' "
+                     "JOIN (SELECT DISTINCT student_id, course_code FROM results_dirty WHERE seq <= ?) d "
+                     "ON d.student_id = r.student_id AND d.course_code = r.course_code").bind(upTo).execute();
+    }
+    Rows rows;
+    rows.reserve(results.size());
+    for (const auto& r : results)
+        rows.push_back({r.student_id, r.course_code, r.term_id, r.semester, r.credits, r.percent, r.letter, r.points});
+    insertRows("course_results", {"student_id", "course_code", "term_id", "semester", "credits", "percent", "letter", "points"}, rows);
+    session->sql("DELETE FROM results_dirty WHERE seq <= ?").bind(upTo).execute();
+    tx.touch({ChangeFeed::Results});
+    tx.commit();
+}
+std::vector<CourseResult> Database::getCourseResults(const std::string& studentId) {
+    TraceScope trace(TraceMethod::GetCourseResults, studentId);
+    if (remote) return remote->call<std::vector<CourseResult>>(TraceMethod::GetCourseResults, studentId);
+    return fetchRows<catalog::StudentResults>(studentId);
+}
+int Database::currentTerm() {
+    TraceScope trace(TraceMethod::CurrentTerm);
+    auto res = reader().sql("SELECT term_id FROM current_term").execute();
+    auto row = res.fetchOne();
+    return row && !row[0].isNull() ? row[0].get<int>() : 0;
+}
+std::vector<Term> Database::getTerms() {
+    TraceScope trace(TraceMethod::GetTerms);
+    return fetchRows<catalog::Terms>();
+}
+int Database::startTerm(const std::string& name) {
+    TraceScope trace(TraceMethod::StartTerm, name);
+    int term_id = 0;
+    mutate({ChangeFeed::Terms, ChangeFeed::Schedule, ChangeFeed::Enrollments}, [&] {
+        auto res = session->sql("INSERT INTO terms (name) VALUES (?)").bind(name).execute();
+        term_id = static_cast<int>(res.getAutoIncrementValue());
+        return true;
+    });
+    return term_id;
+}
+bool Database::closeTerm(int term_id) {
+    TraceScope trace(TraceMethod::CloseTerm, term_id);
+    return mutate({ChangeFeed::Terms, ChangeFeed::Schedule, ChangeFeed::Enrollments, ChangeFeed::Waitlist}, [&] {
+        auto res = session->sql("UPDATE terms SET state = 'closed' WHERE term_id = ? AND state = 'open'").bind(term_id).execute();
+        if (res.getAffectedItemsCount() == 0)
+            return false;
+        session->sql("DELETE w FROM waitlist w JOIN course_schedule cs ON w.schedule_id = cs.schedule_id "
+                     "WHERE cs.term_id = ?").bind(term_id).execute();
+        return true;
+    });
+}
+TermArchiveSummary Database::archiveTerm(int term_id) {
+    TraceScope trace(TraceMethod::ArchiveTerm, term_id);
+    TermArchiveSummary summary;
+    auto started = std::chrono::steady_clock::now();
+    Transaction tx(*this);
     {
-        ScheduledCourse sc;
-        sc.schedule_id = row[0].get<int>();
-        sc.course_code = row[1].get<std::string>();
-        sc.course_name = row[2].get<std::string>();
-        sc.department = row[3].get<std::string>();
-        sc.semester = row[4].get<int>();
-        sc.faculty_id = row[5].get<int>();
-        sc.faculty_name = row[6].get<std::string>();
-        sc.timeslot_id = row[7].get<int>();
-        sc.day = row[8].get<std::string>();
-        sc.start_time = row[9].get<std::string>();
-        sc.end_time = row[10].get<std::string>();
-        sc.room_id = row[11].get<std::string>();
-        sc.room_number = row[12].get<std::string>();
-        sc.building = row[13].get<std::string>();
-        result.push_back(sc);
+        auto res = session->sql("SELECT state FROM terms WHERE term_id = ? FOR UPDATE").bind(term_id).execute();
+        auto row = res.fetchOne();
+        if (!row)
+            throw std::runtime_error("No term " + std::to_string(term_id));
+        const std::string state = row[0].get<std::string>();
+        if (state != "closed")
+            throw std::runtime_error("Term " + std::to_string(term_id) + " is " + state + ", only closed terms are archived");
     }
-    return result;
+    {
+        auto res = session->sql("SELECT COUNT(*) FROM results_dirty d JOIN marks m "
+                                "ON m.student_id = d.student_id AND m.course_code = d.course_code "
+                                "WHERE m.term_id = ?").bind(term_id).execute();
+        auto row = res.fetchOne();
+        if (row && row[0].get<int>() > 0)
+            throw std::runtime_error("Term " + std::to_string(term_id) + " has marks not graded yet; run cms_cli results first");
+    }
+    summary.sections = session->sql("INSERT INTO course_schedule_archive "
+                                    "(term_id, schedule_id, course_code, faculty_id, timeslot_id, room_id) "
+                                    "SELECT term_id, schedule_id, course_code, faculty_id, timeslot_id, room_id "
+                                    "FROM course_schedule WHERE term_id = ?").bind(term_id).execute().getAffectedItemsCount();
+    summary.enrollments = session->sql("INSERT INTO enrollments_archive (term_id, schedule_id, student_id) "
+                                       "SELECT cs.term_id, e.schedule_id, e.student_id FROM enrollments e "
+                                       "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+                                       "WHERE cs.term_id = ?").bind(term_id).execute().getAffectedItemsCount();
+    summary.marks = session->sql("INSERT INTO marks_archive "
+                                 "(term_id, course_code, student_id, assignment_name, total_marks, obtained_marks) "
+                                 "SELECT term_id, course_code, student_id, assignment_name, total_marks, obtained_marks "
+                                 "FROM marks WHERE term_id = ?").bind(term_id).execute().getAffectedItemsCount();
+    session->sql("DELETE e FROM enrollments e JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+                 "WHERE cs.term_id = ?").bind(term_id).execute();
+    session->sql("DELETE w FROM waitlist w JOIN course_schedule cs ON w.schedule_id = cs.schedule_id "
+                 "WHERE cs.term_id = ?").bind(term_id).execute();
+    session->sql("DELETE FROM course_schedule WHERE term_id = ?").bind(term_id).execute();
+    session->sql("DELETE FROM marks WHERE term_id = ?").bind(term_id).execute();
+    session->sql("UPDATE terms SET state = 'archived' WHERE term_id = ?").bind(term_id).execute();
+    tx.touch({ChangeFeed::Terms, ChangeFeed::Schedule, ChangeFeed::Enrollments, ChangeFeed::Waitlist, ChangeFeed::Marks});
+    tx.commit();
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
 }
 bool Database::isAdminPasswordCorrect(const std::string& password) {
     return password == "admin123";
 }
 
 void Database::addStudent(const std::string& id, const std::string& fname, const std::string& lname, const std::string& email, const std::string& degree, int semester) {
-    auto students = db.getTable("students");
-    students.insert("student_id", "first_name", "last_name", "email", "degree", "semester", "password")
-        .values(id, fname, lname, email, degree, semester, "bnu")
-        .execute();
+    TraceScope trace(TraceMethod::AddStudent, id, fname, lname, email, degree, semester);
+    mutate({ChangeFeed::Students}, [&] {
+        auto students = db->getTable("students");
+        students.insert("student_id", "first_name", "last_name", "email", "degree", "semester", "password")
+            .values(id, fname, lname, email, degree, semester, "bnu")
+            .execute();
+        return true;
+    });
 }
 void Database::removeStudent(const std::string& id) {
-    auto students = db.getTable("students");
-    students.remove().where("student_id = :sid").bind("sid", id).execute();
+    TraceScope trace(TraceMethod::RemoveStudent, id);
+    mutate({ChangeFeed::Students, ChangeFeed::Enrollments, ChangeFeed::Marks, ChangeFeed::Results}, [&] {
+        db->getTable("waitlist").remove().where("student_id = :sid").bind("sid", id).execute();
+        db->getTable("course_results").remove().where("student_id = :sid").bind("sid", id).execute();
+        auto students = db->getTable("students");
+        auto res = students.remove().where("student_id = :sid").bind("sid", id).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
 }
 void Database::addFaculty(int faculty_id, const std::string& fname, const std::string& lname, const std::string& email, const std::string& degree, const std::string& qualification, const std::string& expertise_sub, const std::string& designation) {
-    auto faculty = db.getTable("faculty");
-    faculty.insert("faculty_id", "first_name", "last_name", "email", "degree", "qualification", "expertise_sub", "designation", "password")
-        .values(faculty_id, fname, lname, email, degree, qualification, expertise_sub, designation, "faculty_scit")
-        .execute();
+    TraceScope trace(TraceMethod::AddFaculty, faculty_id, fname, lname, email, degree, qualification, expertise_sub, designation);
+    mutate({ChangeFeed::Faculty}, [&] {
+        auto faculty = db->getTable("faculty");
+        faculty.insert("faculty_id", "first_name", "last_name", "email", "degree", "qualification", "expertise_sub", "designation", "password")
+            .values(faculty_id, fname, lname, email, degree, qualification, expertise_sub, designation, "faculty_scit")
+            .execute();
+        return true;
+    });
 }
 void Database::removeFaculty(int faculty_id) {
-    auto faculty = db.getTable("faculty");
-    faculty.remove().where("faculty_id = :fid").bind("fid", faculty_id).execute();
+    TraceScope trace(TraceMethod::RemoveFaculty, faculty_id);
+    mutate({ChangeFeed::Faculty, ChangeFeed::Schedule, ChangeFeed::Enrollments}, [&] {
+        removeSectionsWhere("faculty_id", {faculty_id});
+        auto faculty = db->getTable("faculty");
+        auto res = faculty.remove().where("faculty_id = :fid").bind("fid", faculty_id).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
 }
 void Database::addCourse(const std::string& code, const std::string& name, int credits, int sem, const std::string& dept, int max, const std::string& prereq) {
-    auto courses = db.getTable("courses");
-    courses.insert("course_code", "course_name", "credits", "semester", "department", "max_students", "prerequisites")
-        .values(code, name, credits, sem, dept, max, prereq)
-        .execute();
+    TraceScope trace(TraceMethod::AddCourse, code, name, credits, sem, dept, max, prereq);
+    mutate({ChangeFeed::Courses}, [&] {
+        auto courses = db->getTable("courses");
+        courses.insert("course_code", "course_name", "credits", "semester", "department", "max_students", "prerequisites")
+            .values(code, name, credits, sem, dept, max, prereq)
+            .execute();
+        return true;
+    });
 }
 void Database::removeCourse(const std::string& code) {
-    auto courses = db.getTable("courses");
-    courses.remove().where("course_code = :ccode").bind("ccode", code).execute();
+    TraceScope trace(TraceMethod::RemoveCourse, code);
+    mutate({ChangeFeed::Courses, ChangeFeed::Schedule, ChangeFeed::Enrollments, ChangeFeed::Marks, ChangeFeed::Results}, [&] {
+        removeSectionsWhere("course_code", {code});
+        db->getTable("course_results").remove().where("course_code = :ccode").bind("ccode", code).execute();
+        auto courses = db->getTable("courses");
+        auto res = courses.remove().where("course_code = :ccode").bind("ccode", code).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
 }
 void Database::addClassroom(const std::string& id, const std::string& building, const std::string& number, int capacity, const std::string& room_type) {
-    auto classrooms = db.getTable("classrooms");
-    classrooms.insert("room_id", "building", "room_number", "capacity", "room_type")
-        .values(id, building, number, capacity, room_type)
-        .execute();
+    TraceScope trace(TraceMethod::AddClassroom, id, building, number, capacity, room_type);
+    mutate({ChangeFeed::Classrooms}, [&] {
+        auto classrooms = db->getTable("classrooms");
+        classrooms.insert("room_id", "building", "room_number", "capacity", "room_type")
+            .values(id, building, number, capacity, room_type)
+            .execute();
+        return true;
+    });
 }
 void Database::removeClassroom(const std::string& id) {
-    auto classrooms = db.getTable("classrooms");
-    classrooms.remove().where("room_id = :rid").bind("rid", id).execute();
+    TraceScope trace(TraceMethod::RemoveClassroom, id);
+    mutate({ChangeFeed::Classrooms, ChangeFeed::Schedule, ChangeFeed::Enrollments}, [&] {
+        removeSectionsWhere("room_id", {id});
+        auto classrooms = db->getTable("classrooms");
+        auto res = classrooms.remove().where("room_id = :rid").bind("rid", id).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
 }
 void Database::addTimeslot(const std::string& day, const std::string& start, const std::string& end) {
-    auto timeslots = db.getTable("timeslots");
-    timeslots.insert("day_of_week", "start_time", "end_time")
-        .values(day, start, end)
-        .execute();
+    TraceScope trace(TraceMethod::AddTimeslot, day, start, end);
+    mutate({ChangeFeed::Timeslots}, [&] {
+        auto timeslots = db->getTable("timeslots");
+        timeslots.insert("day_of_week", "start_time", "end_time")
+            .values(day, start, end)
+            .execute();
+        return true;
+    });
+    timeslotCacheVersion.reset();
 }
 void Database::removeTimeslot(int timeslot_id) {
-    auto timeslots = db.getTable("timeslots");
-    timeslots.remove().where("timeslot_id = :tid").bind("tid", timeslot_id).execute();
+    TraceScope trace(TraceMethod::RemoveTimeslot, timeslot_id);
+    mutate({ChangeFeed::Timeslots, ChangeFeed::Schedule, ChangeFeed::Enrollments}, [&] {
+        removeSectionsWhere("timeslot_id", {timeslot_id});
+        auto timeslots = db->getTable("timeslots");
+        auto res = timeslots.remove().where("timeslot_id = :tid").bind("tid", timeslot_id).execute();
+        return res.getAffectedItemsCount() > 0;
+    });
+    timeslotCacheVersion.reset();
 }
 
 std::vector<std::pair<std::string, std::string>> Database::getUnscheduledCourses() {
+    TraceScope trace(TraceMethod::GetUnscheduledCourses);
     std::vector<std::pair<std::string, std::string>> resvec;
     std::string query =
-        "SELECT course_code, course_name FROM courses WHERE course_code NOT IN (SELECT course_code FROM course_schedule)";
-    auto res = session.sql(query).execute();
+        "SELECT course_code, course_name FROM courses WHERE course_code NOT IN "
+        "(SELECT cs.course_code FROM course_schedule cs JOIN current_term ct ON cs.term_id = ct.term_id)";
+    auto res = reader().sql(query).execute();
+    mysqlx::Row row;
+    while ((row = res.fetchOne()))
+        resvec.emplace_back(row[0].get<std::string>(), row[1].get<std::string>());
+    return resvec;
+}
+std::vector<std::pair<std::string, std::string>> Database::getAllCourses() {
+    TraceScope trace(TraceMethod::GetAllCourses);
+    std::vector<std::pair<std::string, std::string>> resvec;
+    auto res = reader().sql("SELECT course_code, course_name FROM courses ORDER BY course_code").execute();
     mysqlx::Row row;
     while ((row = res.fetchOne()))
         resvec.emplace_back(row[0].get<std::string>(), row[1].get<std::string>());
     return resvec;
 }
+std::vector<std::pair<int, std::string>> Database::getAllFaculty() {
+    TraceScope trace(TraceMethod::GetAllFaculty);
+    std::vector<std::pair<int, std::string>> resvec;
+    auto res = reader().sql("SELECT faculty_id, CONCAT(first_name, ' ', last_name) FROM faculty ORDER BY faculty_id").execute();
+    mysqlx::Row row;
+    while ((row = res.fetchOne()))
+        resvec.emplace_back(row[0].get<int>(), row[1].get<std::string>());
+    return resvec;
+}
 std::vector<std::pair<int, std::string>> Database::getAllTimeslots() {
+    TraceScope trace(TraceMethod::GetAllTimeslots);
+    auto current = reader().sql("SELECT version FROM change_versions WHERE feed = ?")
+                       .bind(std::string(feedName(ChangeFeed::Timeslots))).execute();
+    auto feed = current.fetchOne();
+    const std::uint64_t version = feed ? feed[0].get<std::uint64_t>() : 0;
+    if (timeslotCacheVersion == version)
+        return timeslotCache;
     std::vector<std::pair<int, std::string>> resvec;
     std::string query =
         "SELECT timeslot_id, CONCAT(day_of_week, ' ', start_time, '-', end_time) FROM timeslots";
-    auto res = session.sql(query).execute();
+    auto res = reader().sql(query).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne()))
         resvec.emplace_back(row[0].get<int>(), row[1].get<std::string>());
+    timeslotCache = resvec;
+    timeslotCacheVersion = version;
     return resvec;
 }
 std::vector<std::pair<std::string, std::string>> Database::getAvailableRooms(int timeslot_id) {
+    TraceScope trace(TraceMethod::GetAvailableRooms, timeslot_id);
     std::vector<std::pair<std::string, std::string>> resvec;
     std::string query =
         "SELECT room_id, CONCAT(room_number, ' ', building) FROM classrooms "
-        "WHERE room_id NOT IN (SELECT room_id FROM course_schedule WHERE timeslot_id = ?)";
-    auto res = session.sql(query).bind(timeslot_id).execute();
+        "WHERE room_id NOT IN (SELECT cs.room_id FROM course_schedule cs "
+        "JOIN current_term ct ON cs.term_id = ct.term_id WHERE cs.timeslot_id = ?)";
+    auto res = reader().sql(query).bind(timeslot_id).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne()))
         resvec.emplace_back(row[0].get<std::string>(), row[1].get<std::string>());
     return resvec;
 }
 std::vector<std::pair<int, std::string>> Database::getAvailableFaculty(int timeslot_id) {
+    TraceScope trace(TraceMethod::GetAvailableFaculty, timeslot_id);
     std::vector<std::pair<int, std::string>> resvec;
     std::string query =
         "SELECT faculty_id, CONCAT(first_name, ' ', last_name) FROM faculty "
-        "WHERE faculty_id NOT IN (SELECT faculty_id FROM course_schedule WHERE timeslot_id = ?)";
-    auto res = session.sql(query).bind(timeslot_id).execute();
+        "WHERE faculty_id NOT IN (SELECT cs.faculty_id FROM course_schedule cs "
+        "JOIN current_term ct ON cs.term_id = ct.term_id WHERE cs.timeslot_id = ?)";
+    auto res = reader().sql(query).bind(timeslot_id).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne()))
         resvec.emplace_back(row[0].get<int>(), row[1].get<std::string>());
     return resvec;
 }
 void Database::addCourseSchedule(const std::string& course_code, int faculty_id, int timeslot_id, const std::string& room_id) {
-    auto course_schedule = db.getTable("course_schedule");
-    course_schedule.insert("course_code", "faculty_id", "timeslot_id", "room_id")
-        .values(course_code, faculty_id, timeslot_id, room_id)
-        .execute();
+    TraceScope trace(TraceMethod::AddCourseSchedule, course_code, faculty_id, timeslot_id, room_id);
+    mutate({ChangeFeed::Schedule}, [&] {
+        std::string query = "INSERT INTO course_schedule (course_code, faculty_id, timeslot_id, room_id, term_id) "
+                            "SELECT ?, ?, ?, ?, term_id FROM current_term WHERE term_id IS NOT NULL";
+        if (session->sql(query).bind(course_code, faculty_id, timeslot_id, room_id).execute().getAffectedItemsCount() == 0)
+            throw std::runtime_error("No open term to schedule sections in");
+        return true;
+    });
 }
 std::vector<Database::ScheduledAssignment> Database::getAllCourseSchedules() {
-    std::vector<ScheduledAssignment> result;
-    std::string query =
-        "SELECT cs.schedule_id, cs.course_code, c.course_name, CONCAT(f.first_name, ' ', f.last_name) AS faculty, "
-        "CONCAT(cl.room_number, ' ', cl.building) AS room, CONCAT(t.day_of_week, ' ', t.start_time, '-', t.end_time) AS timeslot "
-        "FROM course_schedule cs "
-        "JOIN courses c ON cs.course_code = c.course_code "
-        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
-        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
-        "JOIN classrooms cl ON cs.room_id = cl.room_id";
-    auto res = session.sql(query).execute();
-    mysqlx::Row row;
-    while ((row = res.fetchOne()))
-    {
-        result.push_back({
-            row[0].get<int>(),
-            row[1].get<std::string>(),
-            row[2].get<std::string>(),
-            row[3].get<std::string>(),
-            row[4].get<std::string>(),
-            row[5].get<std::string>()
-        });
-    }
-    return result;
+    TraceScope trace(TraceMethod::GetAllCourseSchedules);
+    return fetchRows<catalog::AllCourseSchedules>();
+}
+std::vector<Database::ScheduledAssignment> Database::getCourseSchedulesPage(int afterScheduleId, int limit) {
+    TraceScope trace(TraceMethod::GetCourseSchedulesPage, afterScheduleId, limit);
+    return fetchRows<catalog::CourseSchedulesPage>(afterScheduleId, limit);
 }
 void Database::removeCourseSchedule(int schedule_id) {
-    {
-        auto enrollments = db.getTable("enrollments");
-        enrollments.remove().where("schedule_id = :sid").bind("sid", schedule_id).execute();
-    }
-    {
-        auto course_schedule = db.getTable("course_schedule");
-        course_schedule.remove().where("schedule_id = :sid").bind("sid", schedule_id).execute();
+    TraceScope trace(TraceMethod::RemoveCourseSchedule, schedule_id);
+    mutate({ChangeFeed::Schedule, ChangeFeed::Enrollments}, [&] {
+        removeSectionsWhere("schedule_id", {schedule_id});
+        return true;
+    });
+}
+// Deletes the sections whose column is one of keys, and their enrollments
+// and waitlists first, so removing a timeslot, room, course or faculty member
+// never leaves orphans behind. Callers run it inside the transaction of the
+// parent delete.
+void Database::removeSectionsWhere(const char* column, const std::vector<mysqlx::Value>& keys) {
+    for (std::size_t begin = 0; begin < keys.size(); begin += batchRows) {
+        const std::size_t end = std::min(keys.size(), begin + batchRows);
+        const std::string in = placeholders(end - begin);
+        mysqlx::SqlStatement enrollments = session->sql(
+            std::string("DELETE e FROM enrollments e JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+                        "WHERE cs.") + column + " IN " + in);
+        mysqlx::SqlStatement waitlist = session->sql(
+            std::string("DELETE w FROM waitlist w JOIN course_schedule cs ON w.schedule_id = cs.schedule_id "
+                        "WHERE cs.") + column + " IN " + in);
+        mysqlx::SqlStatement sections = session->sql(std::string("DELETE FROM course_schedule WHERE ") + column + " IN " + in);
+        for (std::size_t i = begin; i < end; ++i) {
+            enrollments.bind(keys[i]);
+            waitlist.bind(keys[i]);
+            sections.bind(keys[i]);
+        }
+        enrollments.execute();
+        waitlist.execute();
+        sections.execute();
     }
 }
 
 std::vector<std::string> Database::getFacultyCourses(int facultyId) {
+    TraceScope trace(TraceMethod::GetFacultyCourses, facultyId);
+    if (remote) return remote->call<std::vector<std::string>>(TraceMethod::GetFacultyCourses, facultyId);
     std::vector<std::string> result;
     std::string query =
         "SELECT DISTINCT cs.course_code, c.course_name FROM course_schedule cs "
         "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
         "WHERE cs.faculty_id = ?";
-    auto res = session.sql(query).bind(facultyId).execute();
+    auto res = reader().sql(query).bind(facultyId).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne())) {
         result.push_back(row[0].get<std::string>() + " - " + row[1].get<std::string>());
     }
     return result;
 }
+std::vector<Database::StudentInfo> Database::getAllStudents() {
+    TraceScope trace(TraceMethod::GetAllStudents);
+    return fetchRows<catalog::AllStudents>();
+}
+std::optional<Database::StudentFootprint> Database::getStudentFootprint(const std::string& studentId) {
+    TraceScope trace(TraceMethod::GetStudentFootprint, studentId);
+    auto rows = fetchRows<catalog::StudentFootprints>(studentId);
+    if (rows.empty())
+        return std::nullopt;
+    return std::move(rows.front());
+}
+void Database::streamStudents(const std::function<void(StudentInfo&)>& fn) {
+    streamRows<catalog::AllStudents>(fn);
+}
+void Database::streamFaculty(const std::function<void(FacultyInfo&)>& fn) {
+    streamRows<catalog::AllFacultyContacts>(fn);
+}
 std::vector<Database::StudentInfo> Database::getEnrolledStudentsInCourse(const std::string& course_code) {
-    std::vector<StudentInfo> result;
-    std::string query =
-        "SELECT DISTINCT s.student_id, s.first_name, s.last_name, s.email, s.semester, s.degree "
-        "FROM enrollments e "
-        "JOIN students s ON e.student_id = s.student_id "
-        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
-        "WHERE cs.course_code = ?";
-    auto res = session.sql(query).bind(course_code).execute();
-    mysqlx::Row row;
-    while ((row = res.fetchOne()))
-    {
-        StudentInfo si;
-        si.student_id = row[0].get<std::string>();
-        si.first_name = row[1].get<std::string>();
-        si.last_name = row[2].get<std::string>();
-        si.email = row[3].get<std::string>();
-        si.semester = row[4].get<int>();
-        si.degree = row[5].get<std::string>();
-        result.push_back(si);
-    }
-    return result;
+    TraceScope trace(TraceMethod::GetEnrolledStudentsInCourse, course_code);
+    if (remote) return remote->call<std::vector<Database::StudentInfo>>(TraceMethod::GetEnrolledStudentsInCourse, course_code);
+    return fetchRows<catalog::EnrolledStudents>(course_code);
+}
+std::vector<Database::StudentInfo> Database::getEnrolledStudentsPage(const std::string& course_code, const std::string& afterStudentId, int limit) {
+    TraceScope trace(TraceMethod::GetEnrolledStudentsPage, course_code, afterStudentId, limit);
+    if (remote) return remote->call<std::vector<Database::StudentInfo>>(TraceMethod::GetEnrolledStudentsPage, course_code, afterStudentId, limit);
+    return fetchRows<catalog::EnrolledStudentsPage>(course_code, afterStudentId, limit);
 }
 std::vector<ScheduledCourse> Database::getFacultyTimetable(int facultyId) {
-    std::vector<ScheduledCourse> result;
-    std::string query =
-        "SELECT cs.schedule_id, cs.course_code, c.course_name, c.department, c.semester, "
-        "cs.faculty_id, cs.timeslot_id, CONCAT(f.first_name, ' ', f.last_name) AS faculty_name, "
-        "t.day_of_week, CAST(t.start_time AS CHAR), CAST(t.end_time AS CHAR), "
-        "cs.room_id, cl.room_number, cl.building "
-        "FROM course_schedule cs "
-        "JOIN courses c ON cs.course_code = c.course_code "
-        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
-        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
-        "JOIN classrooms cl ON cs.room_id = cl.room_id "
-        "WHERE cs.faculty_id = ?";
-    auto res = session.sql(query).bind(facultyId).execute();
-    mysqlx::Row row;
-    while ((row = res.fetchOne()))
-    {
-        ScheduledCourse sc;
-        sc.schedule_id = row[0].get<int>();
-        sc.course_code = row[1].get<std::string>();
-        sc.course_name = row[2].get<std::string>();
-        sc.department = row[3].get<std::string>();
-        sc.semester = row[4].get<int>();
-        sc.faculty_id = row[5].get<int>();
-        sc.timeslot_id = row[6].get<int>();
-        sc.faculty_name = row[7].get<std::string>();
-        sc.day = row[8].get<std::string>();
-        sc.start_time = row[9].get<std::string>();
-        sc.end_time = row[10].get<std::string>();
-        sc.room_id = row[11].get<std::string>();
-        sc.room_number = row[12].get<std::string>();
-        sc.building = row[13].get<std::string>();
-        result.push_back(sc);
-    }
-    return result;
+    TraceScope trace(TraceMethod::GetFacultyTimetable, facultyId);
+    if (remote) return remote->call<std::vector<ScheduledCourse>>(TraceMethod::GetFacultyTimetable, facultyId);
+    return fetchRows<catalog::FacultyTimetable>(facultyId);
 }
 int Database::getTotalEnrolledStudents(const std::string& course_code) {
+    TraceScope trace(TraceMethod::GetTotalEnrolledStudents, course_code);
+    if (remote) return remote->call<int>(TraceMethod::GetTotalEnrolledStudents, course_code);
     std::string query =
         "SELECT COUNT(DISTINCT e.student_id) FROM enrollments e "
         "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
         "WHERE cs.course_code = ?";
-    auto res = session.sql(query).bind(course_code).execute();
+    auto res = reader().sql(query).bind(course_code).execute();
     auto row = res.fetchOne();
     return row ? row[0].get<int>() : 0;
 }
 
+// The term a student's marks in a course belong to: that of their latest
+// section of the course, or the current term. Binds student, course.
+static constexpr const char* markTerm =
+    "COALESCE((SELECT MAX(cs.term_id) FROM enrollments e JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+    "WHERE e.student_id = ? AND cs.course_code = ?), (SELECT term_id FROM current_term))";
+
 void Database::addMarks(const std::string& course_code, const std::string& student_id, const std::string& assignment_name, int total_marks, int obtained_marks) {
-    try {
-        std::string query = "INSERT INTO marks (course_code, student_id, assignment_name, total_marks, obtained_marks) VALUES (?, ?, ?, ?, ?) "
-                            "ON DUPLICATE KEY UPDATE total_marks = VALUES(total_marks), obtained_marks = VALUES(obtained_marks)";
-        session.sql(query).bind(course_code, student_id, assignment_name, total_marks, obtained_marks).execute();
-    }
-    catch (const mysqlx::Error& err) {
-        std::cout << "Error adding marks: " << err.what() << std::endl;
-    }
+    TraceScope trace(TraceMethod::AddMarks, course_code, student_id, assignment_name, total_marks, obtained_marks);
+    if (remote) return remote->call<void>(TraceMethod::AddMarks, course_code, student_id, assignment_name, total_marks, obtained_marks);
+    std::string query = "INSERT INTO marks (course_code, student_id, assignment_name, total_marks, obtained_marks, term_id) "
+                        "VALUES (?, ?, ?, ?, ?, " + std::string(markTerm) + ") "
+                        "ON DUPLICATE KEY UPDATE total_marks = VALUES(total_marks), obtained_marks = VALUES(obtained_marks)";
+    mutate({ChangeFeed::Marks}, [&] {
+        session->sql(query).bind(course_code, student_id, assignment_name, total_marks, obtained_marks, student_id, course_code).execute();
+        logResultsDirty(student_id, course_code);
+        return true;
+    });
 }
 void Database::updateMarks(const std::string& course_code, const std::string& student_id, const std::string& assignment_name, int obtained_marks) {
-    try {
-        std::string query = "UPDATE marks SET obtained_marks = ? WHERE course_code = ? AND student_id = ? AND assignment_name = ?";
-        session.sql(query).bind(obtained_marks, course_code, student_id, assignment_name).execute();
-    }
-    catch (const mysqlx::Error& err) {
-        std::cout << "Error updating marks: " << err.what() << std::endl;
-    }
+    TraceScope trace(TraceMethod::UpdateMarks, course_code, student_id, assignment_name, obtained_marks);
+    if (remote) return remote->call<void>(TraceMethod::UpdateMarks, course_code, student_id, assignment_name, obtained_marks);
+    std::string query = "UPDATE marks SET obtained_marks = ? WHERE course_code = ? AND student_id = ? AND assignment_name = ? "
+                        "AND term_id = " + std::string(markTerm);
+    mutate({ChangeFeed::Marks}, [&] {
+        auto res = session->sql(query).bind(obtained_marks, course_code, student_id, assignment_name, student_id, course_code).execute();
+        if (res.getAffectedItemsCount() == 0)
+            return false;
+        logResultsDirty(student_id, course_code);
+        return true;
+    });
 }
 std::vector<std::string> Database::getAssignmentsForCourse(const std::string& course_code) {
+    TraceScope trace(TraceMethod::GetAssignmentsForCourse, course_code);
+    if (remote) return remote->call<std::vector<std::string>>(TraceMethod::GetAssignmentsForCourse, course_code);
     std::vector<std::string> assignments;
-    std::string query = "SELECT DISTINCT assignment_name FROM marks WHERE course_code = ?";
-    auto res = session.sql(query).bind(course_code).execute();
+    std::string query = "SELECT DISTINCT m.assignment_name FROM marks m "
+                        "JOIN current_term ct ON m.term_id = ct.term_id WHERE m.course_code = ?";
+    auto res = reader().sql(query).bind(course_code).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne())) {
         assignments.push_back(row[0].get<std::string>());
@@ -474,55 +1427,175 @@ std::vector<std::string> Database::getAssignmentsForCourse(const std::string& co
     return assignments;
 }
 std::vector<std::pair<std::string, std::pair<int, int>>> Database::getStudentMarksForAssignment(const std::string& course_code, const std::string& assignment_name) {
+    TraceScope trace(TraceMethod::GetStudentMarksForAssignment, course_code, assignment_name);
+    if (remote) return remote->call<std::vector<std::pair<std::string, std::pair<int, int>>>>(TraceMethod::GetStudentMarksForAssignment, course_code, assignment_name);
     std::vector<std::pair<std::string, std::pair<int, int>>> marks;
-    std::string query = "SELECT student_id, total_marks, obtained_marks FROM marks WHERE course_code = ? AND assignment_name = ?";
-    auto res = session.sql(query).bind(course_code, assignment_name).execute();
+    auto res = reader().sql(catalog::text<catalog::AssignmentMarks>()).bind(course_code, assignment_name).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne())) {
         marks.emplace_back(row[0].get<std::string>(), std::make_pair(row[1].get<int>(), row[2].get<int>()));
     }
     return marks;
 }
+ResultSet Database::fetchStudentMarksForAssignment(const std::string& course_code, const std::string& assignment_name) {
+    TraceScope trace(TraceMethod::FetchStudentMarksForAssignment, course_code, assignment_name);
+    if (remote) return remote->call<ResultSet>(TraceMethod::FetchStudentMarksForAssignment, course_code, assignment_name);
+    auto res = reader().sql(catalog::text<catalog::AssignmentMarks>()).bind(course_code, assignment_name).execute();
+    return ResultSet(res);
+}
 
 std::vector<Database::Mark> Database::getStudentMarks(const std::string& student_id, const std::string& course_code) {
-    std::vector<Mark> result;
-    std::string query =
-        "SELECT m.assignment_name, m.total_marks, m.obtained_marks, c.course_name "
-        "FROM marks m "
-        "JOIN courses c ON m.course_code = c.course_code "
-        "WHERE m.student_id = ?";
-    if (!course_code.empty()) {
-        query += " AND m.course_code = ?";
-    }
-    query += " ORDER BY m.assignment_name";
-    mysqlx::SqlStatement stmt = session.sql(query).bind(student_id);
-    if (!course_code.empty()) {
-        stmt.bind(course_code);
-    }
-    auto res = stmt.execute();
-    mysqlx::Row row;
-    while ((row = res.fetchOne())) {
-        Mark mark;
-        mark.assignment_name = row[0].get<std::string>();
-        mark.total_marks = row[1].get<int>();
-        mark.obtained_marks = row[2].get<int>();
-        mark.course_name = row[3].get<std::string>();
-        result.push_back(mark);
-    }
-    return result;
+    TraceScope trace(TraceMethod::GetStudentMarks, student_id, course_code);
+    if (remote) return remote->call<std::vector<Database::Mark>>(TraceMethod::GetStudentMarks, student_id, course_code);
+    if (course_code.empty())
+        return fetchRows<catalog::StudentMarks>(student_id);
+    return fetchRows<catalog::StudentCourseMarks>(student_id, course_code);
+}
+std::vector<Database::Mark> Database::getStudentTermMarks(const std::string& student_id, int term_id) {
+    TraceScope trace(TraceMethod::GetStudentTermMarks, student_id, term_id);
+    auto res = reader().sql("SELECT state FROM terms WHERE term_id = ?").bind(term_id).execute();
+    auto row = res.fetchOne();
+    if (!row)
+        return {};
+    if (row[0].get<std::string>() == "archived")
+        return fetchRows<catalog::StudentArchivedMarks>(term_id, student_id);
+    return fetchRows<catalog::StudentTermMarks>(student_id, term_id);
 }
 std::vector<std::string> Database::getStudentCourses(const std::string& student_id) {
+    TraceScope trace(TraceMethod::GetStudentCourses, student_id);
+    if (remote) return remote->call<std::vector<std::string>>(TraceMethod::GetStudentCourses, student_id);
     std::vector<std::string> result;
     std::string query =
         "SELECT DISTINCT c.course_code, c.course_name "
         "FROM enrollments e "
         "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
         "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
         "WHERE e.student_id = ?";
-    auto res = session.sql(query).bind(student_id).execute();
+    auto res = reader().sql(query).bind(student_id).execute();
     mysqlx::Row row;
     while ((row = res.fetchOne())) {
         result.push_back(row[0].get<std::string>() + " - " + row[1].get<std::string>());
     }
     return result;
 }
+
+namespace {
+
+std::vector<std::pair<std::string, std::string>> distinctCourses(const std::vector<ScheduledCourse>& rows) {
+    std::vector<std::pair<std::string, std::string>> courses;
+    for (const auto& r : rows) {
+        auto same = [&](const auto& c) { return c.first == r.course_code; };
+        if (std::none_of(courses.begin(), courses.end(), same))
+            courses.emplace_back(r.course_code, r.course_name);
+    }
+    return courses;
+}
+
+}
+
+// X DevAPI sessions execute one statement at a time, so the screen's
+// independent reads share a single read-only transaction instead: that keeps
+// them on one consistent snapshot, and the dependent per-course lookups the
+// menus used to make are answered from the rows already fetched. With
+// replicas the whole snapshot, versions included, is taken on one of them.
+Database::StudentDashboard Database::loadStudentDashboard(const std::string& student_id) {
+    TraceScope trace(TraceMethod::LoadStudentDashboard, student_id);
+    if (remote) return remote->call<Database::StudentDashboard>(TraceMethod::LoadStudentDashboard, student_id);
+    StudentDashboard dash;
+    mysqlx::Session& snapshot = reader();
+    snapshot.sql("START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY").execute();
+    pinned = &snapshot;
+    try {
+        dash.versions = changeVersions();
+        fetchStudentSlices(student_id, dash, true, true, true);
+        pinned = nullptr;
+        snapshot.sql("COMMIT").execute();
+    }
+    catch (...) {
+        pinned = nullptr;
+        try { snapshot.sql("ROLLBACK").execute(); } catch (...) {}
+        throw;
+    }
+    return dash;
+}
+Database::FacultyDashboard Database::loadFacultyDashboard(int facultyId) {
+    TraceScope trace(TraceMethod::LoadFacultyDashboard, facultyId);
+    if (remote) return remote->call<Database::FacultyDashboard>(TraceMethod::LoadFacultyDashboard, facultyId);
+    FacultyDashboard dash;
+    mysqlx::Session& snapshot = reader();
+    snapshot.sql("START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY").execute();
+    pinned = &snapshot;
+    try {
+        dash.versions = changeVersions();
+        fetchFacultySlices(facultyId, dash, true, true);
+        pinned = nullptr;
+        snapshot.sql("COMMIT").execute();
+    }
+    catch (...) {
+        pinned = nullptr;
+        try { snapshot.sql("ROLLBACK").execute(); } catch (...) {}
+        throw;
+    }
+    return dash;
+}
+
+// The versions are read before the slices, so a write that lands in between
+// is picked up again by the next refresh rather than missed.
+bool Database::refreshStudentDashboard(const std::string& student_id, StudentDashboard& dash) {
+    ChangeVersions now = changeVersions();
+    bool profile = now.changedSince(dash.versions, {ChangeFeed::Students});
+    bool enrolled = now.changedSince(dash.versions, {ChangeFeed::Enrollments, ChangeFeed::Waitlist, ChangeFeed::Schedule,
+                                                     ChangeFeed::Courses, ChangeFeed::Faculty, ChangeFeed::Classrooms,
+                                                     ChangeFeed::Timeslots});
+    bool marks = now.changedSince(dash.versions, {ChangeFeed::Marks, ChangeFeed::Courses});
+    if (!profile && !enrolled && !marks)
+        return false;
+    if (remote) {
+        dash = loadStudentDashboard(student_id);
+        return true;
+    }
+    fetchStudentSlices(student_id, dash, profile, enrolled, marks);
+    dash.versions = now;
+    return true;
+}
+bool Database::refreshFacultyDashboard(int facultyId, FacultyDashboard& dash) {
+    ChangeVersions now = changeVersions();
+    bool timetable = now.changedSince(dash.versions, {ChangeFeed::Schedule, ChangeFeed::Courses, ChangeFeed::Faculty,
+                                                      ChangeFeed::Classrooms, ChangeFeed::Timeslots});
+    bool enrollment = now.changedSince(dash.versions, {ChangeFeed::Enrollments, ChangeFeed::Schedule});
+    if (!timetable && !enrollment)
+        return false;
+    if (remote) {
+        dash = loadFacultyDashboard(facultyId);
+        return true;
+    }
+    fetchFacultySlices(facultyId, dash, timetable, enrollment);
+    dash.versions = now;
+    return true;
+}
+
+void Database::fetchStudentSlices(const std::string& student_id, StudentDashboard& dash, bool profile, bool enrolled, bool marks) {
+    if (profile) {
+        auto res = reader().sql(catalog::text<catalog::StudentProfile>()).bind(student_id).execute();
+        if (auto row = res.fetchOne()) {
+            dash.semester = row[0].get<int>();
+            dash.degree = row[1].get<std::string>();
+        }
+    }
+    if (enrolled) {
+        dash.enrolled = fetchRows<catalog::EnrolledCourses>(student_id);
+        dash.waitlists = fetchRows<catalog::StudentWaitlists>(student_id);
+        dash.courses = distinctCourses(dash.enrolled);
+    }
+    if (marks)
+        dash.marks = fetchRows<catalog::StudentMarks>(student_id);
+}
+void Database::fetchFacultySlices(int facultyId, FacultyDashboard& dash, bool timetable, bool enrollment) {
+    if (timetable) {
+        dash.timetable = fetchRows<catalog::FacultyTimetable>(facultyId);
+        dash.courses = distinctCourses(dash.timetable);
+    }
+    if (enrollment)
+        dash.enrollment = fetchRows<catalog::FacultyCourseEnrollment>(facultyId);
+}
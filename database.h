@@ -1,7 +1,18 @@
 #pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 #include <mysqlx/xdevapi.h>
+#include "resultset.h"
 
 struct ScheduledCourse {
     int schedule_id;
@@ -11,14 +22,253 @@ struct ScheduledCourse {
     std::string room_id, room_number, building;
 };
 
+struct EnrolledTimetableRow : ScheduledCourse {
+    std::string student_id;
+};
+
+struct StudentCourse {
+    std::string student_id, course_code;
+};
+
+struct Classroom {
+    std::string room_id, building, room_number;
+    int capacity;
+    std::string room_type;
+};
+
+// One row of a student's waitlists; position 1 is next in line.
+struct WaitlistEntry {
+    int schedule_id;
+    std::string course_code, course_name;
+    int position;
+};
+
+struct MarkRecord {
+    std::string course_code, student_id, assignment_name;
+    int total_marks, obtained_marks;
+    std::string department;
+    int credits, semester;                  // of the course
+    int term_id;
+};
+
+// An academic term. Sections and marks belong to one; only the newest open
+// term is current. A closed term takes no more enrollments, and an archived
+// one has been moved out of the live tables by Database::archiveTerm.
+struct Term {
+    int term_id;
+    std::string name, state;                // "open", "closed" or "archived"
+};
+
+struct TermArchiveSummary {
+    std::size_t sections = 0, enrollments = 0, marks = 0;
+    double seconds = 0.0;
+};
+
+// A student's graded course, as stored in course_results by cms_cli results.
+struct CourseResult {
+    std::string student_id, course_code;
+    int term_id = 0;
+    int semester = 0, credits = 0;
+    double percent = 0.0;
+    std::string letter;
+    double points = 0.0;
+};
+
+struct DatabaseConfig {
+    std::string host = "127.0.0.1";
+    int port = 33060;
+    std::string user = "root";
+    std::string password = "Sufian312";
+    std::string schema = "project_db";
+    // When set, every Database call in the process is captured to this file
+    // (see trace.h) for later replay with cms_replay.
+    std::string tracePath;
+    // When set, the student and faculty calls go to the cms_serviced socket
+    // at this path instead of opening a MySQL session.
+    std::string serviceSocket;
+    // Read replicas of host as "host:port", with the same user, password
+    // and schema. When set, read-only calls go to them in turn and writes,
+    // and everything inside a transaction, to host. Reading one's own writes
+    // relies on GTIDs, so host needs gtid_mode=ON.
+    std::vector<std::string> replicas;
+    // How long a read waits for its replica to apply this process's last
+    // write before it is sent to the primary instead. A replica that times
+    // out is then skipped for 30 seconds.
+    double replicaWaitSeconds = 1.0;
+
+    // base overridden by CMS_DB_HOST, CMS_DB_PORT, CMS_DB_USER,
+    // CMS_DB_PASSWORD, CMS_DB_NAME, CMS_DB_REPLICAS (comma-separated),
+    // CMS_DB_REPLICA_WAIT, CMS_TRACE and CMS_SERVICE when set.
+    static DatabaseConfig fromEnvironment(DatabaseConfig base);
+};
+
+// Slices of data tracked in the change_versions table. Every mutating
+// Database method bumps the feeds it touches in the same transaction as the
+// write, so a client that remembers the versions it last saw can tell which
+// slices are stale with one small query.
+enum class ChangeFeed { Students, Faculty, Courses, Classrooms, Timeslots, Schedule, Enrollments, Marks, Waitlist, Results, Terms, Count };
+
+struct ChangeVersions {
+    std::array<std::uint64_t, static_cast<std::size_t>(ChangeFeed::Count)> version{};
+
+    std::uint64_t operator[](ChangeFeed feed) const { return version[static_cast<std::size_t>(feed)]; }
+    bool changedSince(const ChangeVersions& older, std::initializer_list<ChangeFeed> feeds) const;
+};
+
+class ServiceClient;
+
 class Database {
-    mysqlx::Session session;
-    mysqlx::Schema db;
+    // Unset while the Database talks to cms_serviced; the calls that are not
+    // served there fail instead of touching it.
+    template <typename T>
+    class Local {
+        std::optional<T> value;
+
+    public:
+        template <typename... Args>
+        void emplace(Args&&... args) { value.emplace(std::forward<Args>(args)...); }
+        explicit operator bool() const { return value.has_value(); }
+        T* operator->() {
+            if (!value) throw std::runtime_error("Not available through the enrollment service");
+            return &*value;
+        }
+        T& operator*() { return *operator->(); }
+    };
+
+    Local<mysqlx::Session> session;
+    Local<mysqlx::Schema> db;
+    std::unique_ptr<ServiceClient> remote;
+    std::string schemaName;
+
+    // Reads go to replicas once they have applied the read floor, the
+    // primary's GTID set as of this Database's last write or version check,
+    // so a caller always reads its own writes and never data older than
+    // versions it has seen. The floor is read under its mutex so it only
+    // moves forward, also when connections share it.
+    struct ReadFloor {
+        std::mutex mutex;
+        std::string gtids;
+    };
+    struct Replica {
+        std::string address;
+        std::unique_ptr<mysqlx::Session> session;   // unset when unreachable
+        std::string applied;                        // a read floor it has reached
+        // Until then reads skip it: it last failed to reach the floor in time.
+        std::chrono::steady_clock::time_point laggingUntil;
+    };
+    // How long a replica that timed out is left out of reads.
+    static constexpr std::chrono::seconds laggingBackoff{30};
+    std::vector<Replica> replicas;
+    std::size_t nextReplica = 0;
+    double replicaWait = 1.0;
+    std::shared_ptr<ReadFloor> readFloor = std::make_shared<ReadFloor>();
+    // A read-only snapshot every read joins until it ends.
+    mysqlx::Session* pinned = nullptr;
+
+    mysqlx::Session& reader();
+    mysqlx::Table readTable(const char* name);
+    void advanceReadFloor();
+
+    template <typename Fn>
+    bool mutate(std::initializer_list<ChangeFeed> feeds, Fn&& fn);
+    void bumpVersions(const std::vector<ChangeFeed>& feeds);
+    int transactionDepth = 0;
+    bool rollbackOnly = false;
+
+    using Rows = std::vector<std::vector<mysqlx::Value>>;
+    static constexpr std::size_t batchRows = 500;
+    void insertRows(const char* table, std::initializer_list<const char*> columns, const Rows& rows);
+    void deleteWhereIn(const char* table, const char* column, const std::vector<mysqlx::Value>& keys);
+    void removeSectionsWhere(const char* column, const std::vector<mysqlx::Value>& keys);
+    int fillFromWaitlist(int schedule_id, int& promoted);
+    void logResultsDirty(const std::string& student_id, const std::string& course_code);
+
+    template <typename Query, typename... Args>
+    std::vector<typename Query::Row> fetchRows(Args&&... args);
+    template <typename Query, typename... Args>
+    void streamRows(const std::function<void(typename Query::Row&)>& fn, Args&&... args);
+
+    // Timeslots as of timeslotCacheVersion of the Timeslots feed, so writes
+    // from other processes invalidate it too.
+    std::vector<std::pair<int, std::string>> timeslotCache;
+    std::optional<std::uint64_t> timeslotCacheVersion;
 
 public:
+    explicit Database(const DatabaseConfig& config);
     Database(const std::string& host, const std::string& user, const std::string& pass, const std::string& dbname);
     ~Database();
 
+    bool usesService() const { return remote != nullptr; }
+
+    // Schema changes this build relies on are numbered and applied once, in
+    // order, by migrate(), which records them in schema_version. Connecting
+    // only checks that record and fails on a schema that is behind.
+    static constexpr int schemaVersion = 2;
+    // Brings the schema up to schemaVersion; returns the version it was at.
+    static int migrate(const DatabaseConfig& config);
+    struct ReplicaStatus {
+        std::string address;
+        bool reachable = false;
+        bool caughtUp = false;          // read back a write made just before
+        double seconds = 0.0;           // spent waiting for it
+    };
+    // Makes this connection read the other's writes too, and the other
+    // this one's: cms_serviced serves a client from any pooled connection.
+    void shareReadFloor(Database& with) { readFloor = with.readFloor; }
+    // Writes a probe row on the primary and reads it back from every
+    // replica, the way reads after a write are routed.
+    std::vector<ReplicaStatus> checkReplicas();
+    // Through cms_serviced, enrollment adds, drops and waitlist joins may
+    // wait for admission; listener hears the queue position meanwhile, on
+    // the thread that made the call. Direct connections never queue.
+    void setQueueListener(std::function<void(std::size_t position, std::size_t depth)> listener);
+    void warmUp();
+    // Refreshes index statistics of the application tables; one line of
+    // server output per table.
+    std::vector<std::string> analyzeTables();
+
+    // Unit of work for bulk edits. Mutations are buffered and written by
+    // commit() as multi-row statements, in one transaction together with the
+    // change-version bumps. Destroying it uncommitted, or a failing commit,
+    // rolls everything back. A Transaction opened while another is active
+    // joins it, and the outer commit fails if any inner one was abandoned.
+    class Transaction {
+    public:
+        explicit Transaction(Database& db);
+        ~Transaction();
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        // An empty password gets the one resetStudentPassword and
+        // resetFacultyPassword set.
+        void addStudent(const std::string& id, const std::string& fname, const std::string& lname, const std::string& email, const std::string& degree, int semester, const std::string& password = std::string());
+        void removeStudent(const std::string& id);
+        void addFaculty(int faculty_id, const std::string& fname, const std::string& lname, const std::string& email, const std::string& degree, const std::string& qualification, const std::string& expertise_sub, const std::string& designation, const std::string& password = std::string());
+        void removeFaculty(int faculty_id);
+        void addCourse(const std::string& code, const std::string& name, int credits, int sem, const std::string& dept, int max, const std::string& prereq);
+        void removeCourse(const std::string& code);
+        void addCourseSchedule(const std::string& course_code, int faculty_id, int timeslot_id, const std::string& room_id);
+        void removeCourseSchedule(int schedule_id);
+
+        void touch(std::initializer_list<ChangeFeed> feeds);
+        std::size_t pending() const;
+        void commit();
+
+    private:
+        Database& db;
+        bool outer;
+        bool done = false;
+        std::array<bool, static_cast<std::size_t>(ChangeFeed::Count)> touched{};
+        Rows students, faculty, courses, schedules;
+        std::vector<mysqlx::Value> removedStudents, removedFaculty, removedCourses, removedSchedules;
+
+        void flush();
+        void abandon();
+    };
+
+    static const char* feedName(ChangeFeed feed);
+    ChangeVersions changeVersions();
+
     bool studentExists(const std::string& studentId);
     bool validateStudentPassword(const std::string& studentId, const std::string& password);
     bool changeStudentPassword(const std::string& studentId, const std::string& newPassword);
@@ -39,7 +289,58 @@ public:
     bool hasClash(const std::string& studentId, int timeslot_id);
     bool addEnrollment(const std::string& studentId, int schedule_id);
     bool dropEnrollment(const std::string& studentId, int schedule_id);
+    // Sections keep an ordered waitlist. A seat freed by a drop goes to the
+    // first waiting student without a timeslot clash, in the drop's own
+    // transaction; students who clash keep their place. addEnrollment does
+    // not let newcomers take a seat ahead of an eligible waiting student.
+    // joinWaitlist returns the student's place in line, 0 when they hold a
+    // seat in the section after the call, or -1 when there is no such
+    // section.
+    int joinWaitlist(const std::string& studentId, int schedule_id);
+    bool leaveWaitlist(const std::string& studentId, int schedule_id);
+    std::vector<WaitlistEntry> getStudentWaitlists(const std::string& studentId);
     std::vector<ScheduledCourse> getEnrolledCourses(const std::string& studentId);
+    void streamEnrolledTimetables(const std::function<void(EnrolledTimetableRow&)>& fn);
+    void streamScheduledCourses(const std::function<void(ScheduledCourse&)>& fn);
+    // Current-term sections with their students, grouped by section; see
+    // catalog::rosterSelect. These back the admin removal previews.
+    std::vector<EnrolledTimetableRow> getScheduleRoster(int schedule_id);
+    std::vector<EnrolledTimetableRow> getTimeslotRosters(int timeslot_id);
+    std::vector<EnrolledTimetableRow> getClassroomRosters(const std::string& room_id);
+    std::vector<EnrolledTimetableRow> getFacultyRosters(int faculty_id);
+    std::vector<EnrolledTimetableRow> getCourseRosters(const std::string& course_code);
+    // Ordered by course, student, term, assignment.
+    void streamMarks(const std::function<void(MarkRecord&)>& fn);
+    // Each course a student is enrolled in once, ordered by student.
+    void streamStudentCourses(const std::function<void(StudentCourse&)>& fn);
+    void streamClassrooms(const std::function<void(Classroom&)>& fn);
+
+    // addMarks and updateMarks log the student/course pair they touch, so a
+    // grading run can regrade only those. resultsDirtyMark() is the newest
+    // log entry; streamDirtyMarks() streams, in streamMarks order, every mark
+    // of the pairs logged up to it.
+    std::uint64_t resultsDirtyMark();
+    void streamDirtyMarks(std::uint64_t upTo, const std::function<void(MarkRecord&)>& fn);
+    // Writes a grading run in one transaction. A full run replaces the rows
+    // of every term not yet archived; an incremental one the rows of the
+    // pairs logged up to upTo, and both clear the log up to upTo.
+    void storeCourseResults(const std::vector<CourseResult>& results, bool full, std::uint64_t upTo);
+    std::vector<CourseResult> getCourseResults(const std::string& studentId);
+
+    // Terms. The student, faculty and scheduling views only see sections of
+    // the current term, the newest open one; 0 when none is open. New
+    // sections join the current term, and marks the term of the student's
+    // section of the course.
+    int currentTerm();
+    std::vector<Term> getTerms();
+    int startTerm(const std::string& name);
+    // Stops enrollment changes in the term and drops its waitlists.
+    bool closeTerm(int term_id);
+    // Moves a closed term's sections, enrollments and marks into the
+    // compressed archive tables in one transaction. Fails while marks of
+    // the term are waiting to be graded, so its course_results are final;
+    // those stay in place and transcripts keep showing them.
+    TermArchiveSummary archiveTerm(int term_id);
 
     bool isAdminPasswordCorrect(const std::string& password);
 
@@ -56,6 +357,8 @@ public:
     void removeTimeslot(int timeslot_id);
 
     std::vector<std::pair<std::string, std::string>> getUnscheduledCourses();
+    std::vector<std::pair<std::string, std::string>> getAllCourses();
+    std::vector<std::pair<int, std::string>> getAllFaculty();
     std::vector<std::pair<int, std::string>> getAllTimeslots();
     std::vector<std::pair<std::string, std::string>> getAvailableRooms(int timeslot_id);
     std::vector<std::pair<int, std::string>> getAvailableFaculty(int timeslot_id);
@@ -65,6 +368,8 @@ public:
         std::string course_code, course_name, faculty_name, room, timeslot;
     };
     std::vector<ScheduledAssignment> getAllCourseSchedules();
+    std::vector<ScheduledAssignment> getCourseSchedulesPage(int afterScheduleId, int limit);
+    // Removes the section and its enrollments in one transaction.
     void removeCourseSchedule(int schedule_id);
 
     std::vector<std::string> getFacultyCourses(int facultyId);
@@ -76,7 +381,28 @@ public:
         int semester;
         std::string degree;
     };
+    std::vector<StudentInfo> getAllStudents();
+    // What removeStudent deletes along with the student.
+    struct StudentFootprint {
+        std::string student_id;
+        std::string name;
+        int enrollments;
+        int waitlists;
+        int marks;
+        int results;
+    };
+    std::optional<StudentFootprint> getStudentFootprint(const std::string& studentId);
+    struct FacultyInfo {
+        int faculty_id;
+        std::string first_name;
+        std::string last_name;
+        std::string email;
+    };
+    // Every student by id and every faculty member by id, one row at a time.
+    void streamStudents(const std::function<void(StudentInfo&)>& fn);
+    void streamFaculty(const std::function<void(FacultyInfo&)>& fn);
     std::vector<StudentInfo> getEnrolledStudentsInCourse(const std::string& course_code);
+    std::vector<StudentInfo> getEnrolledStudentsPage(const std::string& course_code, const std::string& afterStudentId, int limit);
     std::vector<ScheduledCourse> getFacultyTimetable(int facultyId);
     int getTotalEnrolledStudents(const std::string& course_code);
 
@@ -84,13 +410,52 @@ public:
     void updateMarks(const std::string& course_code, const std::string& student_id, const std::string& assignment_name, int obtained_marks);
     std::vector<std::string> getAssignmentsForCourse(const std::string& course_code);
     std::vector<std::pair<std::string, std::pair<int, int>>> getStudentMarksForAssignment(const std::string& course_code, const std::string& assignment_name);
+    ResultSet fetchStudentMarksForAssignment(const std::string& course_code, const std::string& assignment_name);
 
     struct Mark {
         std::string assignment_name;
         int total_marks;
         int obtained_marks;
         std::string course_name;
+        std::string course_code;
     };
     std::vector<Mark> getStudentMarks(const std::string& student_id, const std::string& course_code = "");
+    // A student's marks in one term, from the live or the archive tables,
+    // whichever hold it.
+    std::vector<Mark> getStudentTermMarks(const std::string& student_id, int term_id);
     std::vector<std::string> getStudentCourses(const std::string& student_id);
+
+    struct CourseEnrollment {
+        std::string course_code;
+        int students;
+    };
+    // Everything the student and faculty menus show, read in one transaction
+    // so every view of a screen sees the same snapshot. Course lists are
+    // derived from the timetable instead of being queried again.
+    struct StudentDashboard {
+        int semester = 0;
+        std::string degree;
+        std::vector<ScheduledCourse> enrolled;
+        std::vector<WaitlistEntry> waitlists;
+        std::vector<std::pair<std::string, std::string>> courses;
+        std::vector<Mark> marks;
+        ChangeVersions versions;
+    };
+    struct FacultyDashboard {
+        std::vector<ScheduledCourse> timetable;
+        std::vector<std::pair<std::string, std::string>> courses;
+        std::vector<CourseEnrollment> enrollment;
+        ChangeVersions versions;
+    };
+    StudentDashboard loadStudentDashboard(const std::string& student_id);
+    FacultyDashboard loadFacultyDashboard(int facultyId);
+    // Refetch only the slices whose feeds moved since dash was loaded.
+    // Returns false, after a single version query, when nothing changed.
+    // Through the service a relevant change reloads the whole dashboard.
+    bool refreshStudentDashboard(const std::string& student_id, StudentDashboard& dash);
+    bool refreshFacultyDashboard(int facultyId, FacultyDashboard& dash);
+
+private:
+    void fetchStudentSlices(const std::string& student_id, StudentDashboard& dash, bool profile, bool enrolled, bool marks);
+    void fetchFacultySlices(int facultyId, FacultyDashboard& dash, bool timetable, bool enrollment);
 };
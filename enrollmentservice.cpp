@@ -0,0 +1,509 @@
+#include "enrollmentservice.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+
+WorkStealingPool::WorkStealingPool(unsigned workers)
+{
+    for (unsigned i = 0; i < workers; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < workers; ++i)
+        threads.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    Queue& q = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    wake.notify_one();
+}
+
+bool WorkStealingPool::take(unsigned worker, Task& task)
+{
+    const std::size_t n = queues.size();
+    for (std::size_t k = 0; k < n; ++k) {
+        Queue& q = *queues[(worker + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty())
+            continue;
+        if (k == 0) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        } else {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        --queued;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::work(unsigned worker)
+{
+    for (;;) {
+        Task task;
+        if (take(worker, task)) {
+            task(worker);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued <= 0)
+            return;
+    }
+}
+
+namespace {
+
+// Reads Args in order (braced initialisation is sequenced), calls fn and
+// appends its result, if any.
+template <typename... Args, typename Fn>
+void serve(wire::Reader& in, wire::Writer& out, Fn&& fn)
+{
+    std::tuple<Args...> args{in.read<Args>()...};
+    using R = decltype(std::apply(fn, args));
+    if constexpr (std::is_void_v<R>)
+        std::apply(fn, args);
+    else
+        out.put(std::apply(fn, args));
+}
+
+using S = std::string;
+
+std::string errorReply(const std::string& message)
+{
+    wire::Writer out;
+    out.put(wire::replyError);
+    out.put(message);
+    return out.bytes;
+}
+
+}
+
+bool EnrollmentService::isRead(TraceMethod method)
+{
+    switch (method) {
+    case TraceMethod::ChangeStudentPassword:
+    case TraceMethod::ChangeFacultyPassword:
+    case TraceMethod::AddEnrollment:
+    case TraceMethod::DropEnrollment:
+    case TraceMethod::JoinWaitlist:
+    case TraceMethod::LeaveWaitlist:
+    case TraceMethod::AddMarks:
+    case TraceMethod::UpdateMarks:
+        return false;
+    default:
+        return true;
+    }
+}
+
+std::string EnrollmentService::execute(Database& db, const std::string& request)
+{
+    wire::Writer out;
+    out.put(wire::replyOk);
+    try {
+        wire::Reader in(request);
+        auto method = static_cast<TraceMethod>(in.read<std::uint64_t>());
+        switch (method) {
+        case TraceMethod::StudentExists:
+            serve<S>(in, out, [&](const S& id) { return db.studentExists(id); }); break;
+        case TraceMethod::ValidateStudentPassword:
+            serve<S, S>(in, out, [&](const S& id, const S& pw) { return db.validateStudentPassword(id, pw); }); break;
+        case TraceMethod::ChangeStudentPassword:
+            serve<S, S>(in, out, [&](const S& id, const S& pw) { return db.changeStudentPassword(id, pw); }); break;
+        case TraceMethod::GetStudentSemester:
+            serve<S>(in, out, [&](const S& id) { return db.getStudentSemester(id); }); break;
+        case TraceMethod::GetStudentDegree:
+            serve<S>(in, out, [&](const S& id) { return db.getStudentDegree(id); }); break;
+        case TraceMethod::FacultyExists:
+            serve<S>(in, out, [&](const S& email) { return db.facultyExists(email); }); break;
+        case TraceMethod::ValidateFacultyPassword:
+            serve<S, S>(in, out, [&](const S& email, const S& pw) { return db.validateFacultyPassword(email, pw); }); break;
+        case TraceMethod::GetFacultyId:
+            serve<S>(in, out, [&](const S& email) { return db.getFacultyId(email); }); break;
+        case TraceMethod::GetFacultyName:
+            serve<S>(in, out, [&](const S& email) { return db.getFacultyName(email); }); break;
+        case TraceMethod::ChangeFacultyPassword:
+            serve<S, S>(in, out, [&](const S& email, const S& pw) { return db.changeFacultyPassword(email, pw); }); break;
+        case TraceMethod::GetAvailableScheduledCourses:
+            serve<int, S>(in, out, [&](int sem, const S& degree) { return db.getAvailableScheduledCourses(sem, degree); }); break;
+        case TraceMethod::IsAlreadyEnrolled:
+            serve<S, int>(in, out, [&](const S& id, int sid) { return db.isAlreadyEnrolled(id, sid); }); break;
+        case TraceMethod::HasClash:
+            serve<S, int>(in, out, [&](const S& id, int ts) { return db.hasClash(id, ts); }); break;
+        case TraceMethod::AddEnrollment:
+            serve<S, int>(in, out, [&](const S& id, int sid) { return db.addEnrollment(id, sid); }); break;
+        case TraceMethod::DropEnrollment:
+            serve<S, int>(in, out, [&](const S& id, int sid) { return db.dropEnrollment(id, sid); }); break;
+        case TraceMethod::JoinWaitlist:
+            serve<S, int>(in, out, [&](const S& id, int sid) { return db.joinWaitlist(id, sid); }); break;
+        case TraceMethod::LeaveWaitlist:
+            serve<S, int>(in, out, [&](const S& id, int sid) { return db.leaveWaitlist(id, sid); }); break;
+        case TraceMethod::GetStudentWaitlists:
+            serve<S>(in, out, [&](const S& id) { return db.getStudentWaitlists(id); }); break;
+        case TraceMethod::GetCourseResults:
+            serve<S>(in, out, [&](const S& id) { return db.getCourseResults(id); }); break;
+        case TraceMethod::GetEnrolledCourses:
+            serve<S>(in, out, [&](const S& id) { return db.getEnrolledCourses(id); }); break;
+        case TraceMethod::GetFacultyTimetable:
+            serve<int>(in, out, [&](int fid) { return db.getFacultyTimetable(fid); }); break;
+        case TraceMethod::GetFacultyCourses:
+            serve<int>(in, out, [&](int fid) { return db.getFacultyCourses(fid); }); break;
+        case TraceMethod::GetEnrolledStudentsInCourse:
+            serve<S>(in, out, [&](const S& code) { return db.getEnrolledStudentsInCourse(code); }); break;
+        case TraceMethod::GetEnrolledStudentsPage:
+            serve<S, S, int>(in, out, [&](const S& code, const S& after, int limit) {
+                return db.getEnrolledStudentsPage(code, after, limit);
+            });
+            break;
+        case TraceMethod::GetTotalEnrolledStudents:
+            serve<S>(in, out, [&](const S& code) { return db.getTotalEnrolledStudents(code); }); break;
+        case TraceMethod::AddMarks:
+            serve<S, S, S, int, int>(in, out, [&](const S& code, const S& id, const S& name, int total, int obtained) {
+                db.addMarks(code, id, name, total, obtained);
+            });
+            break;
+        case TraceMethod::UpdateMarks:
+            serve<S, S, S, int>(in, out, [&](const S& code, const S& id, const S& name, int obtained) {
+                db.updateMarks(code, id, name, obtained);
+            });
+            break;
+        case TraceMethod::GetAssignmentsForCourse:
+            serve<S>(in, out, [&](const S& code) { return db.getAssignmentsForCourse(code); }); break;
+        case TraceMethod::GetStudentMarksForAssignment:
+            serve<S, S>(in, out, [&](const S& code, const S& name) { return db.getStudentMarksForAssignment(code, name); }); break;
+        case TraceMethod::FetchStudentMarksForAssignment:
+            serve<S, S>(in, out, [&](const S& code, const S& name) { return db.fetchStudentMarksForAssignment(code, name); }); break;
+        case TraceMethod::GetStudentMarks:
+            serve<S, S>(in, out, [&](const S& id, const S& code) { return db.getStudentMarks(id, code); }); break;
+        case TraceMethod::GetStudentCourses:
+            serve<S>(in, out, [&](const S& id) { return db.getStudentCourses(id); }); break;
+        case TraceMethod::LoadStudentDashboard:
+            serve<S>(in, out, [&](const S& id) { return db.loadStudentDashboard(id); }); break;
+        case TraceMethod::LoadFacultyDashboard:
+            serve<int>(in, out, [&](int fid) { return db.loadFacultyDashboard(fid); }); break;
+        case TraceMethod::ChangeVersions:
+            serve<>(in, out, [&]() { return db.changeVersions(); }); break;
+        default:
+            throw std::runtime_error(std::string(traceMethodName(method)) + " is not served by the enrollment service");
+        }
+    }
+    catch (const std::exception& e) {
+        out.bytes.clear();
+        out.put(wire::replyError);
+        out.put(std::string(e.what()));
+    }
+    return out.bytes;
+}
+
+EnrollmentService::EnrollmentService(const DatabaseConfig& config, unsigned connections, const AdmissionLimits& limits)
+    : admission(std::make_unique<AdmissionControl>(limits))
+{
+    DatabaseConfig direct = config;
+    direct.serviceSocket.clear();
+    for (unsigned i = 0; i < std::max(1u, connections); ++i) {
+        this->connections.push_back(std::make_unique<Database>(direct));
+        this->connections.back()->shareReadFloor(*this->connections.front());
+    }
+    pool = std::make_unique<WorkStealingPool>(static_cast<unsigned>(this->connections.size()));
+}
+
+EnrollmentService::~EnrollmentService()
+{
+    admission.reset();
+    pool.reset();
+}
+
+EnrollmentServiceStats EnrollmentService::stats() const
+{
+    return {clientCount, requestCount, coalescedCount, errorCount, admission->stats()};
+}
+
+void EnrollmentService::respond(Client& client, const std::string& reply)
+{
+    if (!reply.empty() && reply[0] == static_cast<char>(wire::replyError))
+        ++errorCount;
+    std::lock_guard<std::mutex> lock(client.writeMutex);
+    if (client.closed)
+        return;
+    // A send error or a client that stopped reading ends the connection; the
+    // poll thread then sees the hangup and closes it.
+    wire::appendFrame(client.output, reply);
+    if (!wire::sendPending(client.fd, client.output) || client.output.size() > maxBacklog) {
+        client.output.clear();
+        ::shutdown(client.fd, SHUT_RDWR);
+    }
+}
+
+void EnrollmentService::close(Client& client)
+{
+    std::lock_guard<std::mutex> lock(client.writeMutex);
+    if (!client.closed) {
+        ::close(client.fd);
+        client.closed = true;
+    }
+}
+
+void EnrollmentService::submitWrite(const std::shared_ptr<Client>& client, std::string request)
+{
+    pool->submit([this, client, request = std::move(request)](unsigned worker) {
+        Database& db = *connections[worker];
+        std::string reply;
+        try {
+            wire::Reader in(request);
+            const auto method = static_cast<TraceMethod>(in.read<std::uint64_t>());
+            if ((method == TraceMethod::AddMarks || method == TraceMethod::UpdateMarks) &&
+                !teaches(db, *client, in.read<std::string>()))
+                reply = errorReply("You can only enter marks for courses you teach.");
+        }
+        catch (const std::exception& e) {
+            reply = errorReply(e.what());
+        }
+        if (reply.empty()) {
+            reply = execute(db, request);
+            ++writeEpoch;
+        }
+        respond(*client, reply);
+    });
+}
+
+// Student writes carry the student ID and faculty password changes the
+// email as their first argument; marks need a faculty login here and are
+// checked against that member's courses by teaches() on the worker.
+bool EnrollmentService::authorized(Client& client, TraceMethod method, const std::string& subject)
+{
+    std::lock_guard<std::mutex> lock(client.sessionMutex);
+    switch (method) {
+    case TraceMethod::ChangeStudentPassword:
+    case TraceMethod::AddEnrollment:
+    case TraceMethod::DropEnrollment:
+    case TraceMethod::JoinWaitlist:
+    case TraceMethod::LeaveWaitlist:
+        return !client.student.empty() && subject == client.student;
+    case TraceMethod::ChangeFacultyPassword:
+        return !client.faculty.empty() && subject == client.faculty;
+    case TraceMethod::AddMarks:
+    case TraceMethod::UpdateMarks:
+        return !client.faculty.empty();
+    default:
+        return false;
+    }
+}
+
+// Runs on a pool worker, since it needs a connection.
+bool EnrollmentService::teaches(Database& db, Client& client, const std::string& courseCode)
+{
+    std::string email;
+    {
+        std::lock_guard<std::mutex> lock(client.sessionMutex);
+        email = client.faculty;
+    }
+    const std::string facultyId = email.empty() ? std::string() : db.getFacultyId(email);
+    if (facultyId.empty())
+        return false;
+    const std::string prefix = courseCode + " - ";
+    for (const auto& course : db.getFacultyCourses(std::stoi(facultyId)))
+        if (course.compare(0, prefix.size(), prefix) == 0)
+            return true;
+    return false;
+}
+
+// A successful Validate*Password logs its clients in as that ID, a failed
+// one logs them out.
+void EnrollmentService::recordLogin(TraceMethod method, const std::string& request, const std::string& reply,
+                                    const std::vector<std::shared_ptr<Client>>& clients)
+{
+    if (method != TraceMethod::ValidateStudentPassword && method != TraceMethod::ValidateFacultyPassword)
+        return;
+    std::string who;
+    bool valid = false;
+    try {
+        wire::Reader in(request);
+        in.read<std::uint64_t>();
+        who = in.read<std::string>();
+        wire::Reader out(reply);
+        valid = out.read<std::uint64_t>() == wire::replyOk && out.read<bool>();
+    }
+    catch (const std::exception&) {
+        return;
+    }
+    for (const auto& client : clients) {
+        std::lock_guard<std::mutex> lock(client->sessionMutex);
+        std::string& slot = method == TraceMethod::ValidateStudentPassword ? client->student : client->faculty;
+        slot = valid ? who : std::string();
+    }
+}
+
+void EnrollmentService::handle(const std::shared_ptr<Client>& client, std::string request)
+{
+    ++requestCount;
+    TraceMethod method = TraceMethod::Count;
+    std::string subject;
+    try {
+        wire::Reader in(request);
+        method = static_cast<TraceMethod>(in.read<std::uint64_t>());
+        if (!isRead(method))
+            subject = in.read<std::string>();
+    }
+    catch (const std::exception&) {
+    }
+
+    if (!isRead(method) && !authorized(*client, method, subject)) {
+        respond(*client, errorReply("Your session has expired; please log in again."));
+        return;
+    }
+
+    if (method == TraceMethod::AddEnrollment || method == TraceMethod::DropEnrollment ||
+        method == TraceMethod::JoinWaitlist) {
+        const std::string& student = subject;
+        auto progress = [this, client](std::size_t position, std::size_t depth) {
+            wire::Writer out;
+            out.put(wire::replyQueued);
+            out.put(static_cast<std::uint64_t>(position));
+            out.put(static_cast<std::uint64_t>(depth));
+            respond(*client, out.bytes);
+        };
+        if (!admission->enqueue(student, [this, client, request]() { submitWrite(client, request); }, progress)) {
+            respond(*client, errorReply("Registration is busy right now; please try again in a minute."));
+        }
+        return;
+    }
+    if (!isRead(method)) {
+        submitWrite(client, std::move(request));
+        return;
+    }
+
+    std::shared_ptr<Pending> mine;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        auto it = pending.find(request);
+        if (it != pending.end() && it->second->epoch == writeEpoch) {
+            it->second->waiters.push_back(client);
+            ++coalescedCount;
+            return;
+        }
+        mine = std::make_shared<Pending>(Pending{writeEpoch, {client}});
+        pending[request] = mine;
+    }
+    pool->submit([this, mine, method, request = std::move(request)](unsigned worker) {
+        std::string reply = execute(*connections[worker], request);
+        std::vector<std::shared_ptr<Client>> waiters;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            auto it = pending.find(request);
+            if (it != pending.end() && it->second == mine)
+                pending.erase(it);
+            waiters.swap(mine->waiters);
+        }
+        recordLogin(method, request, reply, waiters);
+        for (const auto& waiter : waiters)
+            respond(*waiter, reply);
+    });
+}
+
+void EnrollmentService::run(const std::string& socketPath, const MetricsCallback& metrics)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Service socket path too long: " + socketPath);
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    // The socket is created owner-only: it carries password changes, so only
+    // the account running cms_serviced and the GUI may connect.
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str());
+    const mode_t mask = ::umask(0177);
+    const bool bound = listener >= 0 && ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    ::umask(mask);
+    if (!bound || ::chmod(socketPath.c_str(), 0600) < 0 || ::listen(listener, SOMAXCONN) < 0) {
+        std::string reason = std::strerror(errno);
+        if (listener >= 0) ::close(listener);
+        throw std::runtime_error("Cannot listen on " + socketPath + ": " + reason);
+    }
+
+    std::vector<pollfd> fds{{listener, POLLIN, 0}};
+    std::vector<std::shared_ptr<Client>> clients{nullptr};
+    auto nextMetrics = std::chrono::steady_clock::now() + metricsEvery;
+    while (!stopRequested) {
+        if (metrics && std::chrono::steady_clock::now() >= nextMetrics) {
+            metrics(stats());
+            nextMetrics += metricsEvery;
+        }
+        for (std::size_t i = 1; i < fds.size(); ++i) {
+            std::lock_guard<std::mutex> lock(clients[i]->writeMutex);
+            fds[i].events = clients[i]->output.empty() ? POLLIN : POLLIN | POLLOUT;
+        }
+        if (::poll(fds.data(), fds.size(), 250) < 0 && errno != EINTR)
+            break;
+        for (std::size_t i = fds.size(); i-- > 1;) {
+            if (!fds[i].revents)
+                continue;
+            Client& client = *clients[i];
+            bool open = true;
+            if (fds[i].revents & POLLOUT) {
+                std::lock_guard<std::mutex> lock(client.writeMutex);
+                open = wire::sendPending(client.fd, client.output);
+            }
+            if (open && (fds[i].revents & ~POLLOUT)) {
+                open = client.input.receive(client.fd);
+                std::string request;
+                while (client.input.next(request))
+                    handle(clients[i], std::move(request));
+            }
+            if (open)
+                continue;
+            close(client);
+            fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i));
+            clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0 && ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+                ::close(fd);
+                fd = -1;
+            }
+            if (fd >= 0) {
+                fds.push_back({fd, POLLIN, 0});
+                clients.push_back(std::make_shared<Client>(fd));
+                ++clientCount;
+            }
+        }
+        for (auto& p : fds)
+            p.revents = 0;
+    }
+
+    for (std::size_t i = 1; i < clients.size(); ++i)
+        close(*clients[i]);
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+}
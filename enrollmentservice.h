@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "admission.h"
+#include "database.h"
+#include "servicewire.h"
+#include "trace.h"
+
+// Fixed set of workers, each with its own task deque. A worker serves its own
+// deque oldest first and, when that is empty, steals the newest task of the
+// others, so one slow query does not hold up the requests queued behind it
+// and requests are still answered roughly in arrival order.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(unsigned worker)>;
+
+    explicit WorkStealingPool(unsigned workers);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+    void submit(Task task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> nextQueue{0};
+    std::atomic<long> queued{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    bool take(unsigned worker, Task& task);
+    void work(unsigned worker);
+};
+
+struct EnrollmentServiceStats {
+    std::uint64_t clients = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t coalesced = 0;
+    std::uint64_t errors = 0;
+    AdmissionStats admission;
+};
+
+// Local daemon in front of the database (cms_serviced). Clients connect to a
+// Unix socket and send the student and faculty Database calls (see
+// servicewire.h); they are run on a work-stealing pool, one pooled Database
+// connection per worker. A read that arrives while an identical one is still
+// queued or running shares its answer, unless a write has completed since
+// that one was accepted. Writes are refused unless the connection has
+// logged in, through Validate*Password, as the student or faculty member
+// they act for, and marks only for courses that faculty member teaches this
+// term. Enrollment adds, drops and waitlist joins pass
+// AdmissionControl first; while they wait the client receives its queue
+// position.
+class EnrollmentService {
+public:
+    using MetricsCallback = std::function<void(const EnrollmentServiceStats&)>;
+
+    EnrollmentService(const DatabaseConfig& config, unsigned connections, const AdmissionLimits& limits = AdmissionLimits());
+    ~EnrollmentService();
+
+    // Serves until stop(), calling metrics every metricsEvery; throws when
+    // the socket cannot be opened.
+    void run(const std::string& socketPath, const MetricsCallback& metrics = MetricsCallback());
+    // Safe to call from a signal handler.
+    void stop() { stopRequested = true; }
+    EnrollmentServiceStats stats() const;
+
+    static bool isRead(TraceMethod method);
+    static std::string execute(Database& db, const std::string& request);
+
+private:
+    // Client sockets are non-blocking: the poll thread reassembles request
+    // frames in input, and replies wait in output, under writeMutex, for as
+    // long as the socket will not take them.
+    struct Client {
+        explicit Client(int fd) : fd(fd) {}
+        int fd;
+        wire::FrameReader input;
+        std::mutex writeMutex;
+        std::string output;
+        bool closed = false;
+        // Who last proved their password on this connection; writes are
+        // only accepted on behalf of them.
+        std::mutex sessionMutex;
+        std::string student;
+        std::string faculty;
+    };
+    struct Pending {
+        std::uint64_t epoch;
+        std::vector<std::shared_ptr<Client>> waiters;
+    };
+
+    static constexpr auto metricsEvery = std::chrono::seconds(10);
+    // Unsent replies beyond this mean the client has stopped reading.
+    static constexpr std::size_t maxBacklog = 128u << 20;
+
+    std::vector<std::unique_ptr<Database>> connections;
+    std::unique_ptr<WorkStealingPool> pool;
+    std::unique_ptr<AdmissionControl> admission;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<std::uint64_t> writeEpoch{0};
+
+    std::mutex pendingMutex;
+    std::unordered_map<std::string, std::shared_ptr<Pending>> pending;
+
+    std::atomic<std::uint64_t> clientCount{0};
+    std::atomic<std::uint64_t> requestCount{0};
+    std::atomic<std::uint64_t> coalescedCount{0};
+    std::atomic<std::uint64_t> errorCount{0};
+
+    static bool authorized(Client& client, TraceMethod method, const std::string& subject);
+    static bool teaches(Database& db, Client& client, const std::string& courseCode);
+    static void recordLogin(TraceMethod method, const std::string& request, const std::string& reply,
+                            const std::vector<std::shared_ptr<Client>>& clients);
+
+    void handle(const std::shared_ptr<Client>& client, std::string request);
+    void submitWrite(const std::shared_ptr<Client>& client, std::string request);
+    void respond(Client& client, const std::string& reply);
+    void close(Client& client);
+};
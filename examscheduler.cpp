@@ -0,0 +1,551 @@
+#include "examscheduler.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::size_t popcount(std::uint64_t word)
+{
+    return std::bitset<64>(word).count();
+}
+
+// Students of one course as the non-zero 64-bit words of a bitset over all
+// students, with their word indexes. Built by appending students in
+// increasing order.
+struct SparseBitset {
+    std::vector<std::uint32_t> blocks;
+    std::vector<std::uint64_t> bits;
+
+    void set(std::uint32_t i)
+    {
+        if (blocks.empty() || blocks.back() != i / 64) {
+            blocks.push_back(i / 64);
+            bits.push_back(0);
+        }
+        bits.back() |= std::uint64_t(1) << (i % 64);
+    }
+
+    std::size_t count() const
+    {
+        std::size_t n = 0;
+        for (std::uint64_t word : bits)
+            n += popcount(word);
+        return n;
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (std::size_t k = 0; k < blocks.size(); ++k)
+            for (std::uint64_t word = bits[k]; word; word &= word - 1)
+                fn(blocks[k] * 64 + static_cast<std::uint32_t>(popcount((word & (~word + 1)) - 1)));
+    }
+};
+
+struct Room {
+    std::string id;
+    int capacity;
+};
+
+struct Problem {
+    std::vector<std::string> codes;
+    std::vector<SparseBitset> members;                          // students per course
+    std::vector<int> size;
+    std::vector<std::vector<std::pair<int, int>>> adjacent;     // (course, shared students)
+    std::vector<long long> weight;                              // shared students over all neighbours
+    std::vector<Room> rooms;                                    // by descending capacity
+    int totalCapacity = 0;
+    std::size_t students = 0;
+    int slotsPerDay = 0;
+
+    bool consecutive(int a, int b) const
+    {
+        if (a > b)
+            std::swap(a, b);
+        return b - a == 1 && (slotsPerDay <= 0 || a / slotsPerDay == b / slotsPerDay);
+    }
+};
+
+struct State {
+    std::vector<int> slot;                      // per course; -1 until placed
+    std::vector<std::vector<int>> rooms;        // per course, indexes into Problem::rooms
+    std::vector<std::vector<int>> members;      // per slot
+    std::vector<std::vector<char>> used;        // per slot, per room
+    std::vector<int> freeSeats;                 // per slot
+    long long penalty = 0;                      // back-to-back exams
+
+    int slots() const { return static_cast<int>(members.size()); }
+};
+
+// One worker's randomized search; run() leaves its result in state.
+class Search {
+public:
+    Search(const Problem& p, int target, std::uint32_t seed) : p(p), target(target), rng(seed) {}
+
+    State state;
+
+    void run(Clock::time_point deadline)
+    {
+        construct();
+        while ((target <= 0 || state.slots() > target) && eliminateOne(deadline)) {
+        }
+        while (state.slots() < target)
+            addSlot(state);
+        reduceBackToBack(deadline);
+    }
+
+    // Fewest slots (or fewest beyond the target), then fewest back-to-back
+    // exams.
+    bool betterThan(const State& other) const
+    {
+        const int mine = target > 0 ? std::max(0, state.slots() - target) : state.slots();
+        const int theirs = target > 0 ? std::max(0, other.slots() - target) : other.slots();
+        return mine != theirs ? mine < theirs : state.penalty < other.penalty;
+    }
+
+private:
+    const Problem& p;
+    int target;
+    std::mt19937 rng;
+    std::vector<std::uint32_t> mark;
+    std::uint32_t stamp = 0;
+    std::vector<long long> cost;
+    std::vector<int> seats;
+    std::vector<int> neighbours, blocker;
+
+    int courses() const { return static_cast<int>(p.codes.size()); }
+
+    void addSlot(State& st) const
+    {
+        st.members.emplace_back();
+        st.used.emplace_back(p.rooms.size(), 0);
+        st.freeSeats.push_back(p.totalCapacity);
+    }
+
+    // Back-to-back exams course c would have in slot s.
+    long long backToBack(const State& st, int c, int s) const
+    {
+        long long total = 0;
+        for (const auto& [n, w] : p.adjacent[c])
+            if (st.slot[n] >= 0 && p.consecutive(st.slot[n], s))
+                total += w;
+        return total;
+    }
+
+    long long totalBackToBack(const State& st) const
+    {
+        long long total = 0;
+        for (int c = 0; c < courses(); ++c)
+            for (const auto& [n, w] : p.adjacent[c])
+                if (n > c && st.slot[c] >= 0 && st.slot[n] >= 0 && p.consecutive(st.slot[c], st.slot[n]))
+                    total += w;
+        return total;
+    }
+
+    // Marks the slots holding a neighbour of c: slot s is free for c when
+    // mark[s] != stamp.
+    void markNeighbours(const State& st, int c)
+    {
+        mark.resize(st.members.size());
+        if (++stamp == 0) {
+            std::fill(mark.begin(), mark.end(), 0);
+            stamp = 1;
+        }
+        for (const auto& [n, w] : p.adjacent[c])
+            if (st.slot[n] >= 0)
+                mark[st.slot[n]] = stamp;
+    }
+
+    // The smallest free room holding all of c, else the largest free rooms
+    // until it fits. Leaves the rooms in seats.
+    bool fit(const State& st, int s, int c)
+    {
+        seats.clear();
+        const int need = p.size[c];
+        if (st.freeSeats[s] < need)
+            return false;
+        const auto& used = st.used[s];
+        for (std::size_t r = p.rooms.size(); r-- > 0;) {
+            if (!used[r] && p.rooms[r].capacity >= need) {
+                seats.push_back(static_cast<int>(r));
+                return true;
+            }
+        }
+        int seated = 0;
+        for (std::size_t r = 0; r < p.rooms.size() && seated < need; ++r) {
+            if (!used[r]) {
+                seats.push_back(static_cast<int>(r));
+                seated += p.rooms[r].capacity;
+            }
+        }
+        return seated >= need;
+    }
+
+    void place(State& st, int c, int s) const
+    {
+        st.penalty += backToBack(st, c, s);
+        st.slot[c] = s;
+        st.rooms[c] = seats;
+        for (int r : seats) {
+            st.used[s][r] = 1;
+            st.freeSeats[s] -= p.rooms[r].capacity;
+        }
+        st.members[s].push_back(c);
+    }
+
+    void lift(State& st, int c) const
+    {
+        const int s = st.slot[c];
+        st.penalty -= backToBack(st, c, s);
+        for (int r : st.rooms[c]) {
+            st.used[s][r] = 0;
+            st.freeSeats[s] += p.rooms[r].capacity;
+        }
+        st.rooms[c].clear();
+        auto& list = st.members[s];
+        list.erase(std::find(list.begin(), list.end(), c));
+        st.slot[c] = -1;
+    }
+
+    void construct()
+    {
+        const int n = courses();
+        state = State();
+        state.slot.assign(n, -1);
+        state.rooms.assign(n, {});
+
+        std::uniform_real_distribution<double> jitter(0.75, 1.25);
+        std::vector<double> priority(n);
+        for (int c = 0; c < n; ++c)
+            priority[c] = static_cast<double>(p.weight[c] + p.size[c]) * jitter(rng);
+        std::vector<int> saturation(n, 0);
+        std::vector<std::vector<std::uint64_t>> seen(n);
+        std::vector<char> done(n, 0);
+
+        for (int step = 0; step < n; ++step) {
+            int c = -1;
+            for (int i = 0; i < n; ++i)
+                if (!done[i] && (c < 0 || saturation[i] > saturation[c] ||
+                                 (saturation[i] == saturation[c] && priority[i] > priority[c])))
+                    c = i;
+            done[c] = 1;
+            if (p.size[c] > p.totalCapacity)
+                continue;
+
+            markNeighbours(state, c);
+            int s = 0;
+            while (s < state.slots() && (mark[s] == stamp || !fit(state, s, c)))
+                ++s;
+            if (s == state.slots()) {
+                addSlot(state);
+                fit(state, s, c);
+            }
+            place(state, c, s);
+
+            const std::size_t word = static_cast<std::size_t>(s) / 64;
+            const std::uint64_t bit = std::uint64_t(1) << (s % 64);
+            for (const auto& [m, w] : p.adjacent[c]) {
+                if (done[m])
+                    continue;
+                if (seen[m].size() <= word)
+                    seen[m].resize(word + 1, 0);
+                if (!(seen[m][word] & bit)) {
+                    seen[m][word] |= bit;
+                    ++saturation[m];
+                }
+            }
+        }
+    }
+
+    // Places the unplaced course c outside slot s where it adds the fewest
+    // back-to-back exams.
+    bool placeAway(int c, int s)
+    {
+        markNeighbours(state, c);
+        int best = -1;
+        long long bestCost = 0;
+        std::vector<int> bestSeats;
+        for (int t = 0; t < state.slots(); ++t) {
+            if (t == s || mark[t] == stamp || !fit(state, t, c))
+                continue;
+            const long long added = backToBack(state, c, t);
+            if (best < 0 || added < bestCost) {
+                best = t;
+                bestCost = added;
+                bestSeats = seats;
+            }
+        }
+        if (best < 0)
+            return false;
+        seats = std::move(bestSeats);
+        place(state, c, best);
+        return true;
+    }
+
+    // Places c outside slot s in a slot where it has a single neighbour,
+    // which moves to yet another slot.
+    bool placeBumping(int c, int s)
+    {
+        neighbours.assign(state.members.size(), 0);
+        blocker.assign(state.members.size(), -1);
+        for (const auto& [n, w] : p.adjacent[c]) {
+            if (state.slot[n] >= 0) {
+                ++neighbours[state.slot[n]];
+                blocker[state.slot[n]] = n;
+            }
+        }
+        for (int t = 0; t < state.slots(); ++t) {
+            if (t == s || neighbours[t] != 1)
+                continue;
+            const int n = blocker[t];
+            lift(state, n);
+            if (fit(state, t, c)) {
+                place(state, c, t);
+                if (placeAway(n, s))
+                    return true;
+                lift(state, c);
+            }
+            fit(state, t, n);
+            place(state, n, t);
+        }
+        return false;
+    }
+
+    // Moves every course out of slot s into the other slots, largest first,
+    // then drops s.
+    bool dissolve(int s)
+    {
+        State backup = state;
+        std::vector<int> moving = state.members[s];
+        std::sort(moving.begin(), moving.end(), [&](int a, int b) { return p.size[a] > p.size[b]; });
+        for (int c : moving)
+            lift(state, c);
+        for (int c : moving) {
+            if (!placeAway(c, s) && !placeBumping(c, s)) {
+                state = std::move(backup);
+                return false;
+            }
+        }
+
+        state.members.erase(state.members.begin() + s);
+        state.used.erase(state.used.begin() + s);
+        state.freeSeats.erase(state.freeSeats.begin() + s);
+        for (int& slot : state.slot)
+            if (slot > s)
+                --slot;
+        state.penalty = totalBackToBack(state);
+        return true;
+    }
+
+    bool eliminateOne(Clock::time_point deadline)
+    {
+        std::vector<int> order(state.slots());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](int a, int b) { return state.members[a].size() < state.members[b].size(); });
+        for (int s : order) {
+            if (Clock::now() >= deadline)
+                return false;
+            if (dissolve(s))
+                return true;
+        }
+        return false;
+    }
+
+    void reduceBackToBack(Clock::time_point deadline)
+    {
+        std::vector<int> order(courses());
+        std::iota(order.begin(), order.end(), 0);
+        for (bool moved = true; moved && Clock::now() < deadline;) {
+            moved = false;
+            std::shuffle(order.begin(), order.end(), rng);
+            for (int c : order) {
+                const int from = state.slot[c];
+                if (from < 0)
+                    continue;
+                // cost[t]: back-to-back exams c would have in slot t.
+                cost.assign(state.members.size(), 0);
+                for (const auto& [n, w] : p.adjacent[c]) {
+                    const int s = state.slot[n];
+                    if (s < 0)
+                        continue;
+                    if (s > 0 && p.consecutive(s, s - 1))
+                        cost[s - 1] += w;
+                    if (s + 1 < state.slots() && p.consecutive(s, s + 1))
+                        cost[s + 1] += w;
+                }
+                markNeighbours(state, c);
+                int best = from;
+                for (int t = 0; t < state.slots(); ++t)
+                    if (t != from && mark[t] != stamp && cost[t] < cost[best] && fit(state, t, c))
+                        best = t;
+                if (best == from)
+                    continue;
+                fit(state, best, c);
+                lift(state, c);
+                place(state, c, best);
+                moved = true;
+                if (Clock::now() >= deadline)
+                    break;
+            }
+        }
+    }
+};
+
+Problem load(Database& db, int slotsPerDay, unsigned threads)
+{
+    Problem p;
+    p.slotsPerDay = slotsPerDay;
+
+    std::unordered_map<std::string, int> index;
+    std::vector<std::vector<int>> coursesOf;                    // per student
+    std::string current;
+    db.streamStudentCourses([&](StudentCourse& row) {
+        if (coursesOf.empty() || row.student_id != current) {
+            current = std::move(row.student_id);
+            coursesOf.emplace_back();
+        }
+        auto [it, fresh] = index.emplace(row.course_code, static_cast<int>(p.codes.size()));
+        if (fresh) {
+            p.codes.push_back(std::move(row.course_code));
+            p.members.emplace_back();
+        }
+        p.members[it->second].set(static_cast<std::uint32_t>(coursesOf.size() - 1));
+        coursesOf.back().push_back(it->second);
+    });
+    p.students = coursesOf.size();
+
+    db.streamClassrooms([&](Classroom& row) {
+        if (row.capacity > 0) {
+            p.rooms.push_back({std::move(row.room_id), row.capacity});
+            p.totalCapacity += row.capacity;
+        }
+    });
+    std::stable_sort(p.rooms.begin(), p.rooms.end(),
+                     [](const Room& a, const Room& b) { return a.capacity > b.capacity; });
+
+    // Each course's neighbours and shared-student counts, from the courses of
+    // every student in its bitset.
+    const std::size_t n = p.codes.size();
+    p.size.resize(n);
+    p.weight.resize(n);
+    p.adjacent.resize(n);
+    struct Scratch {
+        std::vector<int> shared;
+        std::vector<int> touched;
+    };
+    std::vector<Scratch> scratch(threads);
+    parallelFor(n, threads, [&](std::size_t a, unsigned w) {
+        auto& shared = scratch[w].shared;
+        auto& touched = scratch[w].touched;
+        shared.resize(n, 0);
+        p.members[a].forEach([&](std::uint32_t student) {
+            for (int b : coursesOf[student])
+                if (static_cast<std::size_t>(b) != a && shared[b]++ == 0)
+                    touched.push_back(b);
+        });
+        std::sort(touched.begin(), touched.end());
+        long long total = 0;
+        for (int b : touched) {
+            p.adjacent[a].emplace_back(b, shared[b]);
+            total += shared[b];
+            shared[b] = 0;
+        }
+        touched.clear();
+        p.weight[a] = total;
+        p.size[a] = static_cast<int>(p.members[a].count());
+    });
+    return p;
+}
+
+}
+
+ExamTimetable ExamScheduler::plan(const ExamOptions& options)
+{
+    ExamTimetable timetable;
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    auto started = Clock::now();
+    const Problem p = load(db, options.slotsPerDay, threads);
+    timetable.loadSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+    started = Clock::now();
+
+    const auto deadline = started + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    std::mutex mutex;
+    State best;
+    bool found = false;     // every worker finishes at least one run
+    std::atomic<std::size_t> runs{0};
+    auto worker = [&](unsigned w) {
+        Search search(p, options.slots, options.seed + w * 7919u);
+        do {
+            search.run(deadline);
+            ++runs;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!found || search.betterThan(best)) {
+                best = search.state;
+                found = true;
+            }
+        } while (Clock::now() < deadline);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker, i);
+    worker(0);
+    for (auto& t : pool)
+        t.join();
+
+    timetable.courses = p.codes.size();
+    timetable.students = p.students;
+    for (const auto& list : p.adjacent)
+        timetable.conflicts += list.size();
+    timetable.conflicts /= 2;
+    timetable.backToBack = static_cast<std::size_t>(best.penalty);
+    timetable.runs = runs;
+
+    // Recount from the students themselves: per slot, the union of its
+    // courses' bitsets and the students seen twice in it.
+    const std::size_t words = (p.students + 63) / 64;
+    std::vector<std::vector<std::uint64_t>> inSlot(best.members.size(), std::vector<std::uint64_t>(words, 0));
+    std::vector<std::uint64_t> twice(words, 0), consecutive(words, 0);
+    timetable.slots.resize(best.members.size());
+    for (std::size_t s = 0; s < best.members.size(); ++s) {
+        for (int c : best.members[s]) {
+            const SparseBitset& students = p.members[c];
+            for (std::size_t k = 0; k < students.blocks.size(); ++k) {
+                twice[students.blocks[k]] |= inSlot[s][students.blocks[k]] & students.bits[k];
+                inSlot[s][students.blocks[k]] |= students.bits[k];
+            }
+            ExamSitting sitting{p.codes[c], p.size[c], {}};
+            for (int r : best.rooms[c])
+                sitting.rooms.push_back(p.rooms[r].id);
+            timetable.slots[s].push_back(std::move(sitting));
+        }
+        std::sort(timetable.slots[s].begin(), timetable.slots[s].end(),
+                  [](const ExamSitting& a, const ExamSitting& b) { return a.course_code < b.course_code; });
+        if (s > 0 && p.consecutive(static_cast<int>(s) - 1, static_cast<int>(s)))
+            for (std::size_t k = 0; k < words; ++k)
+                consecutive[k] |= inSlot[s - 1][k] & inSlot[s][k];
+    }
+    for (std::size_t k = 0; k < words; ++k) {
+        timetable.clashes += popcount(twice[k]);
+        timetable.backToBackStudents += popcount(consecutive[k]);
+    }
+    for (std::size_t c = 0; c < p.codes.size(); ++c)
+        if (best.slot[c] < 0)
+            timetable.unplaced.push_back(p.codes[c]);
+    std::sort(timetable.unplaced.begin(), timetable.unplaced.end());
+
+    timetable.solveSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+    return timetable;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "database.h"
+
+struct ExamSitting {
+    std::string course_code;
+    int students = 0;
+    std::vector<std::string> rooms;     // room ids, largest first
+};
+
+struct ExamTimetable {
+    std::vector<std::vector<ExamSitting>> slots;        // in time order
+    std::vector<std::string> unplaced;  // courses larger than all rooms together
+    std::size_t courses = 0, students = 0, conflicts = 0;  // conflict graph: nodes, students, edges
+    std::size_t backToBack = 0;         // exams a student sits in consecutive slots, counted per pair
+    std::size_t backToBackStudents = 0;
+    std::size_t clashes = 0;            // students with two exams in one slot; always 0
+    std::size_t runs = 0;               // search runs across all workers
+    double loadSeconds = 0.0, solveSeconds = 0.0;
+};
+
+struct ExamOptions {
+    int slots = 0;                      // slots to spread the exams over; 0 = as few as possible
+    int slotsPerDay = 0;                // consecutive only within a day; 0 = all slots are consecutive
+    unsigned threads = 0;               // 0 = hardware concurrency
+    double seconds = 2.0;               // search budget; every worker finishes at least one run
+    std::uint32_t seed = 1;
+};
+
+// Final exam timetable from the current enrollments. One pass over
+// enrollments gives every course a sparse bitset of its students, and the
+// conflict graph (courses sharing students, weighted by how many) is built
+// from those in parallel. Each worker thread then repeats a randomized
+// search until the time budget runs out:
+//
+//   - DSatur colouring: the course with the most distinct slots among its
+//     neighbours goes next, into the first slot without a neighbour that
+//     still has room for it;
+//   - slot elimination: the emptiest slots are dissolved into the others
+//     while that stays clash-free and seated;
+//   - back-to-back reduction: courses move to the slot that lowers the
+//     number of students sitting exams in consecutive slots.
+//
+// A course is seated in the smallest free room that holds all of its
+// students, or else across the largest free rooms. The best timetable
+// across workers has the fewest slots, then the fewest back-to-back exams.
+// With options.slots set the search aims for that many slots instead;
+// when it cannot get there the timetable has more.
+class ExamScheduler {
+    Database& db;
+
+public:
+    explicit ExamScheduler(Database& db) : db(db) {}
+
+    ExamTimetable plan(const ExamOptions& options);
+};
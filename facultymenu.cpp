@@ -1,40 +1,44 @@
 #include "facultymenu.h"
+#include "pagedmodels.h"
+#include "timetableexport.h"
+#include "timetablerenderer.h"
+#include "imageassets.h"
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QInputDialog>
 #include <QMessageBox>
+#include <QApplication>
 #include <QFileDialog>
 #include <QPainter>
+#include <QResizeEvent>
 #include <QFont>
 #include <QSet>
 #include <QMap>
 #include <fstream>
 #include <QSpacerItem>
+#include <QDialog>
+#include <QTableView>
+#include <QHeaderView>
+#include <QScrollArea>
 
-FacultyMenu::FacultyMenu(Database *db, QString facultyId, QString facultyName, QString facultyEmail, QWidget *parent)
+static QString toQString(std::string_view sv)
+{
+    return QString::fromUtf8(sv.data(), static_cast<int>(sv.size()));
+}
+
+FacultyMenu::FacultyMenu(Database *db, QWidget *parent)
     : QWidget(parent),
-    db(db),
-    facultyId(std::move(facultyId)),
-    facultyName(std::move(facultyName)),
-    facultyEmail(std::move(facultyEmail))
+    db(db)
 {
     setWindowTitle("Faculty Menu");
     setMinimumSize(1000, 800);
 
-    backgroundImage.load("/Users/sufianzahid/Desktop/Qt/OOP/faculty.jpeg");
+    background = new ScaledBackground(this, AssetPath::facultyBackground, Qt::KeepAspectRatioByExpanding);
 
     titleLabel = new QLabel("FACULTY MENU", this);
     titleLabel->setAlignment(Qt::AlignCenter);
-    titleLabel->setStyleSheet(R"(
-        QLabel {
-            font-family: 'Georgia';
-            font-size: 48px;
-            font-weight: bold;
-            color: white;
-            background: transparent;
-        }
-    )");
+    titleLabel->setObjectName("facultyTitle");
 
     viewEnrolledStudentsBtn = new QPushButton("View Enrolled Students");
     viewTimetableBtn = new QPushButton("View Timetable");
@@ -49,25 +53,8 @@ FacultyMenu::FacultyMenu(Database *db, QString facultyId, QString facultyName, Q
         manageMarksBtn, viewTotalEnrolledBtn, changePasswordBtn, logoutBtn
     };
 
-    QString btnStyle = R"(
-        QPushButton {
-            background-color: rgba(32, 71, 245, 200);
-            color: white;
-            border: none;
-            border-radius: 15px;
-            min-width: 340px;
-            min-height: 48px;
-            font-size: 15px;
-            font-family: 'Arial Black', 'Arial', sans-serif;
-            font-weight: bold;
-        }
-        QPushButton:hover {
-            background-color: rgba(0, 46, 207, 200);
-            font-weight: bold;
-        }
-    )";
     for (QPushButton* btn : buttons) {
-        btn->setStyleSheet(btnStyle);
+        btn->setProperty("menuStyle", "wide");
         btn->setFixedSize(340, 54);
         btn->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     }
@@ -103,13 +90,62 @@ FacultyMenu::FacultyMenu(Database *db, QString facultyId, QString facultyName, Q
     connect(viewTotalEnrolledBtn, &QPushButton::clicked, this, &FacultyMenu::viewTotalEnrolledStudents);
     connect(changePasswordBtn, &QPushButton::clicked, this, &FacultyMenu::changePassword);
     connect(logoutBtn, &QPushButton::clicked, this, &FacultyMenu::logout);
+
+    changePoll.setInterval(changePollMs);
+    connect(&changePoll, &QTimer::timeout, this, &FacultyMenu::pollChanges);
+    changePoll.start();
+}
+
+void FacultyMenu::bindSession(QString facultyId, QString facultyName, QString facultyEmail)
+{
+    this->facultyId = std::move(facultyId);
+    this->facultyName = std::move(facultyName);
+    this->facultyEmail = std::move(facultyEmail);
+    dashboard.reset();
+}
+
+const Database::FacultyDashboard &FacultyMenu::snapshot()
+{
+    if (!dashboard)
+        dashboard = db->loadFacultyDashboard(facultyId.toInt());
+    return *dashboard;
+}
+
+// Keeps the snapshot current while the window is open. Views copy what
+// they still need after showing a dialog, so this may run under one.
+void FacultyMenu::pollChanges()
+{
+    if (!dashboard || !isVisible())
+        return;
+    try {
+        db->refreshFacultyDashboard(facultyId.toInt(), *dashboard);
+    }
+    catch (const std::exception &) {
+        // Try again on the next tick.
+    }
+}
+
+QStringList FacultyMenu::courseItems()
+{
+    QStringList items;
+    for (const auto &c : snapshot().courses)
+        items << QString::fromStdString(c.first + " - " + c.second);
+    return items;
+}
+
+void FacultyMenu::resizeEvent(QResizeEvent *event)
+{
+    background->resized(event->size());
+    QWidget::resizeEvent(event);
 }
 
 void FacultyMenu::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
-    if (!backgroundImage.isNull())
-        painter.drawPixmap(rect(), backgroundImage.scaled(size(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+    if (!background->isNull()) {
+        const QPixmap &bg = background->pixmap();
+        painter.drawPixmap((width() - bg.width()) / 2, (height() - bg.height()) / 2, bg);
+    }
     else
         painter.fillRect(rect(), QColor(245,245,255));
     QWidget::paintEvent(event);
@@ -117,56 +153,50 @@ void FacultyMenu::paintEvent(QPaintEvent *event)
 
 
 void FacultyMenu::viewEnrolledStudents() {
-    auto courses = db->getFacultyCourses(facultyId.toInt());
-    if (courses.empty()) {
+    QStringList items = courseItems();
+    if (items.isEmpty()) {
         QMessageBox::information(this, "Enrolled Students", "You are not assigned to any courses.");
         return;
     }
     bool ok;
-    QStringList items;
-    for (const auto& c : courses) items << QString::fromStdString(c);
     QString selected = QInputDialog::getItem(this, "Enrolled Students", "Select course:", items, 0, false, &ok);
     if (!ok || selected.isEmpty()) return;
     std::string course_code = selected.toStdString().substr(0, selected.indexOf(" - "));
-    auto students = db->getEnrolledStudentsInCourse(course_code);
-    if (students.empty()) {
+    RosterModel model(db, course_code);
+    model.fetchMore(QModelIndex());
+    if (model.rowCount() == 0) {
         QMessageBox::information(this, "Enrolled Students", "No students enrolled in this course.");
         return;
     }
-    QString table = "ID | First Name | Last Name | Email | Sem | Degree\n";
-    for (const auto& s : students)
-        table += QString("%1 | %2 | %3 | %4 | %5 | %6\n")
-                     .arg(QString::fromStdString(s.student_id))
-                     .arg(QString::fromStdString(s.first_name))
-                     .arg(QString::fromStdString(s.last_name))
-                     .arg(QString::fromStdString(s.email))
-                     .arg(QString::number(s.semester))
-                     .arg(QString::fromStdString(s.degree));
-    QMessageBox::information(this, "Enrolled Students", table);
+
+    QDialog dlg(this);
+    dlg.setWindowTitle("Enrolled Students - " + QString::fromStdString(course_code));
+    dlg.resize(800, 500);
+    QVBoxLayout layout(&dlg);
+    QTableView view;
+    view.setModel(&model);
+    view.setSelectionBehavior(QAbstractItemView::SelectRows);
+    view.setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view.horizontalHeader()->setStretchLastSection(true);
+    view.verticalHeader()->setDefaultSectionSize(24);
+    layout.addWidget(&view);
+    QPushButton okBtn("OK");
+    QObject::connect(&okBtn, &QPushButton::clicked, &dlg, &QDialog::accept);
+    layout.addWidget(&okBtn);
+    dlg.exec();
 }
 
 void FacultyMenu::viewTimetable() {
-    auto tt = db->getFacultyTimetable(facultyId.toInt());
+    const auto &tt = snapshot().timetable;
     if (tt.empty()) {
         QMessageBox::information(this, "Timetable", "No classes scheduled.");
         return;
     }
-    QString table = "Course | Name | Day | Start-End | Room | Bldg\n";
-    for (const auto& t : tt) {
-        table += QString("%1 | %2 | %3 | %4-%5 | %6 %7\n")
-        .arg(QString::fromStdString(t.course_code))
-            .arg(QString::fromStdString(t.course_name))
-            .arg(QString::fromStdString(t.day))
-            .arg(QString::fromStdString(t.start_time))
-            .arg(QString::fromStdString(t.end_time))
-            .arg(QString::fromStdString(t.room_number))
-            .arg(QString::fromStdString(t.building));
-    }
-    QMessageBox::information(this, "Timetable", table);
+    showTimetableDialog(this, "Timetable - " + facultyName, tt, false);
 }
 
 void FacultyMenu::exportTimetable() {
-    auto tt = db->getFacultyTimetable(facultyId.toInt());
+    auto tt = snapshot().timetable;
     if (tt.empty()) {
         QMessageBox::information(this, "Export Timetable", "No classes to export.");
         return;
@@ -174,28 +204,22 @@ void FacultyMenu::exportTimetable() {
     QString filename = QFileDialog::getSaveFileName(this, "Export Timetable", "faculty_" + facultyId + "_timetable.csv", "CSV files (*.csv)");
     if (filename.isEmpty()) return;
     std::ofstream out(filename.toStdString());
-    out << "Course,Name,Day,Start,End,Room,Bldg\n";
-    for (const auto& t : tt) {
-        out << t.course_code << "," << t.course_name << "," << t.day << "," << t.start_time << ","
-            << t.end_time << "," << t.room_number << "," << t.building << "\n";
-    }
+    TimetableExporter::writeCsv(out, tt, false);
     out.close();
     QMessageBox::information(this, "Export Timetable", "Timetable exported to " + filename);
 }
 
 void FacultyMenu::manageMarks() {
-    auto courses = db->getFacultyCourses(facultyId.toInt());
-    if (courses.empty()) {
+    QStringList items = courseItems();
+    if (items.isEmpty()) {
         QMessageBox::information(this, "Marks", "You are not assigned to any courses.");
         return;
     }
     bool ok;
-    QStringList items;
-    for (const auto& c : courses) items << QString::fromStdString(c);
     QString selected = QInputDialog::getItem(this, "Marks", "Select course:", items, 0, false, &ok);
     if (!ok || selected.isEmpty()) return;
     std::string course_code = selected.toStdString().substr(0, selected.indexOf(" - "));
-    QStringList actionList = {"Add Marks", "Edit Marks"};
+    QStringList actionList = {"Add Marks", "Edit Marks", "View Statistics"};
     QString action = QInputDialog::getItem(this, "Marks", "Action:", actionList, 0, false, &ok);
     if (!ok || action.isEmpty()) return;
 
@@ -209,9 +233,9 @@ void FacultyMenu::manageMarks() {
             QMessageBox::information(this, "Add Marks", "No students enrolled in this course.");
             return;
         }
-        auto existing = db->getStudentMarksForAssignment(course_code, assignment.toStdString());
+        auto existing = db->fetchStudentMarksForAssignment(course_code, assignment.toStdString());
         QSet<QString> marked;
-        for (const auto& mark : existing) marked.insert(QString::fromStdString(mark.first));
+        for (const auto& mark : existing) marked.insert(toQString(mark[0]));
         QList<QPair<QString, QString>> studentList; 
         for (const auto& student : students) {
             if (marked.contains(QString::fromStdString(student.student_id))) continue;
@@ -230,7 +254,13 @@ void FacultyMenu::manageMarks() {
             int obtained = QInputDialog::getInt(this, "Add Marks",
                                                 QString("Obtained marks for %1:").arg(chosenName), 0, 0, total_marks, 1, &ok);
             if (!ok) continue;
-            db->addMarks(course_code, studentId.toStdString(), assignment.toStdString(), total_marks, obtained);
+            try {
+                db->addMarks(course_code, studentId.toStdString(), assignment.toStdString(), total_marks, obtained);
+            } catch (const std::exception &e) {
+                QMessageBox::warning(this, "Add Marks", QString::fromStdString(e.what()));
+                return;
+            }
+            marks.set(course_code, studentId.toStdString(), assignment.toStdString(), total_marks, obtained);
             studentList.removeAt(idx);
         }
         QMessageBox::information(this, "Add Marks", "Marks entry complete.");
@@ -245,8 +275,8 @@ void FacultyMenu::manageMarks() {
         QString assignment = QInputDialog::getItem(this, "Edit Marks", "Select assignment:", assgnList, 0, false, &ok);
         if (!ok || assignment.isEmpty()) return;
 
-        auto marks = db->getStudentMarksForAssignment(course_code, assignment.toStdString());
-        if (marks.empty()) {
+        auto current = db->getStudentMarksForAssignment(course_code, assignment.toStdString());
+        if (current.empty()) {
             QMessageBox::information(this, "Edit Marks", "No marks for this assignment.");
             return;
         }
@@ -255,30 +285,96 @@ void FacultyMenu::manageMarks() {
         for (const auto& s : all_students)
             idToName[QString::fromStdString(s.student_id)] = QString::fromStdString(s.first_name + " " + s.last_name);
 
-        for (const auto& mark : marks) {
+        for (const auto& mark : current) {
             int newMark = QInputDialog::getInt(this, "Edit Marks",
                                                QString("Current: %1/%2\nStudent: %3\nEnter new obtained marks:")
                                                    .arg(mark.second.second).arg(mark.second.first)
                                                    .arg(idToName[QString::fromStdString(mark.first)]), mark.second.second, 0, mark.second.first, 1, &ok);
             if (!ok) continue;
-            db->updateMarks(course_code, mark.first, assignment.toStdString(), newMark);
+            try {
+                db->updateMarks(course_code, mark.first, assignment.toStdString(), newMark);
+            } catch (const std::exception &e) {
+                QMessageBox::warning(this, "Edit Marks", QString::fromStdString(e.what()));
+                return;
+            }
+            marks.setObtained(course_code, mark.first, assignment.toStdString(), newMark);
         }
         QMessageBox::information(this, "Edit Marks", "Marks updated.");
+    } else if (action == "View Statistics") {
+        showMarkStatistics(course_code);
+    }
+}
+
+static QString statsRow(const QString &name, const MarkStats &s)
+{
+    QString bars;
+    for (std::size_t bin = 0; bin < s.histogram.size(); ++bin)
+        bars += QString("%1:%2 ").arg(bin * 10).arg(s.histogram[bin]);
+    return QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td><td>%5</td><td>%6</td><td>%7</td>"
+                   "<td>%8</td><td>%9</td><td>%10</td></tr>")
+        .arg(name)
+        .arg(s.count)
+        .arg(QString::number(s.mean, 'f', 1))
+        .arg(QString::number(s.median, 'f', 1))
+        .arg(QString::number(s.stddev, 'f', 1))
+        .arg(QString::number(s.p25, 'f', 1))
+        .arg(QString::number(s.p75, 'f', 1))
+        .arg(QString::number(s.min, 'f', 1))
+        .arg(QString::number(s.max, 'f', 1))
+        .arg(bars.trimmed());
+}
+
+void FacultyMenu::showMarkStatistics(const std::string &course_code)
+{
+    marks.loadCourse(*db, course_code);
+    CourseStats stats = marks.courseStats(course_code);
+    if (stats.assignments.empty()) {
+        QMessageBox::information(this, "Statistics", "No marks for this course yet.");
+        return;
     }
+
+    QString html = "<h3>" + QString::fromStdString(course_code) + " - percentages</h3>"
+                   "<table border='1' cellspacing='0' cellpadding='3'><tr><th>Assessment</th><th>Students</th>"
+                   "<th>Mean</th><th>Median</th><th>Std dev</th><th>P25</th><th>P75</th><th>Min</th><th>Max</th>"
+                   "<th>Histogram (from %: count)</th></tr>";
+    for (const auto &assignment : stats.assignments)
+        html += statsRow(QString::fromStdString(assignment.first), assignment.second);
+    html += statsRow("<b>Course</b>", stats.overall) + "</table>";
+
+    html += "<h3>Normalized course scores</h3>"
+            "<table border='1' cellspacing='0' cellpadding='3'><tr><th>Student</th><th>Percent</th><th>z-score</th></tr>";
+    for (const auto &score : marks.normalized(course_code))
+        html += QString("<tr><td>%1</td><td>%2</td><td>%3</td></tr>")
+                    .arg(QString::fromStdString(score.student_id))
+                    .arg(QString::number(score.percent, 'f', 1))
+                    .arg(QString::number(score.z, 'f', 2));
+    html += "</table>";
+
+    QDialog dlg(this);
+    dlg.setWindowTitle("Statistics");
+    QVBoxLayout layout(&dlg);
+    QScrollArea scroll;
+    QLabel label;
+    label.setTextFormat(Qt::RichText);
+    label.setText(html);
+    scroll.setWidget(&label);
+    scroll.setMinimumSize(900, 600);
+    layout.addWidget(&scroll);
+    QPushButton okBtn("OK");
+    QObject::connect(&okBtn, &QPushButton::clicked, &dlg, &QDialog::accept);
+    layout.addWidget(&okBtn);
+    dlg.exec();
 }
 
 void FacultyMenu::viewTotalEnrolledStudents() {
-    auto courses = db->getFacultyCourses(facultyId.toInt());
-    if (courses.empty()) {
+    const auto &enrollment = snapshot().enrollment;
+    if (enrollment.empty()) {
         QMessageBox::information(this, "Total Enrolled", "You are not assigned to any courses.");
         return;
     }
     QString table = "Course | Total Students\n";
-    for (const auto& course : courses) {
-        std::string code = course.substr(0, course.find(" - "));
-        int total = db->getTotalEnrolledStudents(code);
-        table += QString("%1 | %2\n").arg(QString::fromStdString(code)).arg(total);
-    }
+    for (const auto& course : enrollment)
+        table += QString("%1 | %2\n").arg(QString::fromStdString(course.course_code)).arg(course.students);
     QMessageBox::information(this, "Total Enrolled", table);
 }
 
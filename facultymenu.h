@@ -1,20 +1,27 @@
 #pragma once
 #include <QWidget>
 #include <QPixmap>
+#include <QTimer>
+#include <optional>
 #include "database.h"
+#include "markstats.h"
 
 class QLabel;
 class QPushButton;
+class ScaledBackground;
 
 class FacultyMenu : public QWidget
 {
     Q_OBJECT
 
 public:
-    FacultyMenu(Database *db, QString facultyId, QString facultyName, QString facultyEmail, QWidget *parent = nullptr);
+    explicit FacultyMenu(Database *db, QWidget *parent = nullptr);
+
+    void bindSession(QString facultyId, QString facultyName, QString facultyEmail);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
 private:
     Database *db;
@@ -31,9 +38,24 @@ private:
     QPushButton *changePasswordBtn;
     QPushButton *logoutBtn;
 
-    QPixmap backgroundImage;
+    ScaledBackground *background;
+
+    // Shared by the timetable, course and enrollment views until the next
+    // login; changePoll refreshes the slices that change underneath it.
+    std::optional<Database::FacultyDashboard> dashboard;
+    const Database::FacultyDashboard &snapshot();
+
+    static constexpr int changePollMs = 5000;
+    QTimer changePoll;
+    QStringList courseItems();
+
+    // Column copy of the marks of the courses whose statistics were viewed;
+    // kept current by this menu's own mark entry.
+    MarksColumns marks;
+    void showMarkStatistics(const std::string &course_code);
 
 private slots:
+    void pollChanges();
     void viewEnrolledStudents();
     void viewTimetable();
     void exportTimetable();
@@ -0,0 +1,14 @@
+#pragma once
+#include <cctype>
+#include <string>
+
+// A record key (student id, room, course code) as a portable file name:
+// anything but letters, digits, '-' and '_' becomes '_'.
+inline std::string safeFileName(const std::string& key)
+{
+    std::string out = key;
+    for (char& ch : out)
+        if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '-' && ch != '_')
+            ch = '_';
+    return out;
+}
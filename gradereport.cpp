@@ -0,0 +1,114 @@
+#include "gradereport.h"
+#include "filenames.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using CourseMarks = std::pair<std::string, std::vector<MarkRecord>>;
+
+std::string csvField(const std::string& value)
+{
+    if (value.find_first_of(",\"\n") == std::string::npos)
+        return value;
+    std::string quoted = "\"";
+    for (char ch : value) {
+        if (ch == '"') quoted += '"';
+        quoted += ch;
+    }
+    return quoted + "\"";
+}
+
+std::size_t indexOf(const std::vector<std::string>& sorted, const std::string& key)
+{
+    return static_cast<std::size_t>(std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+}
+
+}
+
+CourseGrades GradeReporter::tabulate(const std::string& course_code, const std::vector<MarkRecord>& marks)
+{
+    CourseGrades grades;
+    grades.course_code = course_code;
+    for (const auto& m : marks) {
+        grades.assignments.push_back(m.assignment_name);
+        grades.students.push_back(m.student_id);
+    }
+    for (auto* names : {&grades.assignments, &grades.students}) {
+        std::sort(names->begin(), names->end());
+        names->erase(std::unique(names->begin(), names->end()), names->end());
+    }
+    grades.cells.assign(grades.students.size(), std::vector<std::pair<int, int>>(grades.assignments.size(), {-1, -1}));
+    for (const auto& m : marks)
+        grades.cells[indexOf(grades.students, m.student_id)][indexOf(grades.assignments, m.assignment_name)] =
+            {m.obtained_marks, m.total_marks};
+    return grades;
+}
+
+void GradeReporter::writeCsv(std::ostream& out, const CourseGrades& grades)
+{
+    out << "Student";
+    for (const auto& a : grades.assignments)
+        out << "," << csvField(a);
+    out << ",Obtained,Total,Percent\n";
+    for (std::size_t s = 0; s < grades.students.size(); ++s) {
+        int obtained = 0, total = 0;
+        out << csvField(grades.students[s]);
+        for (const auto& cell : grades.cells[s]) {
+            out << ",";
+            if (cell.first < 0) continue;
+            out << cell.first << "/" << cell.second;
+            obtained += cell.first;
+            total += cell.second;
+        }
+        char percent[16];
+        std::snprintf(percent, sizeof(percent), "%.1f", total ? 100.0 * obtained / total : 0.0);
+        out << "," << obtained << "," << total << "," << percent << "\n";
+    }
+}
+
+GradeReportSummary GradeReporter::writeAll(const GradeReportOptions& options)
+{
+    GradeReportSummary summary;
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<CourseMarks> courses;
+    db.streamMarks([&](MarkRecord& row) {
+        if (courses.empty() || courses.back().first != row.course_code)
+            courses.emplace_back(row.course_code, std::vector<MarkRecord>());
+        courses.back().second.push_back(std::move(row));
+        ++summary.marks;
+    });
+
+    fs::path root(options.directory);
+    std::error_code ec;
+    fs::create_directories(root, ec);
+
+    std::atomic<std::size_t> written{0};
+    std::mutex errorMutex;
+    parallelFor(courses.size(), options.threads, [&](std::size_t i) {
+        const CourseMarks& course = courses[i];
+        fs::path path = root / (safeFileName(course.first) + "_grades.csv");
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            summary.errors.push_back("Cannot write " + path.string());
+            return;
+        }
+        writeCsv(out, tabulate(course.first, course.second));
+        ++written;
+    });
+
+    summary.files = written;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
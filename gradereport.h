@@ -0,0 +1,41 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "database.h"
+
+struct GradeReportOptions {
+    std::string directory;
+    unsigned threads = 0;                   // 0 = hardware concurrency
+};
+
+struct GradeReportSummary {
+    std::size_t files = 0;
+    std::size_t marks = 0;
+    double seconds = 0.0;
+    std::vector<std::string> errors;
+};
+
+// Marks of one course as a student x assignment sheet.
+struct CourseGrades {
+    std::string course_code;
+    std::vector<std::string> assignments;   // sorted
+    std::vector<std::string> students;      // sorted
+    // obtained/total per student row and assignment column, -1 when missing.
+    std::vector<std::vector<std::pair<int, int>>> cells;
+};
+
+// Writes one grade sheet per course with marks. All marks come from one
+// streaming query ordered by course; the sheets are built and written by a
+// pool of worker threads, the same way TimetableExporter does timetables.
+class GradeReporter {
+    Database& db;
+
+public:
+    explicit GradeReporter(Database& db) : db(db) {}
+
+    GradeReportSummary writeAll(const GradeReportOptions& options);
+
+    static CourseGrades tabulate(const std::string& course_code, const std::vector<MarkRecord>& marks);
+    static void writeCsv(std::ostream& out, const CourseGrades& grades);
+};
@@ -0,0 +1,188 @@
+#include "grading.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+bool startsWithNoCase(const std::string& text, const std::string& prefix)
+{
+    if (prefix.size() > text.size())
+        return false;
+    for (std::size_t i = 0; i < prefix.size(); ++i)
+        if (std::tolower(static_cast<unsigned char>(text[i])) != std::tolower(static_cast<unsigned char>(prefix[i])))
+            return false;
+    return true;
+}
+
+}
+
+GradingPolicy GradingPolicy::standard()
+{
+    GradingPolicy policy;
+    policy.bands = {
+        {85, "A", 4.0}, {80, "A-", 3.67}, {75, "B+", 3.33}, {71, "B", 3.0},
+        {68, "B-", 2.67}, {64, "C+", 2.33}, {61, "C", 2.0}, {58, "C-", 1.67},
+        {54, "D+", 1.33}, {50, "D", 1.0}, {0, "F", 0.0},
+    };
+    return policy;
+}
+
+GradingPolicy GradingPolicy::parse(std::istream& in)
+{
+    GradingPolicy policy = standard();
+    std::vector<GradeBand> bands;
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind))
+            continue;
+        std::string name, rest;
+        bool ok = false;
+        if (kind == "weight") {
+            double weight = 0;
+            ok = static_cast<bool>(fields >> name >> weight) && weight >= 0;
+            if (ok)
+                policy.weights.emplace_back(name, weight);
+        } else if (kind == "grade") {
+            GradeBand band;
+            ok = static_cast<bool>(fields >> band.letter >> band.minPercent >> band.points);
+            if (ok)
+                bands.push_back(band);
+        }
+        if (!ok || fields >> rest)
+            throw std::runtime_error("Bad grading policy line " + std::to_string(number) + ": " + line);
+    }
+    if (!bands.empty()) {
+        std::sort(bands.begin(), bands.end(),
+                  [](const GradeBand& a, const GradeBand& b) { return a.minPercent > b.minPercent; });
+        policy.bands = std::move(bands);
+    }
+    return policy;
+}
+
+GradingPolicy GradingPolicy::fromFile(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("Cannot open grading policy " + path);
+    return parse(in);
+}
+
+double GradingPolicy::coursePercent(const std::vector<MarkRecord>& marks) const
+{
+    std::vector<long long> obtained(weights.size()), total(weights.size());
+    long long allObtained = 0, allTotal = 0;
+    for (const auto& m : marks) {
+        allObtained += m.obtained_marks;
+        allTotal += m.total_marks;
+        for (std::size_t w = 0; w < weights.size(); ++w) {
+            if (weights[w].first == "*" || startsWithNoCase(m.assignment_name, weights[w].first)) {
+                obtained[w] += m.obtained_marks;
+                total[w] += m.total_marks;
+                break;
+            }
+        }
+    }
+    double weighted = 0.0, weightSum = 0.0;
+    for (std::size_t w = 0; w < weights.size(); ++w) {
+        if (total[w] <= 0)
+            continue;
+        weighted += weights[w].second * static_cast<double>(obtained[w]) / static_cast<double>(total[w]);
+        weightSum += weights[w].second;
+    }
+    if (weightSum > 0.0)
+        return 100.0 * weighted / weightSum;
+    return allTotal > 0 ? 100.0 * static_cast<double>(allObtained) / static_cast<double>(allTotal) : 0.0;
+}
+
+const GradeBand& GradingPolicy::band(double percent) const
+{
+    for (const auto& b : bands)
+        if (percent >= b.minPercent)
+            return b;
+    return bands.back();
+}
+
+CourseResult GradingPolicy::grade(const std::vector<MarkRecord>& marks) const
+{
+    CourseResult result;
+    if (marks.empty())
+        return result;
+    result.student_id = marks.front().student_id;
+    result.course_code = marks.front().course_code;
+    result.term_id = marks.front().term_id;
+    result.semester = marks.front().semester;
+    result.credits = marks.front().credits;
+    result.percent = coursePercent(marks);
+    const GradeBand& b = band(result.percent);
+    result.letter = b.letter;
+    result.points = b.points;
+    return result;
+}
+
+Transcript Transcript::of(std::vector<CourseResult> courses)
+{
+    Transcript transcript;
+    std::sort(courses.begin(), courses.end(), [](const CourseResult& a, const CourseResult& b) {
+        if (a.semester != b.semester) return a.semester < b.semester;
+        return a.course_code != b.course_code ? a.course_code < b.course_code : a.term_id < b.term_id;
+    });
+    double points = 0.0;
+    for (std::size_t i = 0; i < courses.size(); ++i) {
+        const CourseResult& c = courses[i];
+        // A retaken course counts once, at its latest attempt.
+        if (i + 1 < courses.size() && courses[i + 1].course_code == c.course_code)
+            continue;
+        if (transcript.semesters.empty() || transcript.semesters.back().semester != c.semester)
+            transcript.semesters.push_back({c.semester, 0, 0.0});
+        SemesterGpa& term = transcript.semesters.back();
+        term.gpa += c.points * c.credits;
+        term.credits += c.credits;
+        points += c.points * c.credits;
+        transcript.credits += c.credits;
+    }
+    for (auto& term : transcript.semesters)
+        term.gpa = term.credits > 0 ? term.gpa / term.credits : 0.0;
+    transcript.cgpa = transcript.credits > 0 ? points / transcript.credits : 0.0;
+    transcript.courses = std::move(courses);
+    return transcript;
+}
+
+GradingRunSummary GradingEngine::run(bool full, unsigned threads)
+{
+    GradingRunSummary summary;
+    summary.full = full;
+    auto started = std::chrono::steady_clock::now();
+
+    // Pairs logged after this point are left for the next run.
+    const std::uint64_t upTo = db.resultsDirtyMark();
+    std::vector<std::vector<MarkRecord>> pairs;
+    auto collect = [&](MarkRecord& row) {
+        if (pairs.empty() || pairs.back().front().course_code != row.course_code ||
+            pairs.back().front().student_id != row.student_id || pairs.back().front().term_id != row.term_id)
+            pairs.emplace_back();
+        pairs.back().push_back(std::move(row));
+        ++summary.marks;
+    };
+    if (full)
+        db.streamMarks(collect);
+    else if (upTo > 0)
+        db.streamDirtyMarks(upTo, collect);
+    else
+        return summary;
+
+    std::vector<CourseResult> results(pairs.size());
+    parallelFor(pairs.size(), threads, [&](std::size_t i) { results[i] = policy.grade(pairs[i]); });
+
+    db.storeCourseResults(results, full, upTo);
+    summary.results = results.size();
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "database.h"
+
+struct GradeBand {
+    double minPercent;
+    std::string letter;
+    double points;
+};
+
+// How marks turn into a course grade. An assignment belongs to the first
+// weight whose category its name starts with (case-insensitive); "*" matches
+// the rest. A course percentage is the weighted mean of its categories'
+// obtained/total ratios over the categories it has marks in. Without weights,
+// or when none of a course's assignments match, every mark counts by its
+// total.
+struct GradingPolicy {
+    std::vector<std::pair<std::string, double>> weights;
+    std::vector<GradeBand> bands;                       // by descending minPercent
+
+    static GradingPolicy standard();
+    // Lines of "weight CATEGORY PERCENT" and "grade LETTER MIN_PERCENT POINTS";
+    // '#' starts a comment. Grade lines replace the standard scale. Throws
+    // std::runtime_error naming the line on a malformed entry.
+    static GradingPolicy parse(std::istream& in);
+    static GradingPolicy fromFile(const std::string& path);
+
+    double coursePercent(const std::vector<MarkRecord>& marks) const;
+    const GradeBand& band(double percent) const;
+    // marks: one student's marks in one course.
+    CourseResult grade(const std::vector<MarkRecord>& marks) const;
+};
+
+struct SemesterGpa {
+    int semester;
+    int credits;
+    double gpa;
+};
+
+// Credit-weighted GPA per semester and overall from a student's course
+// results. courses keeps every attempt; only the latest term's result of a
+// retaken course counts towards the GPAs and credits.
+struct Transcript {
+    std::vector<CourseResult> courses;
+    std::vector<SemesterGpa> semesters;
+    int credits = 0;
+    double cgpa = 0.0;
+
+    static Transcript of(std::vector<CourseResult> courses);
+};
+
+struct GradingRunSummary {
+    bool full = false;
+    std::size_t marks = 0;
+    std::size_t results = 0;
+    double seconds = 0.0;
+};
+
+// Batch grader behind cms_cli results. A full run grades every student and
+// course from one streaming read of marks; an incremental run only the
+// student/course pairs whose marks changed since the last run. Each pair is
+// graded once per term it has marks in, on a pool of worker threads, and
+// the results are written to course_results in one transaction.
+class GradingEngine {
+    Database& db;
+    GradingPolicy policy;
+
+public:
+    GradingEngine(Database& db, GradingPolicy policy) : db(db), policy(std::move(policy)) {}
+
+    GradingRunSummary run(bool full, unsigned threads);
+};
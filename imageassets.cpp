@@ -0,0 +1,140 @@
+#include "imageassets.h"
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWidget>
+
+static QString tierKey(const QString &path, QSize size, Qt::AspectRatioMode mode)
+{
+    return QString("%1|%2x%3|%4").arg(path).arg(size.width()).arg(size.height()).arg(int(mode));
+}
+
+ImageAssets &ImageAssets::instance()
+{
+    static ImageAssets assets;
+    return assets;
+}
+
+QImage ImageAssets::image(const QString &path)
+{
+    QMutexLocker lock(&imageMutex);
+    while (decoding.contains(path))
+        decoded.wait(&imageMutex);
+    auto it = images.find(path);
+    if (it != images.end())
+        return it.value();
+
+    decoding.insert(path);
+    lock.unlock();
+    QImage result(path);
+    lock.relock();
+    images.insert(path, result);
+    decoding.remove(path);
+    decoded.wakeAll();
+    return result;
+}
+
+void ImageAssets::preload(const QStringList &paths)
+{
+    for (const QString &path : paths)
+        QThreadPool::globalInstance()->start([this, path]() { image(path); });
+}
+
+QPixmap ImageAssets::findTier(const QString &path, QSize size, Qt::AspectRatioMode mode)
+{
+    auto it = tiers.find(path);
+    if (it == tiers.end())
+        return QPixmap();
+    QList<Tier> &list = it.value();
+    for (int i = 0; i < list.size(); ++i) {
+        if (list[i].size == size && list[i].mode == mode) {
+            if (i != 0)
+                list.move(i, 0);
+            return list.front().pixmap;
+        }
+    }
+    return QPixmap();
+}
+
+void ImageAssets::storeTier(const QString &path, QSize size, Qt::AspectRatioMode mode, const QPixmap &pixmap)
+{
+    QList<Tier> &list = tiers[path];
+    list.prepend({size, mode, pixmap});
+    while (list.size() > maxTiers)
+        list.removeLast();
+}
+
+QPixmap ImageAssets::scaledNow(const QString &path, QSize size, Qt::AspectRatioMode mode)
+{
+    QPixmap cached = findTier(path, size, mode);
+    if (!cached.isNull())
+        return cached;
+    QImage source = image(path);
+    if (source.isNull())
+        return QPixmap();
+    QPixmap scaled = QPixmap::fromImage(source.scaled(size, mode, Qt::SmoothTransformation));
+    storeTier(path, size, mode, scaled);
+    return scaled;
+}
+
+QPixmap ImageAssets::cachedOrFast(const QString &path, QSize size, Qt::AspectRatioMode mode)
+{
+    QPixmap cached = findTier(path, size, mode);
+    if (!cached.isNull())
+        return cached;
+    auto it = tiers.find(path);
+    if (it != tiers.end() && !it.value().isEmpty())
+        return it.value().front().pixmap.scaled(size, mode, Qt::FastTransformation);
+    QImage source = image(path);
+    if (source.isNull())
+        return QPixmap();
+    return QPixmap::fromImage(source.scaled(size, mode, Qt::FastTransformation));
+}
+
+void ImageAssets::requestScaled(const QString &path, QSize size, Qt::AspectRatioMode mode)
+{
+    if (size.isEmpty() || !findTier(path, size, mode).isNull())
+        return;
+    QString key = tierKey(path, size, mode);
+    if (pending.contains(key))
+        return;
+    pending.insert(key);
+
+    QThreadPool::globalInstance()->start([this, path, size, mode, key]() {
+        QImage scaled = image(path).scaled(size, mode, Qt::SmoothTransformation);
+        QMetaObject::invokeMethod(this, [this, path, size, mode, key, scaled]() {
+            pending.remove(key);
+            if (scaled.isNull())
+                return;
+            storeTier(path, size, mode, QPixmap::fromImage(scaled));
+            emit scaledReady(path, size);
+        }, Qt::QueuedConnection);
+    });
+}
+
+ScaledBackground::ScaledBackground(QWidget *owner, QString path, Qt::AspectRatioMode mode)
+    : QObject(owner), owner(owner), path(std::move(path)), mode(mode)
+{
+    debounce.setSingleShot(true);
+    debounce.setInterval(120);
+    connect(&debounce, &QTimer::timeout, this, [this]() {
+        ImageAssets::instance().requestScaled(this->path, target, this->mode);
+    });
+    connect(&ImageAssets::instance(), &ImageAssets::scaledReady, this, &ScaledBackground::onScaledReady);
+}
+
+void ScaledBackground::resized(QSize size)
+{
+    if (size.isEmpty() || size == target)
+        return;
+    target = size;
+    current = ImageAssets::instance().cachedOrFast(path, size, mode);
+    debounce.start();
+}
+
+void ScaledBackground::onScaledReady(const QString &readyPath, QSize size)
+{
+    if (readyPath != path || size != target)
+        return;
+    current = ImageAssets::instance().cachedOrFast(path, size, mode);
+    owner->update();
+}
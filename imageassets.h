@@ -0,0 +1,90 @@
+#pragma once
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QWaitCondition>
+
+class QWidget;
+
+// Compiled-in assets, see resources.qrc.
+namespace AssetPath {
+constexpr const char *mainBackground = ":/images/main.jpg";
+constexpr const char *adminBackground = ":/images/admin.png";
+constexpr const char *facultyBackground = ":/images/faculty.jpeg";
+constexpr const char *studentBackground = ":/images/student.jpeg";
+constexpr const char *logo = ":/images/logo.png";
+}
+
+// Process-wide cache of decoded background and logo images. Each file is
+// decoded once; a few scaled tiers per image are kept so that painting is a
+// blit of an already scaled pixmap. Smooth rescaling runs on the global
+// thread pool and scaledReady() is emitted on the GUI thread when it lands.
+class ImageAssets : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ImageAssets &instance();
+
+    QImage image(const QString &path);
+    void preload(const QStringList &paths);
+    QPixmap scaledNow(const QString &path, QSize size, Qt::AspectRatioMode mode);
+    QPixmap cachedOrFast(const QString &path, QSize size, Qt::AspectRatioMode mode);
+    void requestScaled(const QString &path, QSize size, Qt::AspectRatioMode mode);
+
+signals:
+    void scaledReady(const QString &path, QSize size);
+
+private:
+    struct Tier {
+        QSize size;
+        Qt::AspectRatioMode mode;
+        QPixmap pixmap;
+    };
+
+    static constexpr int maxTiers = 4;
+
+    ImageAssets() = default;
+    QPixmap findTier(const QString &path, QSize size, Qt::AspectRatioMode mode);
+    void storeTier(const QString &path, QSize size, Qt::AspectRatioMode mode, const QPixmap &pixmap);
+
+    QMutex imageMutex;
+    QWaitCondition decoded;
+    QHash<QString, QImage> images;
+    QSet<QString> decoding;
+    QHash<QString, QList<Tier>> tiers;
+    QSet<QString> pending;
+};
+
+// A widget background backed by ImageAssets. resized() answers immediately
+// with the closest cached tier and, once resizing has been quiet for a moment,
+// asks for a smooth rescale at the final size and repaints the owner.
+class ScaledBackground : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScaledBackground(QWidget *owner, QString path, Qt::AspectRatioMode mode);
+
+    const QPixmap &pixmap() const { return current; }
+    bool isNull() const { return current.isNull(); }
+    void resized(QSize size);
+
+private:
+    void onScaledReady(const QString &path, QSize size);
+
+    QWidget *owner;
+    QString path;
+    Qt::AspectRatioMode mode;
+    QSize target;
+    QPixmap current;
+    QTimer debounce;
+};
@@ -0,0 +1,51 @@
+#include "impactqueries.h"
+#include <algorithm>
+
+std::vector<std::string> Impact::students() const
+{
+    std::vector<std::string> all;
+    for (const auto& s : sections)
+        all.insert(all.end(), s.students.begin(), s.students.end());
+    std::sort(all.begin(), all.end());
+    all.erase(std::unique(all.begin(), all.end()), all.end());
+    return all;
+}
+
+// Rows arrive grouped by section, one per student.
+static Impact collect(std::vector<EnrolledTimetableRow> rows)
+{
+    Impact impact;
+    for (auto& row : rows) {
+        std::string student = std::move(row.student_id);
+        if (impact.sections.empty() || impact.sections.back().section.schedule_id != row.schedule_id)
+            impact.sections.push_back({std::move(static_cast<ScheduledCourse&>(row)), {}});
+        if (!student.empty())
+            impact.sections.back().students.push_back(std::move(student));
+    }
+    return impact;
+}
+
+Impact ImpactQueries::ofSchedule(int schedule_id)
+{
+    return collect(db.getScheduleRoster(schedule_id));
+}
+
+Impact ImpactQueries::ofTimeslot(int timeslot_id)
+{
+    return collect(db.getTimeslotRosters(timeslot_id));
+}
+
+Impact ImpactQueries::ofClassroom(const std::string& room_id)
+{
+    return collect(db.getClassroomRosters(room_id));
+}
+
+Impact ImpactQueries::ofFaculty(int faculty_id)
+{
+    return collect(db.getFacultyRosters(faculty_id));
+}
+
+Impact ImpactQueries::ofCourse(const std::string& course_code)
+{
+    return collect(db.getCourseRosters(course_code));
+}
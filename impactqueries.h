@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "database.h"
+
+struct ImpactedSection {
+    ScheduledCourse section;
+    std::vector<std::string> students;
+};
+
+struct Impact {
+    std::vector<ImpactedSection> sections;
+
+    bool empty() const { return sections.empty(); }
+    // Distinct students across all sections.
+    std::vector<std::string> students() const;
+};
+
+// Answers "what does removing this take with it" for the admin removal
+// previews. Each question is one query on the matching key of
+// course_schedule, joined to its enrollments, so nothing is cached and a
+// preview never rescans the whole schedule.
+class ImpactQueries {
+public:
+    explicit ImpactQueries(Database& db) : db(db) {}
+
+    Impact ofSchedule(int schedule_id);
+    Impact ofTimeslot(int timeslot_id);
+    Impact ofClassroom(const std::string& room_id);
+    Impact ofFaculty(int faculty_id);
+    Impact ofCourse(const std::string& course_code);
+
+private:
+    Database& db;
+};
@@ -0,0 +1,364 @@
+// Headless registration-day simulator. Creates N synthetic students, lets
+// them all loose at the same instant on a pool of worker threads (one
+// Database connection per worker) and has each one log in, browse the courses
+// offered to its degree/semester and enroll in / drop a few sections, joining
+// the waitlist of any section that is full. Reports throughput, latency
+// percentiles and errors per operation, then checks the enrollment and
+// waitlist invariants directly in SQL.
+//
+//   cms_loadsim [--students N] [--threads T] [--courses K] [--drop-rate P]
+//               [--think-ms MS] [--seed S] [--keep]
+//
+// Connection settings come from CMS_DB_HOST / CMS_DB_PORT / CMS_DB_USER /
+// CMS_DB_PASSWORD / CMS_DB_NAME. Synthetic students use the "SIM-" id prefix
+// and are removed again at the end unless --keep is given.
+
+#include "database.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const char* const studentPrefix = "SIM-";
+
+struct Options {
+    int students = 200;
+    unsigned threads = 32;
+    int coursesPerStudent = 4;
+    double dropRate = 0.2;
+    int thinkMs = 0;
+    unsigned seed = 1;
+    bool keep = false;
+};
+
+enum Op { Connect, Login, Browse, Enroll, Drop, OpCount };
+const char* opNames[OpCount] = {"connect", "login", "browse", "enroll", "drop"};
+
+struct Stats {
+    std::array<std::vector<double>, OpCount> latencyMs;
+    std::array<std::size_t, OpCount> errors{};
+    std::size_t enrolled = 0;
+    std::size_t full = 0;
+    std::size_t waitlisted = 0;
+    std::size_t clashes = 0;
+    std::size_t dropped = 0;
+
+    void merge(const Stats& other) {
+        for (int op = 0; op < OpCount; ++op) {
+            latencyMs[op].insert(latencyMs[op].end(), other.latencyMs[op].begin(), other.latencyMs[op].end());
+            errors[op] += other.errors[op];
+        }
+        enrolled += other.enrolled;
+        full += other.full;
+        waitlisted += other.waitlisted;
+        clashes += other.clashes;
+        dropped += other.dropped;
+    }
+};
+
+// Runs fn, records its latency under op and counts an error instead of
+// propagating when it throws. Returns whether fn completed.
+template <typename Fn>
+bool timed(Stats& stats, Op op, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    try {
+        fn();
+    }
+    catch (const std::exception& e) {
+        ok = false;
+        ++stats.errors[op];
+        if (stats.errors[op] == 1)
+            std::cerr << opNames[op] << " failed: " << e.what() << std::endl;
+    }
+    stats.latencyMs[op].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return ok;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::size_t rank = static_cast<std::size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (!std::strcmp(argv[i], "--students")) options.students = std::atoi(value());
+        else if (!std::strcmp(argv[i], "--threads")) options.threads = static_cast<unsigned>(std::atoi(value()));
+        else if (!std::strcmp(argv[i], "--courses")) options.coursesPerStudent = std::atoi(value());
+        else if (!std::strcmp(argv[i], "--drop-rate")) options.dropRate = std::atof(value());
+        else if (!std::strcmp(argv[i], "--think-ms")) options.thinkMs = std::atoi(value());
+        else if (!std::strcmp(argv[i], "--seed")) options.seed = static_cast<unsigned>(std::atoi(value()));
+        else if (!std::strcmp(argv[i], "--keep")) options.keep = true;
+        else {
+            std::cerr << "unknown option " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    options.threads = std::max(1u, std::min<unsigned>(options.threads, static_cast<unsigned>(std::max(options.students, 1))));
+    return options.students > 0;
+}
+
+std::string studentId(int index) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%s%05d", studentPrefix, index);
+    return buf;
+}
+
+// One registration: login, browse, try to enroll in a few random sections,
+// sometimes drop one of them again.
+void runStudent(Database& db, const std::string& id, const Options& options, std::mt19937& rng, Stats& stats) {
+    auto think = [&]() {
+        if (options.thinkMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(rng() % options.thinkMs));
+    };
+
+    int semester = 0;
+    std::string degree;
+    if (!timed(stats, Login, [&] {
+            if (!db.studentExists(id) || !db.validateStudentPassword(id, "bnu"))
+                throw std::runtime_error("login rejected for " + id);
+            semester = db.getStudentSemester(id);
+            degree = db.getStudentDegree(id);
+        }))
+        return;
+    think();
+
+    std::vector<ScheduledCourse> offered;
+    if (!timed(stats, Browse, [&] { offered = db.getAvailableScheduledCourses(semester, degree); }))
+        return;
+    std::shuffle(offered.begin(), offered.end(), rng);
+    think();
+
+    std::vector<int> mine;
+    int attempts = std::min<int>(options.coursesPerStudent, static_cast<int>(offered.size()));
+    for (int i = 0; i < attempts; ++i) {
+        const auto& sc = offered[i];
+        timed(stats, Enroll, [&] {
+            if (db.isAlreadyEnrolled(id, sc.schedule_id) || db.hasClash(id, sc.timeslot_id)) {
+                ++stats.clashes;
+                return;
+            }
+            if (db.addEnrollment(id, sc.schedule_id)) {
+                ++stats.enrolled;
+                mine.push_back(sc.schedule_id);
+            } else {
+                ++stats.full;
+                int position = db.joinWaitlist(id, sc.schedule_id);
+                if (position > 0)
+                    ++stats.waitlisted;
+                else if (position == 0)
+                    ++stats.enrolled;
+            }
+        });
+        think();
+    }
+
+    if (!mine.empty() && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < options.dropRate) {
+        int schedule_id = mine[rng() % mine.size()];
+        timed(stats, Drop, [&] {
+            if (db.dropEnrollment(id, schedule_id))
+                ++stats.dropped;
+        });
+    }
+}
+
+// Department/semester pairs that actually have scheduled sections, so every
+// synthetic student has something to register for.
+std::vector<std::pair<std::string, int>> offeredCohorts(mysqlx::Session& admin) {
+    std::vector<std::pair<std::string, int>> cohorts;
+    auto res = admin.sql("SELECT DISTINCT c.department, c.semester FROM course_schedule cs "
+                         "JOIN courses c ON cs.course_code = c.course_code "
+                         "JOIN current_term ct ON cs.term_id = ct.term_id").execute();
+    mysqlx::Row row;
+    while ((row = res.fetchOne()))
+        cohorts.emplace_back(row[0].get<std::string>(), row[1].get<int>());
+    return cohorts;
+}
+
+std::size_t reportViolations(mysqlx::Session& admin, const char* title, const std::string& query) {
+    auto res = admin.sql(query).execute();
+    std::size_t count = 0;
+    mysqlx::Row row;
+    while ((row = res.fetchOne())) {
+        if (count < 10) {
+            std::cout << "    ";
+            for (std::size_t c = 0; c < row.colCount(); ++c) {
+                std::string cell = row[c].getType() == mysqlx::Value::STRING ? row[c].get<std::string>()
+                                                                              : std::to_string(row[c].get<std::int64_t>());
+                std::cout << (c ? " | " : "") << cell;
+            }
+            std::cout << "\n";
+        }
+        ++count;
+    }
+    std::cout << "  " << title << ": " << count << "\n";
+    return count;
+}
+
+std::size_t checkInvariants(mysqlx::Session& admin) {
+    std::cout << "\nInvariants\n";
+    std::size_t violations = 0;
+    violations += reportViolations(admin, "sections over max_students",
+        "SELECT cs.schedule_id, c.course_code, c.max_students, COUNT(e.student_id) AS n "
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "GROUP BY cs.schedule_id, c.course_code, c.max_students "
+        "HAVING n > c.max_students");
+    violations += reportViolations(admin, "duplicate enrollments",
+        "SELECT student_id, schedule_id, COUNT(*) FROM enrollments "
+        "GROUP BY student_id, schedule_id HAVING COUNT(*) > 1");
+    violations += reportViolations(admin, "students double-booked in a timeslot",
+        "SELECT e.student_id, cs.timeslot_id, COUNT(*) FROM enrollments e "
+        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "GROUP BY e.student_id, cs.term_id, cs.timeslot_id HAVING COUNT(*) > 1");
+    violations += reportViolations(admin, "students waitlisted for a section they hold a seat in",
+        "SELECT w.student_id, w.schedule_id FROM waitlist w "
+        "JOIN enrollments e ON e.student_id = w.student_id AND e.schedule_id = w.schedule_id");
+    violations += reportViolations(admin, "free seats passed over an eligible waiting student",
+        "SELECT w.schedule_id, w.student_id FROM waitlist w "
+        "JOIN course_schedule cs ON w.schedule_id = cs.schedule_id "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "WHERE (SELECT COUNT(*) FROM enrollments e WHERE e.schedule_id = w.schedule_id) < c.max_students "
+        "AND NOT EXISTS (SELECT 1 FROM enrollments e JOIN course_schedule other ON e.schedule_id = other.schedule_id "
+        "WHERE e.student_id = w.student_id AND other.timeslot_id = cs.timeslot_id AND other.term_id = cs.term_id)");
+    return violations;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: cms_loadsim [--students N] [--threads T] [--courses K] [--drop-rate P] "
+                     "[--think-ms MS] [--seed S] [--keep]" << std::endl;
+        return 2;
+    }
+    const DatabaseConfig config = DatabaseConfig::fromEnvironment(DatabaseConfig());
+
+    std::unique_ptr<Database> setupDb;
+    std::unique_ptr<mysqlx::Session> admin;
+    try {
+        setupDb = std::make_unique<Database>(config);
+        admin = std::make_unique<mysqlx::Session>(mysqlx::SessionOption::HOST, config.host,
+                                                  mysqlx::SessionOption::PORT, config.port,
+                                                  mysqlx::SessionOption::USER, config.user,
+                                                  mysqlx::SessionOption::PWD, config.password,
+                                                  mysqlx::SessionOption::DB, config.schema);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto cohorts = offeredCohorts(*admin);
+    if (cohorts.empty()) {
+        std::cerr << "No scheduled sections; assign some course schedules first." << std::endl;
+        return 1;
+    }
+    admin->sql(std::string("DELETE FROM enrollments WHERE student_id LIKE '") + studentPrefix + "%'").execute();
+    admin->sql(std::string("DELETE FROM students WHERE student_id LIKE '") + studentPrefix + "%'").execute();
+    {
+        Database::Transaction tx(*setupDb);
+        for (int i = 0; i < options.students; ++i) {
+            const auto& cohort = cohorts[i % cohorts.size()];
+            std::string id = studentId(i);
+            tx.addStudent(id, "Sim", std::to_string(i), id + "@sim.invalid", cohort.first, cohort.second);
+        }
+        tx.commit();
+    }
+    std::cout << "Simulating " << options.students << " students on " << options.threads << " connections across "
+              << cohorts.size() << " department/semester cohorts\n";
+
+    std::atomic<int> next{0};
+    std::mutex mutex;
+    std::condition_variable startSignal;
+    bool started = false;
+    int ready = 0;
+    Stats total;
+    std::chrono::steady_clock::time_point opened;
+
+    auto worker = [&](unsigned index) {
+        Stats stats;
+        std::unique_ptr<Database> db;
+        timed(stats, Connect, [&] { db = std::make_unique<Database>(config); });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++ready;
+            startSignal.notify_all();
+            startSignal.wait(lock, [&] { return started; });
+        }
+        if (db) {
+            std::mt19937 rng(options.seed * 7919u + index);
+            for (int i = next++; i < options.students; i = next++)
+                runStudent(*db, studentId(i), options, rng, stats);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        total.merge(stats);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < options.threads; ++t)
+        pool.emplace_back(worker, t);
+    {
+        // Registration opens once every connection is up.
+        std::unique_lock<std::mutex> lock(mutex);
+        startSignal.wait(lock, [&] { return ready == static_cast<int>(options.threads); });
+        started = true;
+        opened = std::chrono::steady_clock::now();
+    }
+    startSignal.notify_all();
+    for (auto& t : pool)
+        t.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - opened).count();
+
+    std::size_t operations = 0;
+    std::size_t errors = 0;
+    std::printf("\n%-8s %8s %8s %9s %9s %9s %9s %9s\n", "op", "count", "errors", "p50 ms", "p90 ms", "p99 ms", "max ms", "mean ms");
+    for (int op = 0; op < OpCount; ++op) {
+        auto& samples = total.latencyMs[op];
+        std::sort(samples.begin(), samples.end());
+        double mean = 0.0;
+        for (double v : samples) mean += v;
+        mean = samples.empty() ? 0.0 : mean / samples.size();
+        std::printf("%-8s %8zu %8zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", opNames[op], samples.size(), total.errors[op],
+                    percentile(samples, 50), percentile(samples, 90), percentile(samples, 99),
+                    samples.empty() ? 0.0 : samples.back(), mean);
+        if (op != Connect) {
+            operations += samples.size();
+            errors += total.errors[op];
+        }
+    }
+    std::printf("\n%zu operations in %.2f s: %.1f ops/s, %.2f%% errors\n", operations, seconds,
+                seconds > 0 ? operations / seconds : 0.0, operations ? 100.0 * errors / operations : 0.0);
+    std::printf("enrolled %zu, section full %zu, waitlisted %zu, clash/already enrolled %zu, dropped %zu\n",
+                total.enrolled, total.full, total.waitlisted, total.clashes, total.dropped);
+
+    std::size_t violations = checkInvariants(*admin);
+
+    if (!options.keep) {
+        admin->sql(std::string("DELETE FROM enrollments WHERE student_id LIKE '") + studentPrefix + "%'").execute();
+        Database::Transaction tx(*setupDb);
+        for (int i = 0; i < options.students; ++i)
+            tx.removeStudent(studentId(i));
+        tx.commit();
+    }
+    return violations ? 3 : 0;
+}
@@ -1,10 +1,20 @@
 #include <QApplication>
+#include <QElapsedTimer>
 #include "mainwindow.h"
+#include "imageassets.h"
+#include "appstyle.h"
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+
     QApplication a(argc, argv);
+    a.setStyleSheet(appStyleSheet());
+    ImageAssets::instance().preload({AssetPath::mainBackground, AssetPath::logo, AssetPath::studentBackground,
+                                     AssetPath::facultyBackground, AssetPath::adminBackground});
     MainWindow w;
+    w.reportFirstFrame(&startup);
     w.show();
     return a.exec();
 }
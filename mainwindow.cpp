@@ -3,6 +3,7 @@
 #include "adminmenu.h"
 #include "facultymenu.h"
 #include "database.h"
+#include "imageassets.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -13,13 +14,84 @@
 #include <QResizeEvent>
 #include <QTimer>
 #include <QPainter>
+#include <QPointer>
+#include <QSettings>
+#include <QThreadPool>
+#include <QLoggingCategory>
+
+// Startup and menu-open timings. Off by default; enable with
+// QT_LOGGING_RULES="cms.startup.info=true".
+Q_LOGGING_CATEGORY(lcStartup, "cms.startup", QtWarningMsg)
+
+static DatabaseConfig loadDatabaseConfig() {
+    DatabaseConfig config;
+    QSettings settings("SCIT", "CMS");
+    settings.beginGroup("database");
+    config.host = settings.value("host", QString::fromStdString(config.host)).toString().toStdString();
+    config.port = settings.value("port", config.port).toInt();
+    config.user = settings.value("user", QString::fromStdString(config.user)).toString().toStdString();
+    config.password = settings.value("password", QString::fromStdString(config.password)).toString().toStdString();
+    config.schema = settings.value("schema", QString::fromStdString(config.schema)).toString().toStdString();
+    config.serviceSocket = settings.value("service").toString().toStdString();
+    settings.endGroup();
+    return DatabaseConfig::fromEnvironment(config);
+}
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
-    db = new Database("127.0.0.1", "root", "Sufian312", "project_db");
-
-    backgroundPixmap = QPixmap("/Users/sufianzahid/Desktop/Qt/OOP/main.jpg");
+    background = new ScaledBackground(this, AssetPath::mainBackground, Qt::KeepAspectRatioByExpanding);
 
     setupUI();
+    connectDatabase();
+}
+
+// Connects and warms up on the thread pool so the window paints right away;
+// login buttons stay disabled until the session is ready.
+void MainWindow::connectDatabase() {
+    setLoginEnabled(false);
+    statusLabel->setText("Connecting to database...");
+
+    DatabaseConfig config = loadDatabaseConfig();
+    QPointer<MainWindow> self(this);
+    QThreadPool::globalInstance()->start([self, config]() {
+        Database *connected = nullptr;
+        QString error;
+        try {
+            connected = new Database(config);
+            connected->warmUp();
+        } catch (const std::exception &e) {
+            delete connected;
+            connected = nullptr;
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(qApp, [self, connected, error]() {
+            if (!self) {
+                delete connected;
+                return;
+            }
+            if (!connected) {
+                self->statusLabel->setText("Database unavailable");
+                auto choice = QMessageBox::warning(self, "Database", "Could not connect to the database:\n" + error,
+                                                   QMessageBox::Retry | QMessageBox::Close);
+                if (choice == QMessageBox::Retry)
+                    self->connectDatabase();
+                return;
+            }
+            self->db = connected;
+            self->statusLabel->setText("");
+            self->setLoginEnabled(true);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::showMenu(QWidget *menu) {
+    menu->show();
+    menu->raise();
+    menu->activateWindow();
+}
+
+void MainWindow::setLoginEnabled(bool enabled) {
+    for (QPushButton *btn : {studentBtn, adminBtn, facultyBtn})
+        btn->setEnabled(enabled);
 }
 
 MainWindow::~MainWindow() {
@@ -38,9 +110,9 @@ void MainWindow::setupUI() {
     mainLayout->addSpacing(100);
     auto logo = new QLabel();
     logo->setAlignment(Qt::AlignCenter);
-    logo->setPixmap(QPixmap("/Users/sufianzahid/Desktop/Qt/OOP/logo.png")
-                        .scaled(200, 200, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-    logo->setStyleSheet("background: transparent;");
+    logo->setPixmap(ImageAssets::instance().scaledNow(AssetPath::logo,
+                                                      QSize(200, 200), Qt::KeepAspectRatio));
+    logo->setObjectName("logo");
     mainLayout->addWidget(logo);
 
     mainLayout->addSpacing(100);
@@ -49,24 +121,20 @@ void MainWindow::setupUI() {
     heading->setAlignment(Qt::AlignCenter);
     QFont font("Georgia", 50, QFont::Bold);
     heading->setFont(font);
-    heading->setStyleSheet("color: #2047f5; background: transparent; padding: 14px 36px; letter-spacing: 2px;");
+    heading->setObjectName("mainHeading");
     mainLayout->addWidget(heading);
     mainLayout->addSpacing(100);
 
     auto btnLayout = new QHBoxLayout();
     mainLayout->addLayout(btnLayout);
 
-    QString btnStyle =
-        "QPushButton { background-color: rgba(255, 59, 59, 180); color: white; padding: 14px 34px; border: none; border-radius: 8px; font-size: 18px; font-weight: bold; }"
-        "QPushButton:hover { background-color: rgba(213, 0, 0, 200); }";
-
     studentBtn = new QPushButton("Student Login");
     adminBtn = new QPushButton("Admin Login");
     facultyBtn = new QPushButton("Faculty Login");
     exitBtn = new QPushButton("Exit");
 
     for (QPushButton *btn : {studentBtn, adminBtn, facultyBtn, exitBtn}) {
-        btn->setStyleSheet(btnStyle);
+        btn->setProperty("menuStyle", "main");
         btn->setMinimumWidth(160);
         btn->installEventFilter(this);
     }
@@ -81,16 +149,22 @@ void MainWindow::setupUI() {
     btnLayout->addWidget(exitBtn);
     btnLayout->addStretch();
 
+    mainLayout->addSpacing(30);
+    statusLabel = new QLabel();
+    statusLabel->setAlignment(Qt::AlignCenter);
+    statusLabel->setObjectName("statusLabel");
+    mainLayout->addWidget(statusLabel);
+
     mainLayout->addStretch();
 
     bottomBar = new QLabel(central);
     bottomBar->setFixedSize(120, 10);
-    bottomBar->setStyleSheet("background-color: #2047f5; border-radius: 5px;");
+    bottomBar->setObjectName("bottomBar");
     bottomBar->raise();
 
     ball = new QLabel(central);
     ball->setFixedSize(20, 20);
-    ball->setStyleSheet("background-color: #f54291; border-radius: 10px;");
+    ball->setObjectName("ball");
     ball->raise();
 
     ballAnimation = new QPropertyAnimation(ball, "pos");
@@ -106,24 +180,37 @@ void MainWindow::setupUI() {
         if (!ok || password.isEmpty()) return;
 
         if (db->studentExists(id.toStdString()) && db->validateStudentPassword(id.toStdString(), password.toStdString())) {
-            delete stuMenu;
-            stuMenu = new StudentMenu(db, id, "StudentName", "student@email.com", nullptr);
-            stuMenu->setAttribute(Qt::WA_DeleteOnClose);
-            stuMenu->show();
+            QElapsedTimer clock;
+            clock.start();
+            // Menus are created on first login and kept; later logins only rebind them.
+            bool reused = stuMenu != nullptr;
+            if (!stuMenu)
+                stuMenu = new StudentMenu(db, nullptr);
+            stuMenu->bindSession(id, "StudentName", "student@email.com");
+            showMenu(stuMenu);
+            qCInfo(lcStartup, "Student menu ready in %lld ms (%s)", static_cast<long long>(clock.elapsed()), reused ? "reused" : "created");
         } else {
             QMessageBox::warning(this, "Student Login", "Invalid Student ID or Password.");
         }
     });
 
     connect(adminBtn, &QPushButton::clicked, this, [=]() {
+        if (db->usesService()) {
+            QMessageBox::warning(this, "Admin Login", "Admin tools need a direct database connection; "
+                                                      "this client is connected through the enrollment service.");
+            return;
+        }
         bool ok;
         QString pw = QInputDialog::getText(this, "Admin Login", "Enter Admin Password:", QLineEdit::Password, "", &ok);
         if (ok && !pw.isEmpty()) {
             if (db->isAdminPasswordCorrect(pw.toStdString())) {
-                delete adminMenu;
-                adminMenu = new AdminMenu(db, nullptr);
-                adminMenu->setAttribute(Qt::WA_DeleteOnClose);
-                adminMenu->show();
+                QElapsedTimer clock;
+                clock.start();
+                bool reused = adminMenu != nullptr;
+                if (!adminMenu)
+                    adminMenu = new AdminMenu(db, nullptr);
+                showMenu(adminMenu);
+                qCInfo(lcStartup, "Admin menu ready in %lld ms (%s)", static_cast<long long>(clock.elapsed()), reused ? "reused" : "created");
             } else {
                 QMessageBox::warning(this, "Admin Login", "Invalid password.");
             }
@@ -140,10 +227,14 @@ void MainWindow::setupUI() {
         if (db->facultyExists(email.toStdString()) && db->validateFacultyPassword(email.toStdString(), password.toStdString())) {
             int facultyId = QString::fromStdString(db->getFacultyId(email.toStdString())).toInt();
             QString facultyName = QString::fromStdString(db->getFacultyName(email.toStdString()));
-            delete facMenu;
-            facMenu = new FacultyMenu(db, QString::number(facultyId), facultyName, email, nullptr);
-            facMenu->setAttribute(Qt::WA_DeleteOnClose);
-            facMenu->show();
+            QElapsedTimer clock;
+            clock.start();
+            bool reused = facMenu != nullptr;
+            if (!facMenu)
+                facMenu = new FacultyMenu(db, nullptr);
+            facMenu->bindSession(QString::number(facultyId), facultyName, email);
+            showMenu(facMenu);
+            qCInfo(lcStartup, "Faculty menu ready in %lld ms (%s)", static_cast<long long>(clock.elapsed()), reused ? "reused" : "created");
         } else {
             QMessageBox::warning(this, "Faculty Login", "Invalid Faculty Email or Password.");
         }
@@ -156,10 +247,7 @@ void MainWindow::setupUI() {
 void MainWindow::resizeEvent(QResizeEvent *event) {
     QMainWindow::resizeEvent(event);
 
-    if (!backgroundPixmap.isNull()) {
-        backgroundPixmap = QPixmap("/Users/sufianzahid/Desktop/Qt/OOP/main.jpg")
-        .scaled(size(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-    }
+    background->resized(size());
 
     int barX = (width() - bottomBar->width()) / 2;
     int barY = height() - bottomBar->height() - 30;
@@ -206,8 +294,15 @@ void MainWindow::resetBallToBar() {
 
 void MainWindow::paintEvent(QPaintEvent *event) {
     QPainter painter(this);
-    if (!backgroundPixmap.isNull()) {
-        painter.drawPixmap(rect(), backgroundPixmap);
+    if (!background->isNull()) {
+        // Already scaled to cover the window in resizeEvent; centre it
+        // rather than have drawPixmap rescale it on every paint.
+        const QPixmap &bg = background->pixmap();
+        painter.drawPixmap((width() - bg.width()) / 2, (height() - bg.height()) / 2, bg);
     }
     QMainWindow::paintEvent(event);
+    if (startupClock) {
+        qCInfo(lcStartup, "Time to first frame: %lld ms", static_cast<long long>(startupClock->elapsed()));
+        startupClock = nullptr;
+    }
 }
@@ -6,11 +6,13 @@
 #include <QLabel>
 #include <QPropertyAnimation>
 #include <QPixmap>
+#include <QElapsedTimer>
 
 class StudentMenu;
 class AdminMenu;
 class FacultyMenu;
 class Database;
+class ScaledBackground;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -19,6 +21,8 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    void reportFirstFrame(const QElapsedTimer *clock) { startupClock = clock; }
+
 signals:
     void resized();
 
@@ -31,6 +35,9 @@ private:
     void setupUI();
     void animateBallTo(QWidget *target);
     void resetBallToBar();
+    void connectDatabase();
+    void setLoginEnabled(bool enabled);
+    void showMenu(QWidget *menu);
 
     QPushButton *studentBtn;
     QPushButton *adminBtn;
@@ -39,6 +46,7 @@ private:
 
     QLabel *ball;
     QLabel *bottomBar;
+    QLabel *statusLabel;
     QPropertyAnimation *ballAnimation;
 
     QPoint barPos;
@@ -49,7 +57,8 @@ private:
     FacultyMenu *facMenu = nullptr;
     Database *db = nullptr;
 
-    QPixmap backgroundPixmap;
+    ScaledBackground *background = nullptr;
+    const QElapsedTimer *startupClock = nullptr;
 };
 
 #endif
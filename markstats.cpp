@@ -0,0 +1,277 @@
+#include "markstats.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// Four independent partial sums, so the loop has no dependency on the
+// previous iteration and the compiler can keep them in one vector register.
+double sum(const double* v, std::size_t n)
+{
+    double lane[4] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        lane[0] += v[i];
+        lane[1] += v[i + 1];
+        lane[2] += v[i + 2];
+        lane[3] += v[i + 3];
+    }
+    for (; i < n; ++i)
+        lane[0] += v[i];
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+double squaredDeviations(const double* v, std::size_t n, double mean)
+{
+    double lane[4] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const double d0 = v[i] - mean, d1 = v[i + 1] - mean, d2 = v[i + 2] - mean, d3 = v[i + 3] - mean;
+        lane[0] += d0 * d0;
+        lane[1] += d1 * d1;
+        lane[2] += d2 * d2;
+        lane[3] += d3 * d3;
+    }
+    for (; i < n; ++i)
+        lane[0] += (v[i] - mean) * (v[i] - mean);
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+// Branch-free so the loop vectorizes: a zero total divides by one and is
+// masked to 0%.
+void toPercentages(const int* obtained, const int* total, std::size_t n, double* out)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        const int positive = total[i] > 0;
+        out[i] = positive * 100.0 * obtained[i] / (total[i] + 1 - positive);
+    }
+}
+
+// Linear interpolation between the closest ranks of a sorted sample.
+double percentile(const std::vector<double>& sorted, double q)
+{
+    const double rank = q * static_cast<double>(sorted.size() - 1);
+    const std::size_t lo = static_cast<std::size_t>(rank);
+    const std::size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - static_cast<double>(lo));
+}
+
+}
+
+MarkStats MarkStats::of(const int* obtained, const int* total, std::size_t n)
+{
+    std::vector<double> percentages(n);
+    toPercentages(obtained, total, n, percentages.data());
+    return of(std::move(percentages));
+}
+
+MarkStats MarkStats::of(std::vector<double> percentages)
+{
+    MarkStats stats;
+    stats.count = percentages.size();
+    if (percentages.empty())
+        return stats;
+    const double* v = percentages.data();
+    const std::size_t n = percentages.size();
+    stats.mean = sum(v, n) / static_cast<double>(n);
+    stats.stddev = std::sqrt(squaredDeviations(v, n, stats.mean) / static_cast<double>(n));
+    for (std::size_t i = 0; i < n; ++i)
+        ++stats.histogram[std::min<std::size_t>(9, static_cast<std::size_t>(std::max(v[i], 0.0) / 10.0))];
+
+    std::sort(percentages.begin(), percentages.end());
+    stats.min = percentages.front();
+    stats.max = percentages.back();
+    stats.median = percentile(percentages, 0.5);
+    stats.p10 = percentile(percentages, 0.1);
+    stats.p25 = percentile(percentages, 0.25);
+    stats.p75 = percentile(percentages, 0.75);
+    stats.p90 = percentile(percentages, 0.9);
+    return stats;
+}
+
+void MarksColumns::put(Column& column, const std::string& student_id, int total, int obtained)
+{
+    auto [it, fresh] = column.row.emplace(student_id, column.students.size());
+    if (fresh) {
+        column.students.push_back(student_id);
+        column.obtained.push_back(obtained);
+        column.total.push_back(total);
+    } else {
+        column.obtained[it->second] = obtained;
+        column.total[it->second] = total;
+    }
+}
+
+void MarksColumns::loadAll(Database& db)
+{
+    const std::uint64_t version = db.changeVersions()[ChangeFeed::Marks];
+    courses.clear();
+    Course* course = nullptr;
+    std::string current;
+    db.streamMarks([&](MarkRecord& row) {
+        if (!course || current != row.course_code) {
+            current = row.course_code;
+            course = &courses[current];
+            course->department = std::move(row.department);
+            course->version = version;
+        }
+        put(course->assignments[row.assignment_name], row.student_id, row.total_marks, row.obtained_marks);
+    });
+}
+
+void MarksColumns::loadCourse(Database& db, const std::string& course_code)
+{
+    const std::uint64_t version = db.changeVersions()[ChangeFeed::Marks];
+    auto it = courses.find(course_code);
+    if (it != courses.end() && it->second.version == version)
+        return;
+
+    Course course;
+    course.version = version;
+    if (it != courses.end())
+        course.department = it->second.department;
+    for (const auto& assignment : db.getAssignmentsForCourse(course_code)) {
+        Column& column = course.assignments[assignment];
+        for (const auto& mark : db.getStudentMarksForAssignment(course_code, assignment))
+            put(column, mark.first, mark.second.first, mark.second.second);
+    }
+    courses[course_code] = std::move(course);
+}
+
+// Each write bumps the Marks feed once, so the course stays current as long
+// as nobody else wrote in between. Courses not loaded yet are left to the
+// next load.
+void MarksColumns::set(const std::string& course_code, const std::string& student_id, const std::string& assignment,
+                       int total, int obtained)
+{
+    auto it = courses.find(course_code);
+    if (it == courses.end())
+        return;
+    put(it->second.assignments[assignment], student_id, total, obtained);
+    ++it->second.version;
+}
+
+void MarksColumns::setObtained(const std::string& course_code, const std::string& student_id,
+                               const std::string& assignment, int obtained)
+{
+    auto it = courses.find(course_code);
+    if (it == courses.end())
+        return;
+    auto column = it->second.assignments.find(assignment);
+    if (column == it->second.assignments.end())
+        return;
+    auto row = column->second.row.find(student_id);
+    if (row == column->second.row.end())
+        return;
+    column->second.obtained[row->second] = obtained;
+    ++it->second.version;
+}
+
+MarkStats MarksColumns::assignmentStats(const std::string& course_code, const std::string& assignment) const
+{
+    auto it = courses.find(course_code);
+    if (it == courses.end())
+        return MarkStats();
+    auto column = it->second.assignments.find(assignment);
+    if (column == it->second.assignments.end())
+        return MarkStats();
+    const Column& c = column->second;
+    return MarkStats::of(c.obtained.data(), c.total.data(), c.students.size());
+}
+
+// A student's course percentage is the sum of their obtained marks over the
+// sum of the totals of the assignments they have marks for.
+CourseStats MarksColumns::describe(const std::string& course_code, const Course& course,
+                                   std::vector<std::string>* students, std::vector<double>* percentages)
+{
+    CourseStats stats;
+    stats.course_code = course_code;
+    stats.department = course.department;
+
+    std::unordered_map<std::string, std::size_t> slot;
+    std::vector<std::string> ids;
+    std::vector<int> obtained, total;
+    for (const auto& [name, column] : course.assignments) {
+        stats.assignments.emplace_back(name, MarkStats::of(column.obtained.data(), column.total.data(),
+                                                           column.students.size()));
+        for (std::size_t i = 0; i < column.students.size(); ++i) {
+            auto [it, fresh] = slot.emplace(column.students[i], ids.size());
+            if (fresh) {
+                ids.push_back(column.students[i]);
+                obtained.push_back(0);
+                total.push_back(0);
+            }
+            obtained[it->second] += column.obtained[i];
+            total[it->second] += column.total[i];
+        }
+    }
+
+    std::vector<double> percent(ids.size());
+    toPercentages(obtained.data(), total.data(), ids.size(), percent.data());
+    stats.overall = MarkStats::of(percent);
+    if (students)
+        *students = std::move(ids);
+    if (percentages)
+        *percentages = std::move(percent);
+    return stats;
+}
+
+CourseStats MarksColumns::courseStats(const std::string& course_code) const
+{
+    auto it = courses.find(course_code);
+    if (it == courses.end())
+        return CourseStats{course_code, std::string(), MarkStats(), {}};
+    return describe(course_code, it->second, nullptr, nullptr);
+}
+
+std::vector<NormalizedScore> MarksColumns::normalized(const std::string& course_code) const
+{
+    std::vector<NormalizedScore> scores;
+    auto it = courses.find(course_code);
+    if (it == courses.end())
+        return scores;
+    std::vector<std::string> students;
+    std::vector<double> percent;
+    CourseStats stats = describe(course_code, it->second, &students, &percent);
+    const double spread = stats.overall.stddev > 0.0 ? stats.overall.stddev : 1.0;
+    scores.reserve(students.size());
+    for (std::size_t i = 0; i < students.size(); ++i)
+        scores.push_back({std::move(students[i]), percent[i], (percent[i] - stats.overall.mean) / spread});
+    std::sort(scores.begin(), scores.end(),
+              [](const NormalizedScore& a, const NormalizedScore& b) { return a.student_id < b.student_id; });
+    return scores;
+}
+
+MarksSummary MarksColumns::summarize(unsigned threads) const
+{
+    MarksSummary summary;
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<const std::string*, const Course*>> list;
+    list.reserve(courses.size());
+    for (const auto& [code, course] : courses)
+        list.emplace_back(&code, &course);
+
+    summary.courses.resize(list.size());
+    std::vector<std::vector<double>> percentages(list.size());
+    parallelFor(list.size(), threads, [&](std::size_t i) {
+        summary.courses[i] = describe(*list[i].first, *list[i].second, nullptr, &percentages[i]);
+    });
+
+    std::map<std::string, std::vector<std::size_t>> byDepartment;
+    for (std::size_t i = 0; i < list.size(); ++i)
+        byDepartment[list[i].second->department].push_back(i);
+    for (const auto& entry : byDepartment)
+        summary.departments.push_back({entry.first, entry.second.size(), MarkStats()});
+    parallelFor(summary.departments.size(), threads, [&](std::size_t d) {
+        std::vector<double> all;
+        for (std::size_t i : byDepartment.at(summary.departments[d].department))
+            all.insert(all.end(), percentages[i].begin(), percentages[i].end());
+        summary.departments[d].overall = MarkStats::of(std::move(all));
+    });
+
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
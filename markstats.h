@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "database.h"
+
+// Summary of a set of percentages (obtained / total * 100).
+struct MarkStats {
+    std::size_t count = 0;
+    double mean = 0.0, median = 0.0, stddev = 0.0;
+    double min = 0.0, max = 0.0;
+    double p10 = 0.0, p25 = 0.0, p75 = 0.0, p90 = 0.0;
+    // Ten bins of ten percentage points; 100% lands in the last one.
+    std::array<std::size_t, 10> histogram{};
+
+    // n marks as two parallel arrays; a zero total counts as 0%.
+    static MarkStats of(const int* obtained, const int* total, std::size_t n);
+    static MarkStats of(std::vector<double> percentages);
+};
+
+struct CourseStats {
+    std::string course_code, department;
+    MarkStats overall;                                          // per-student course percentage
+    std::vector<std::pair<std::string, MarkStats>> assignments;   // by name
+};
+
+struct DepartmentStats {
+    std::string department;
+    std::size_t courses = 0;
+    MarkStats overall;                                          // every student's percentage in every course
+};
+
+struct NormalizedScore {
+    std::string student_id;
+    double percent;
+    double z;                                                   // standard deviations from the course mean
+};
+
+struct MarksSummary {
+    std::vector<CourseStats> courses;
+    std::vector<DepartmentStats> departments;
+    double seconds = 0.0;
+};
+
+// In-memory column store of the marks table. Every assignment of a course is
+// a column of contiguous obtained/total arrays with the student ids
+// alongside, and the statistics run straight over those arrays. set() and
+// setObtained() mirror a mark this process has just written, so a course is
+// only refetched once the Marks feed has moved further than those writes.
+class MarksColumns {
+public:
+    struct Column {
+        std::vector<std::string> students;
+        std::vector<int> obtained, total;
+        std::unordered_map<std::string, std::size_t> row;
+    };
+
+    // Every course from one streaming read; direct connections only.
+    void loadAll(Database& db);
+    // One course through calls cms_serviced also serves. Does nothing when
+    // the course is current.
+    void loadCourse(Database& db, const std::string& course_code);
+
+    void set(const std::string& course_code, const std::string& student_id, const std::string& assignment,
+             int total, int obtained);
+    void setObtained(const std::string& course_code, const std::string& student_id, const std::string& assignment,
+                     int obtained);
+
+    bool has(const std::string& course_code) const { return courses.count(course_code) > 0; }
+    MarkStats assignmentStats(const std::string& course_code, const std::string& assignment) const;
+    CourseStats courseStats(const std::string& course_code) const;
+    // Course percentage and z-score of every student with marks, by student.
+    std::vector<NormalizedScore> normalized(const std::string& course_code) const;
+    // Statistics of every loaded course and of each department, computed on
+    // threads workers (0 = hardware concurrency).
+    MarksSummary summarize(unsigned threads) const;
+
+private:
+    struct Course {
+        std::string department;
+        std::map<std::string, Column> assignments;
+        std::uint64_t version = 0;                              // Marks feed version it reflects
+    };
+    std::map<std::string, Course> courses;
+
+    static void put(Column& column, const std::string& student_id, int total, int obtained);
+    static CourseStats describe(const std::string& course_code, const Course& course,
+                                std::vector<std::string>* students, std::vector<double>* percentages);
+};
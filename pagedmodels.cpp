@@ -0,0 +1,119 @@
+#include "pagedmodels.h"
+#include <iterator>
+
+RosterModel::RosterModel(Database *db, std::string courseCode, QObject *parent)
+    : QAbstractTableModel(parent), db(db), courseCode(std::move(courseCode))
+{
+}
+
+int RosterModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(rows.size());
+}
+
+int RosterModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 6;
+}
+
+QVariant RosterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+    const auto &s = rows[index.row()];
+    switch (index.column()) {
+    case 0: return QString::fromStdString(s.student_id);
+    case 1: return QString::fromStdString(s.first_name);
+    case 2: return QString::fromStdString(s.last_name);
+    case 3: return QString::fromStdString(s.email);
+    case 4: return s.semester;
+    case 5: return QString::fromStdString(s.degree);
+    }
+    return QVariant();
+}
+
+QVariant RosterModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+    static const char *headers[] = {"ID", "First Name", "Last Name", "Email", "Sem", "Degree"};
+    return QString(headers[section]);
+}
+
+bool RosterModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !exhausted;
+}
+
+void RosterModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+    std::string after = rows.empty() ? std::string() : rows.back().student_id;
+    auto page = db->getEnrolledStudentsPage(courseCode, after, pageSize);
+    exhausted = static_cast<int>(page.size()) < pageSize;
+    if (page.empty())
+        return;
+    int first = static_cast<int>(rows.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(page.size()) - 1);
+    rows.insert(rows.end(), std::make_move_iterator(page.begin()), std::make_move_iterator(page.end()));
+    endInsertRows();
+}
+
+ScheduleModel::ScheduleModel(Database *db, QObject *parent)
+    : QAbstractTableModel(parent), db(db)
+{
+}
+
+int ScheduleModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(rows.size());
+}
+
+int ScheduleModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 5;
+}
+
+QVariant ScheduleModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+    const auto &a = rows[index.row()];
+    switch (index.column()) {
+    case 0: return QString::fromStdString(a.course_code);
+    case 1: return QString::fromStdString(a.course_name);
+    case 2: return QString::fromStdString(a.faculty_name);
+    case 3: return QString::fromStdString(a.room);
+    case 4: return QString::fromStdString(a.timeslot);
+    }
+    return QVariant();
+}
+
+QVariant ScheduleModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+    static const char *headers[] = {"Course", "Name", "Faculty", "Room", "Timeslot"};
+    return QString(headers[section]);
+}
+
+bool ScheduleModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !exhausted;
+}
+
+void ScheduleModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+    int after = rows.empty() ? 0 : rows.back().schedule_id;
+    auto page = db->getCourseSchedulesPage(after, pageSize);
+    exhausted = static_cast<int>(page.size()) < pageSize;
+    if (page.empty())
+        return;
+    int first = static_cast<int>(rows.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(page.size()) - 1);
+    rows.insert(rows.end(), std::make_move_iterator(page.begin()), std::make_move_iterator(page.end()));
+    endInsertRows();
+}
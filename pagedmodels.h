@@ -0,0 +1,55 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <string>
+#include <vector>
+#include "database.h"
+
+// Table models that pull rows from Database one keyset page at a time as a
+// QTableView scrolls, instead of materialising the whole result up front.
+
+class RosterModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    RosterModel(Database *db, std::string courseCode, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    static constexpr int pageSize = 200;
+
+    Database *db;
+    std::string courseCode;
+    std::vector<Database::StudentInfo> rows;
+    bool exhausted = false;
+};
+
+class ScheduleModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit ScheduleModel(Database *db, QObject *parent = nullptr);
+
+    const Database::ScheduledAssignment &assignmentAt(int row) const { return rows[row]; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    static constexpr int pageSize = 200;
+
+    Database *db;
+    std::vector<Database::ScheduledAssignment> rows;
+    bool exhausted = false;
+};
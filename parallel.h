@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Calls fn for every index in [0, count) on up to threads threads (0 means
+// one per core), the calling thread being one of them. Indices are handed
+// out one at a time, so items of uneven cost still balance. fn is called as
+// fn(i), or as fn(i, worker) when it takes a second argument; worker is
+// below threads and names the calling thread, for per-thread scratch. If fn
+// throws, no further indices are handed out and the first exception is
+// rethrown once every thread has stopped.
+template <typename Fn>
+void parallelFor(std::size_t count, unsigned threads, Fn&& fn)
+{
+    threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(count, 1)));
+    std::atomic<std::size_t> next{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto worker = [&](unsigned w) {
+        try {
+            for (std::size_t i = next++; i < count; i = next++) {
+                if constexpr (std::is_invocable_v<Fn&, std::size_t, unsigned>)
+                    fn(i, w);
+                else
+                    fn(i);
+            }
+        }
+        catch (...) {
+            next = count;
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; ++w)
+        pool.emplace_back(worker, w);
+    worker(0);
+    for (auto& t : pool)
+        t.join();
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,604 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "database.h"
+
+// Statements used by Database, each declared next to the struct its rows decode
+// into. A query provides:
+//   Row      - result struct
+//   select   - the projection, "SELECT a, b, ..."
+//   tail     - everything from FROM onwards
+//   Columns  - std::tuple of Column<&Row::member> in SELECT order
+// Column count and member types are checked at compile time by Checked<Query>.
+namespace catalog {
+
+constexpr std::size_t selectColumnCount(std::string_view select)
+{
+    std::size_t count = 1;
+    int depth = 0;
+    char quote = 0;
+    for (char ch : select) {
+        if (quote) {
+            if (ch == quote) quote = 0;
+        } else if (ch == '\'' || ch == '"') {
+            quote = ch;
+        } else if (ch == '(') {
+            ++depth;
+        } else if (ch == ')') {
+            --depth;
+        } else if (ch == ',' && depth == 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+template <auto Member>
+struct Column;
+
+template <typename R, typename T, T R::*Member>
+struct Column<Member> {
+    using row_type = R;
+    using value_type = T;
+    static_assert(std::is_same_v<T, int> || std::is_same_v<T, double> || std::is_same_v<T, std::string>,
+                  "catalog columns decode into int, double or std::string members only");
+
+    static void decode(R& out, const mysqlx::Value& v) { out.*Member = v.get<T>(); }
+};
+
+template <typename Query, std::size_t... I>
+constexpr bool columnsMatchRow(std::index_sequence<I...>)
+{
+    return (std::is_base_of_v<typename std::tuple_element_t<I, typename Query::Columns>::row_type,
+                              typename Query::Row> && ...);
+}
+
+template <typename Query>
+struct Checked {
+    static constexpr std::size_t columns = std::tuple_size_v<typename Query::Columns>;
+    static_assert(columns == selectColumnCount(Query::select),
+                  "column descriptors do not match the SELECT list");
+    static_assert(columnsMatchRow<Query>(std::make_index_sequence<columns>{}),
+                  "column descriptor targets a different row struct");
+};
+
+template <typename Query>
+const std::string& text()
+{
+    static const std::string sql = std::string(Query::select) + " " + std::string(Query::tail);
+    return sql;
+}
+
+template <typename Query, std::size_t... I>
+void decodeColumns(typename Query::Row& out, mysqlx::Row& row, std::index_sequence<I...>)
+{
+    (std::tuple_element_t<I, typename Query::Columns>::decode(out, row[I]), ...);
+}
+
+template <typename Query>
+void decode(typename Query::Row& out, mysqlx::Row& row)
+{
+    decodeColumns<Query>(out, row, std::make_index_sequence<Checked<Query>::columns>{});
+}
+
+// Shared by every query that yields a full ScheduledCourse.
+constexpr std::string_view timetableSelect =
+    "SELECT cs.schedule_id, cs.course_code, c.course_name, c.department, c.semester, "
+    "cs.faculty_id, CONCAT(f.first_name, ' ', f.last_name) AS faculty_name, "
+    "cs.timeslot_id, t.day_of_week, CAST(t.start_time AS CHAR), CAST(t.end_time AS CHAR), "
+    "cs.room_id, cl.room_number, cl.building";
+
+using TimetableColumns = std::tuple<
+    Column<&ScheduledCourse::schedule_id>,
+    Column<&ScheduledCourse::course_code>,
+    Column<&ScheduledCourse::course_name>,
+    Column<&ScheduledCourse::department>,
+    Column<&ScheduledCourse::semester>,
+    Column<&ScheduledCourse::faculty_id>,
+    Column<&ScheduledCourse::faculty_name>,
+    Column<&ScheduledCourse::timeslot_id>,
+    Column<&ScheduledCourse::day>,
+    Column<&ScheduledCourse::start_time>,
+    Column<&ScheduledCourse::end_time>,
+    Column<&ScheduledCourse::room_id>,
+    Column<&ScheduledCourse::room_number>,
+    Column<&ScheduledCourse::building>>;
+
+struct AvailableScheduledCourses {
+    using Row = ScheduledCourse;
+    using Columns = TimetableColumns;
+    static constexpr std::string_view select = timetableSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "WHERE c.semester = ? AND c.department = ?";
+};
+
+struct EnrolledCourses {
+    using Row = ScheduledCourse;
+    using Columns = TimetableColumns;
+    static constexpr std::string_view select = timetableSelect;
+    static constexpr std::string_view tail =
+        "FROM enrollments e "
+        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "WHERE e.student_id = ?";
+};
+
+// The student's queued sections, with their place in each line.
+struct StudentWaitlists {
+    using Row = WaitlistEntry;
+    using Columns = std::tuple<
+        Column<&Row::schedule_id>,
+        Column<&Row::course_code>,
+        Column<&Row::course_name>,
+        Column<&Row::position>>;
+    static constexpr std::string_view select =
+        "SELECT w.schedule_id, cs.course_code, c.course_name, "
+        "(SELECT COUNT(*) FROM waitlist ahead WHERE ahead.schedule_id = w.schedule_id AND ahead.seq <= w.seq)";
+    static constexpr std::string_view tail =
+        "FROM waitlist w "
+        "JOIN course_schedule cs ON w.schedule_id = cs.schedule_id "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "WHERE w.student_id = ? "
+        "ORDER BY w.seq";
+};
+
+// Capacity of a section of an open term, locking the section only so
+// concurrent adds, drops and promotions on it run one after another.
+struct SectionSeats {
+    static constexpr std::string_view select = "SELECT c.max_students, cs.timeslot_id, cs.term_id";
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN terms tm ON cs.term_id = tm.term_id AND tm.state = 'open' "
+        "WHERE cs.schedule_id = ? FOR UPDATE OF cs";
+};
+
+// The student's enrollments in a section's timeslot and term, and how many
+// of them are that section itself; binds student_id, schedule_id. A locking
+// read, so it sees enrollments committed after the transaction began.
+struct HeldSlot {
+    static constexpr std::string_view select = "SELECT COUNT(*), COUNT(CASE WHEN e.schedule_id = target.schedule_id THEN 1 END)";
+    static constexpr std::string_view tail =
+        "FROM course_schedule target "
+        "JOIN course_schedule cs ON cs.timeslot_id = target.timeslot_id AND cs.term_id = target.term_id "
+        "JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "WHERE e.student_id = ? AND target.schedule_id = ? FOR SHARE";
+};
+
+// The first waiting students of a section who have no other course in its
+// timeslot and term, in line order; binds schedule_id, timeslot_id,
+// term_id, limit.
+struct EligibleWaitlisted {
+    static constexpr std::string_view select = "SELECT w.seq, w.student_id";
+    static constexpr std::string_view tail =
+        "FROM waitlist w "
+        "WHERE w.schedule_id = ? AND NOT EXISTS ("
+        "SELECT 1 FROM enrollments e JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "WHERE e.student_id = w.student_id AND cs.timeslot_id = ? AND cs.term_id = ?) "
+        "ORDER BY w.seq LIMIT ? FOR UPDATE";
+};
+
+struct FacultyTimetable {
+    using Row = ScheduledCourse;
+    using Columns = TimetableColumns;
+    static constexpr std::string_view select = timetableSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "WHERE cs.faculty_id = ?";
+};
+
+// Every enrollment joined with its section, ordered so rows of one student are
+// adjacent; feeds the batch exporters.
+struct AllEnrolledTimetables {
+    using Row = EnrolledTimetableRow;
+    using Columns = decltype(std::tuple_cat(TimetableColumns{},
+                                            std::tuple<Column<&EnrolledTimetableRow::student_id>>{}));
+    static constexpr std::string_view select =
+        "SELECT cs.schedule_id, cs.course_code, c.course_name, c.department, c.semester, "
+        "cs.faculty_id, CONCAT(f.first_name, ' ', f.last_name) AS faculty_name, "
+        "cs.timeslot_id, t.day_of_week, CAST(t.start_time AS CHAR), CAST(t.end_time AS CHAR), "
+        "cs.room_id, cl.room_number, cl.building, e.student_id";
+    static constexpr std::string_view tail =
+        "FROM enrollments e "
+        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "ORDER BY e.student_id";
+};
+
+struct AllScheduledCourses {
+    using Row = ScheduledCourse;
+    using Columns = TimetableColumns;
+    static constexpr std::string_view select = timetableSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "ORDER BY cs.faculty_id";
+};
+
+// Current-term sections matching one key, one row per enrolled student and
+// ordered by section. A section nobody has joined comes back once with an
+// empty student_id. Used for removal previews.
+constexpr std::string_view rosterSelect =
+    "SELECT cs.schedule_id, cs.course_code, c.course_name, c.department, c.semester, "
+    "cs.faculty_id, CONCAT(f.first_name, ' ', f.last_name) AS faculty_name, "
+    "cs.timeslot_id, t.day_of_week, CAST(t.start_time AS CHAR), CAST(t.end_time AS CHAR), "
+    "cs.room_id, cl.room_number, cl.building, COALESCE(e.student_id, '')";
+
+using RosterColumns = decltype(std::tuple_cat(TimetableColumns{},
+                                              std::tuple<Column<&EnrolledTimetableRow::student_id>>{}));
+
+struct ScheduleRoster {
+    using Row = EnrolledTimetableRow;
+    using Columns = RosterColumns;
+    static constexpr std::string_view select = rosterSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "LEFT JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "WHERE cs.schedule_id = ? ORDER BY cs.schedule_id";
+};
+
+struct TimeslotRosters {
+    using Row = EnrolledTimetableRow;
+    using Columns = RosterColumns;
+    static constexpr std::string_view select = rosterSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "LEFT JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "WHERE cs.timeslot_id = ? ORDER BY cs.schedule_id";
+};
+
+struct ClassroomRosters {
+    using Row = EnrolledTimetableRow;
+    using Columns = RosterColumns;
+    static constexpr std::string_view select = rosterSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "LEFT JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "WHERE cs.room_id = ? ORDER BY cs.schedule_id";
+};
+
+struct FacultyRosters {
+    using Row = EnrolledTimetableRow;
+    using Columns = RosterColumns;
+    static constexpr std::string_view select = rosterSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "LEFT JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "WHERE cs.faculty_id = ? ORDER BY cs.schedule_id";
+};
+
+struct CourseRosters {
+    using Row = EnrolledTimetableRow;
+    using Columns = RosterColumns;
+    static constexpr std::string_view select = rosterSelect;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "LEFT JOIN enrollments e ON e.schedule_id = cs.schedule_id "
+        "WHERE cs.course_code = ? ORDER BY cs.schedule_id";
+};
+
+struct AllStudentCourses {
+    using Row = StudentCourse;
+    using Columns = std::tuple<
+        Column<&Row::student_id>,
+        Column<&Row::course_code>>;
+    static constexpr std::string_view select = "SELECT DISTINCT e.student_id, cs.course_code";
+    static constexpr std::string_view tail =
+        "FROM enrollments e JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "ORDER BY e.student_id, cs.course_code";
+};
+
+struct AllClassrooms {
+    using Row = Classroom;
+    using Columns = std::tuple<
+        Column<&Row::room_id>,
+        Column<&Row::building>,
+        Column<&Row::room_number>,
+        Column<&Row::capacity>,
+        Column<&Row::room_type>>;
+    static constexpr std::string_view select = "SELECT room_id, building, room_number, capacity, room_type";
+    static constexpr std::string_view tail = "FROM classrooms ORDER BY room_id";
+};
+
+struct AllMarks {
+    using Row = MarkRecord;
+    using Columns = std::tuple<
+        Column<&Row::course_code>,
+        Column<&Row::student_id>,
+        Column<&Row::assignment_name>,
+        Column<&Row::total_marks>,
+        Column<&Row::obtained_marks>,
+        Column<&Row::department>,
+        Column<&Row::credits>,
+        Column<&Row::semester>,
+        Column<&Row::term_id>>;
+    static constexpr std::string_view select =
+        "SELECT m.course_code, m.student_id, m.assignment_name, m.total_marks, m.obtained_marks, "
+        "c.department, c.credits, c.semester, m.term_id";
+    static constexpr std::string_view tail =
+        "FROM marks m JOIN courses c ON m.course_code = c.course_code "
+        "ORDER BY m.course_code, m.student_id, m.term_id, m.assignment_name";
+};
+
+// AllMarks restricted to the student/course pairs logged in results_dirty up
+// to a sequence number.
+struct DirtyMarks {
+    using Row = MarkRecord;
+    using Columns = AllMarks::Columns;
+    static constexpr std::string_view select = AllMarks::select;
+    static constexpr std::string_view tail =
+        "FROM marks m JOIN courses c ON m.course_code = c.course_code "
+        "JOIN (SELECT DISTINCT student_id, course_code FROM results_dirty WHERE seq <= ?) d "
+        "ON d.student_id = m.student_id AND d.course_code = m.course_code "
+        "ORDER BY m.course_code, m.student_id, m.term_id, m.assignment_name";
+};
+
+struct StudentResults {
+    using Row = CourseResult;
+    using Columns = std::tuple<
+        Column<&Row::student_id>,
+        Column<&Row::course_code>,
+        Column<&Row::term_id>,
+        Column<&Row::semester>,
+        Column<&Row::credits>,
+        Column<&Row::percent>,
+        Column<&Row::letter>,
+        Column<&Row::points>>;
+    static constexpr std::string_view select =
+        "SELECT student_id, course_code, term_id, semester, credits, percent, letter, points";
+    static constexpr std::string_view tail =
+        "FROM course_results WHERE student_id = ? ORDER BY semester, course_code, term_id";
+};
+
+struct AllCourseSchedules {
+    using Row = Database::ScheduledAssignment;
+    using Columns = std::tuple<
+        Column<&Row::schedule_id>,
+        Column<&Row::course_code>,
+        Column<&Row::course_name>,
+        Column<&Row::faculty_name>,
+        Column<&Row::room>,
+        Column<&Row::timeslot>>;
+    static constexpr std::string_view select =
+        "SELECT cs.schedule_id, cs.course_code, c.course_name, CONCAT(f.first_name, ' ', f.last_name) AS faculty, "
+        "CONCAT(cl.room_number, ' ', cl.building) AS room, CONCAT(t.day_of_week, ' ', t.start_time, '-', t.end_time) AS timeslot";
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id";
+};
+
+struct EnrolledStudents {
+    using Row = Database::StudentInfo;
+    using Columns = std::tuple<
+        Column<&Row::student_id>,
+        Column<&Row::first_name>,
+        Column<&Row::last_name>,
+        Column<&Row::email>,
+        Column<&Row::semester>,
+        Column<&Row::degree>>;
+    static constexpr std::string_view select =
+        "SELECT DISTINCT s.student_id, s.first_name, s.last_name, s.email, s.semester, s.degree";
+    static constexpr std::string_view tail =
+        "FROM enrollments e "
+        "JOIN students s ON e.student_id = s.student_id "
+        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "WHERE cs.course_code = ?";
+};
+
+struct AllStudents {
+    using Row = Database::StudentInfo;
+    using Columns = EnrolledStudents::Columns;
+    static constexpr std::string_view select =
+        "SELECT student_id, first_name, last_name, email, semester, degree";
+    static constexpr std::string_view tail = "FROM students ORDER BY student_id";
+};
+
+struct StudentFootprints {
+    using Row = Database::StudentFootprint;
+    using Columns = std::tuple<
+        Column<&Row::student_id>,
+        Column<&Row::name>,
+        Column<&Row::enrollments>,
+        Column<&Row::waitlists>,
+        Column<&Row::marks>,
+        Column<&Row::results>>;
+    static constexpr std::string_view select =
+        "SELECT s.student_id, CONCAT(s.first_name, ' ', s.last_name), "
+        "(SELECT COUNT(*) FROM enrollments e WHERE e.student_id = s.student_id), "
+        "(SELECT COUNT(*) FROM waitlist w WHERE w.student_id = s.student_id), "
+        "(SELECT COUNT(*) FROM marks m WHERE m.student_id = s.student_id), "
+        "(SELECT COUNT(*) FROM course_results r WHERE r.student_id = s.student_id)";
+    static constexpr std::string_view tail = "FROM students s WHERE s.student_id = ?";
+};
+
+struct AllFacultyContacts {
+    using Row = Database::FacultyInfo;
+    using Columns = std::tuple<
+        Column<&Row::faculty_id>,
+        Column<&Row::first_name>,
+        Column<&Row::last_name>,
+        Column<&Row::email>>;
+    static constexpr std::string_view select = "SELECT faculty_id, first_name, last_name, email";
+    static constexpr std::string_view tail = "FROM faculty ORDER BY faculty_id";
+};
+
+struct EnrolledStudentsPage {
+    using Row = Database::StudentInfo;
+    using Columns = EnrolledStudents::Columns;
+    static constexpr std::string_view select = EnrolledStudents::select;
+    static constexpr std::string_view tail =
+        "FROM enrollments e "
+        "JOIN students s ON e.student_id = s.student_id "
+        "JOIN course_schedule cs ON e.schedule_id = cs.schedule_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "WHERE cs.course_code = ? AND s.student_id > ? "
+        "ORDER BY s.student_id LIMIT ?";
+};
+
+struct CourseSchedulesPage {
+    using Row = Database::ScheduledAssignment;
+    using Columns = AllCourseSchedules::Columns;
+    static constexpr std::string_view select = AllCourseSchedules::select;
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN courses c ON cs.course_code = c.course_code "
+        "JOIN faculty f ON cs.faculty_id = f.faculty_id "
+        "JOIN timeslots t ON cs.timeslot_id = t.timeslot_id "
+        "JOIN classrooms cl ON cs.room_id = cl.room_id "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "WHERE cs.schedule_id > ? "
+        "ORDER BY cs.schedule_id LIMIT ?";
+};
+
+struct AssignmentMarks {
+    static constexpr std::string_view select =
+        "SELECT m.student_id, m.total_marks, m.obtained_marks";
+    static constexpr std::string_view tail =
+        "FROM marks m JOIN current_term ct ON m.term_id = ct.term_id "
+        "WHERE m.course_code = ? AND m.assignment_name = ?";
+};
+
+using MarkColumns = std::tuple<
+    Column<&Database::Mark::assignment_name>,
+    Column<&Database::Mark::total_marks>,
+    Column<&Database::Mark::obtained_marks>,
+    Column<&Database::Mark::course_name>,
+    Column<&Database::Mark::course_code>>;
+
+struct StudentMarks {
+    using Row = Database::Mark;
+    using Columns = MarkColumns;
+    static constexpr std::string_view select =
+        "SELECT m.assignment_name, m.total_marks, m.obtained_marks, c.course_name, m.course_code";
+    static constexpr std::string_view tail =
+        "FROM marks m "
+        "JOIN courses c ON m.course_code = c.course_code "
+        "WHERE m.student_id = ? "
+        "ORDER BY m.assignment_name";
+};
+
+struct StudentCourseMarks {
+    using Row = Database::Mark;
+    using Columns = MarkColumns;
+    static constexpr std::string_view select = StudentMarks::select;
+    static constexpr std::string_view tail =
+        "FROM marks m "
+        "JOIN courses c ON m.course_code = c.course_code "
+        "WHERE m.student_id = ? AND m.course_code = ? "
+        "ORDER BY m.assignment_name";
+};
+
+struct StudentTermMarks {
+    using Row = Database::Mark;
+    using Columns = MarkColumns;
+    static constexpr std::string_view select = StudentMarks::select;
+    static constexpr std::string_view tail =
+        "FROM marks m "
+        "JOIN courses c ON m.course_code = c.course_code "
+        "WHERE m.student_id = ? AND m.term_id = ? "
+        "ORDER BY m.course_code, m.assignment_name";
+};
+
+// Archived marks outlive their course, so the name falls back to the code.
+struct StudentArchivedMarks {
+    using Row = Database::Mark;
+    using Columns = MarkColumns;
+    static constexpr std::string_view select =
+        "SELECT m.assignment_name, m.total_marks, m.obtained_marks, COALESCE(c.course_name, m.course_code), m.course_code";
+    static constexpr std::string_view tail =
+        "FROM marks_archive m "
+        "LEFT JOIN courses c ON m.course_code = c.course_code "
+        "WHERE m.term_id = ? AND m.student_id = ? "
+        "ORDER BY m.course_code, m.assignment_name";
+};
+
+struct Terms {
+    using Row = Term;
+    using Columns = std::tuple<
+        Column<&Row::term_id>,
+        Column<&Row::name>,
+        Column<&Row::state>>;
+    static constexpr std::string_view select = "SELECT term_id, name, state";
+    static constexpr std::string_view tail = "FROM terms ORDER BY term_id";
+};
+
+struct StudentProfile {
+    static constexpr std::string_view select = "SELECT semester, degree";
+    static constexpr std::string_view tail = "FROM students WHERE student_id = ?";
+};
+
+struct FacultyCourseEnrollment {
+    using Row = Database::CourseEnrollment;
+    using Columns = std::tuple<
+        Column<&Row::course_code>,
+        Column<&Row::students>>;
+    static constexpr std::string_view select =
+        "SELECT cs.course_code, COUNT(DISTINCT e.student_id)";
+    static constexpr std::string_view tail =
+        "FROM course_schedule cs "
+        "JOIN current_term ct ON cs.term_id = ct.term_id "
+        "LEFT JOIN course_schedule other ON other.course_code = cs.course_code AND other.term_id = cs.term_id "
+        "LEFT JOIN enrollments e ON e.schedule_id = other.schedule_id "
+        "WHERE cs.faculty_id = ? "
+        "GROUP BY cs.course_code";
+};
+
+}
@@ -0,0 +1,94 @@
+#include "records.h"
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+std::vector<std::string> splitFields(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char ch = line[i];
+        if (ch == '"') {
+            if (quoted && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else {
+                quoted = !quoted;
+            }
+        } else if (ch == ';' && !quoted) {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else {
+            field += ch;
+        }
+    }
+    fields.push_back(std::move(field));
+    return fields;
+}
+
+std::string trimmed(const std::string& s)
+{
+    const char* space = " \t\r\n";
+    auto first = s.find_first_not_of(space);
+    if (first == std::string::npos)
+        return std::string();
+    return s.substr(first, s.find_last_not_of(space) - first + 1);
+}
+
+const std::string& field(const Record& r, const char* key)
+{
+    static const std::string empty;
+    auto it = r.find(key);
+    return it == r.end() ? empty : it->second;
+}
+
+int number(const Record& r, const char* key)
+{
+    return std::atoi(field(r, key).c_str());
+}
+
+}
+
+std::vector<Record> readRecords(const std::string& path)
+{
+    std::vector<Record> records;
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line))
+        return records;
+    std::vector<std::string> header = splitFields(trimmed(line));
+    while (std::getline(in, line)) {
+        line = trimmed(line);
+        if (line.empty()) continue;
+        std::vector<std::string> fields = splitFields(line);
+        Record record;
+        for (std::size_t i = 0; i < header.size() && i < fields.size(); ++i)
+            record.emplace(header[i], std::move(fields[i]));
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+void stageRecords(Database::Transaction& tx, RecordKind kind, const std::vector<Record>& records)
+{
+    for (const auto& r : records) {
+        switch (kind) {
+        case RecordKind::Students:
+            tx.addStudent(field(r, "student_id"), field(r, "first_name"), field(r, "last_name"), field(r, "email"),
+                          field(r, "degree"), number(r, "semester"), field(r, "password"));
+            break;
+        case RecordKind::Faculty:
+            tx.addFaculty(number(r, "faculty_id"), field(r, "first_name"), field(r, "last_name"), field(r, "email"),
+                          field(r, "degree"), field(r, "qualification"), field(r, "expertise_sub"), field(r, "designation"),
+                          field(r, "password"));
+            break;
+        case RecordKind::Courses:
+            tx.addCourse(field(r, "course_code"), field(r, "course_name"), number(r, "credits"), number(r, "semester"),
+                         field(r, "department"), number(r, "max_students"), field(r, "prerequisites"));
+            break;
+        }
+    }
+}
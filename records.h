@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "database.h"
+
+// One line of a ';'-separated, double-quoted export as kept under Data/,
+// keyed by the header row.
+using Record = std::unordered_map<std::string, std::string>;
+
+enum class RecordKind { Students, Faculty, Courses };
+
+// Returns no records when the file cannot be read.
+std::vector<Record> readRecords(const std::string& path);
+
+// Queues one add per record on tx; columns are named as in the Data/ exports.
+// Rows without a password get the default a password reset sets.
+void stageRecords(Database::Transaction& tx, RecordKind kind, const std::vector<Record>& records);
@@ -0,0 +1,262 @@
+// Re-issues a workload captured with CMS_TRACE=<file> (see trace.h) against
+// the database named by the usual CMS_DB_* variables. Every recorded thread
+// gets its own replay thread and Database connection, so the original
+// concurrency is kept; calls are issued at their recorded offsets divided by
+// --speed, or back to back with --speed max. Reports recorded vs replayed
+// latency per method.
+//
+//   cms_replay trace.bin [--speed N|max]
+//
+// Mutations are replayed as recorded, so point it at a copy of the data the
+// trace was taken from. Passwords are not captured: validations replay with
+// an empty password and password changes set the default password. For the
+// same reason cms_serviced refuses the replayed writes, so leave CMS_SERVICE
+// unset.
+
+#include "database.h"
+#include "trace.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t methodCount = static_cast<std::size_t>(TraceMethod::Count);
+
+struct Stats {
+    std::array<std::vector<double>, methodCount> recordedMs;
+    std::array<std::vector<double>, methodCount> replayedMs;
+    std::array<std::size_t, methodCount> errors{};
+
+    void merge(const Stats& other) {
+        for (std::size_t m = 0; m < methodCount; ++m) {
+            recordedMs[m].insert(recordedMs[m].end(), other.recordedMs[m].begin(), other.recordedMs[m].end());
+            replayedMs[m].insert(replayedMs[m].end(), other.replayedMs[m].begin(), other.replayedMs[m].end());
+            errors[m] += other.errors[m];
+        }
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::size_t rank = static_cast<std::size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+double mean(const std::vector<double>& samples) {
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    return samples.empty() ? 0.0 : sum / samples.size();
+}
+
+struct Args {
+    const std::vector<TraceArg>& args;
+
+    const std::string& s(std::size_t i) const {
+        if (i >= args.size() || !args[i].isText) throw std::runtime_error("malformed trace record");
+        return args[i].text;
+    }
+    int i(std::size_t i) const {
+        if (i >= args.size() || args[i].isText) throw std::runtime_error("malformed trace record");
+        return static_cast<int>(args[i].number);
+    }
+};
+
+void dispatch(Database& db, const TraceRecord& record) {
+    Args a{record.args};
+    switch (record.method) {
+    case TraceMethod::StudentExists: db.studentExists(a.s(0)); break;
+    case TraceMethod::ValidateStudentPassword: db.validateStudentPassword(a.s(0), a.s(1)); break;
+    case TraceMethod::ChangeStudentPassword: db.changeStudentPassword(a.s(0), "bnu"); break;
+    case TraceMethod::ResetStudentPassword: db.resetStudentPassword(a.s(0)); break;
+    case TraceMethod::GetStudentSemester: db.getStudentSemester(a.s(0)); break;
+    case TraceMethod::GetStudentDegree: db.getStudentDegree(a.s(0)); break;
+    case TraceMethod::FacultyExists: db.facultyExists(a.s(0)); break;
+    case TraceMethod::ValidateFacultyPassword: db.validateFacultyPassword(a.s(0), a.s(1)); break;
+    case TraceMethod::GetFacultyId: db.getFacultyId(a.s(0)); break;
+    case TraceMethod::GetFacultyName: db.getFacultyName(a.s(0)); break;
+    case TraceMethod::ChangeFacultyPassword: db.changeFacultyPassword(a.s(0), "faculty_scit"); break;
+    case TraceMethod::ResetFacultyPassword: db.resetFacultyPassword(a.s(0)); break;
+    case TraceMethod::GetAvailableScheduledCourses: db.getAvailableScheduledCourses(a.i(0), a.s(1)); break;
+    case TraceMethod::IsAlreadyEnrolled: db.isAlreadyEnrolled(a.s(0), a.i(1)); break;
+    case TraceMethod::HasClash: db.hasClash(a.s(0), a.i(1)); break;
+    case TraceMethod::AddEnrollment: db.addEnrollment(a.s(0), a.i(1)); break;
+    case TraceMethod::DropEnrollment: db.dropEnrollment(a.s(0), a.i(1)); break;
+    case TraceMethod::GetEnrolledCourses: db.getEnrolledCourses(a.s(0)); break;
+    case TraceMethod::AddStudent: db.addStudent(a.s(0), a.s(1), a.s(2), a.s(3), a.s(4), a.i(5)); break;
+    case TraceMethod::RemoveStudent: db.removeStudent(a.s(0)); break;
+    case TraceMethod::AddFaculty: db.addFaculty(a.i(0), a.s(1), a.s(2), a.s(3), a.s(4), a.s(5), a.s(6), a.s(7)); break;
+    case TraceMethod::RemoveFaculty: db.removeFaculty(a.i(0)); break;
+    case TraceMethod::AddCourse: db.addCourse(a.s(0), a.s(1), a.i(2), a.i(3), a.s(4), a.i(5), a.s(6)); break;
+    case TraceMethod::RemoveCourse: db.removeCourse(a.s(0)); break;
+    case TraceMethod::AddClassroom: db.addClassroom(a.s(0), a.s(1), a.s(2), a.i(3), a.s(4)); break;
+    case TraceMethod::RemoveClassroom: db.removeClassroom(a.s(0)); break;
+    case TraceMethod::AddTimeslot: db.addTimeslot(a.s(0), a.s(1), a.s(2)); break;
+    case TraceMethod::RemoveTimeslot: db.removeTimeslot(a.i(0)); break;
+    case TraceMethod::GetUnscheduledCourses: db.getUnscheduledCourses(); break;
+    case TraceMethod::GetAllCourses: db.getAllCourses(); break;
+    case TraceMethod::GetAllFaculty: db.getAllFaculty(); break;
+    case TraceMethod::GetAllTimeslots: db.getAllTimeslots(); break;
+    case TraceMethod::GetAvailableRooms: db.getAvailableRooms(a.i(0)); break;
+    case TraceMethod::GetAvailableFaculty: db.getAvailableFaculty(a.i(0)); break;
+    case TraceMethod::AddCourseSchedule: db.addCourseSchedule(a.s(0), a.i(1), a.i(2), a.s(3)); break;
+    case TraceMethod::GetAllCourseSchedules: db.getAllCourseSchedules(); break;
+    case TraceMethod::GetCourseSchedulesPage: db.getCourseSchedulesPage(a.i(0), a.i(1)); break;
+    case TraceMethod::RemoveCourseSchedule: db.removeCourseSchedule(a.i(0)); break;
+    case TraceMethod::GetFacultyCourses: db.getFacultyCourses(a.i(0)); break;
+    case TraceMethod::GetAllStudents: db.getAllStudents(); break;
+    case TraceMethod::GetEnrolledStudentsInCourse: db.getEnrolledStudentsInCourse(a.s(0)); break;
+    case TraceMethod::GetEnrolledStudentsPage: db.getEnrolledStudentsPage(a.s(0), a.s(1), a.i(2)); break;
+    case TraceMethod::GetFacultyTimetable: db.getFacultyTimetable(a.i(0)); break;
+    case TraceMethod::GetTotalEnrolledStudents: db.getTotalEnrolledStudents(a.s(0)); break;
+    case TraceMethod::AddMarks: db.addMarks(a.s(0), a.s(1), a.s(2), a.i(3), a.i(4)); break;
+    case TraceMethod::UpdateMarks: db.updateMarks(a.s(0), a.s(1), a.s(2), a.i(3)); break;
+    case TraceMethod::GetAssignmentsForCourse: db.getAssignmentsForCourse(a.s(0)); break;
+    case TraceMethod::GetStudentMarksForAssignment: db.getStudentMarksForAssignment(a.s(0), a.s(1)); break;
+    case TraceMethod::FetchStudentMarksForAssignment: db.fetchStudentMarksForAssignment(a.s(0), a.s(1)); break;
+    case TraceMethod::GetStudentMarks: db.getStudentMarks(a.s(0), a.s(1)); break;
+    case TraceMethod::GetStudentCourses: db.getStudentCourses(a.s(0)); break;
+    case TraceMethod::LoadStudentDashboard: db.loadStudentDashboard(a.s(0)); break;
+    case TraceMethod::LoadFacultyDashboard: db.loadFacultyDashboard(a.i(0)); break;
+    case TraceMethod::ChangeVersions: db.changeVersions(); break;
+    case TraceMethod::JoinWaitlist: db.joinWaitlist(a.s(0), a.i(1)); break;
+    case TraceMethod::LeaveWaitlist: db.leaveWaitlist(a.s(0), a.i(1)); break;
+    case TraceMethod::GetStudentWaitlists: db.getStudentWaitlists(a.s(0)); break;
+    case TraceMethod::GetCourseResults: db.getCourseResults(a.s(0)); break;
+    case TraceMethod::CurrentTerm: db.currentTerm(); break;
+    case TraceMethod::GetTerms: db.getTerms(); break;
+    case TraceMethod::StartTerm: db.startTerm(a.s(0)); break;
+    case TraceMethod::CloseTerm: db.closeTerm(a.i(0)); break;
+    case TraceMethod::ArchiveTerm: db.archiveTerm(a.i(0)); break;
+    case TraceMethod::GetStudentTermMarks: db.getStudentTermMarks(a.s(0), a.i(1)); break;
+    case TraceMethod::GetScheduleRoster: db.getScheduleRoster(a.i(0)); break;
+    case TraceMethod::GetTimeslotRosters: db.getTimeslotRosters(a.i(0)); break;
+    case TraceMethod::GetClassroomRosters: db.getClassroomRosters(a.s(0)); break;
+    case TraceMethod::GetFacultyRosters: db.getFacultyRosters(a.i(0)); break;
+    case TraceMethod::GetCourseRosters: db.getCourseRosters(a.s(0)); break;
+    case TraceMethod::GetStudentFootprint: db.getStudentFootprint(a.s(0)); break;
+    case TraceMethod::Count: throw std::runtime_error("unknown method in trace");
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string path;
+    double speed = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--speed") && i + 1 < argc) {
+            ++i;
+            speed = std::strcmp(argv[i], "max") ? std::atof(argv[i]) : 0.0;
+            if (speed < 0.0) speed = 0.0;
+        } else if (path.empty()) {
+            path = argv[i];
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: cms_replay trace.bin [--speed N|max]" << std::endl;
+        return 2;
+    }
+
+    TraceReader reader(path);
+    if (!reader.ok()) {
+        std::cerr << path << " is not a CMS trace" << std::endl;
+        return 1;
+    }
+    std::map<std::uint32_t, std::vector<TraceRecord>> byThread;
+    std::size_t total = 0;
+    std::uint64_t first = UINT64_MAX, last = 0;
+    for (TraceRecord record; reader.next(record); ++total) {
+        first = std::min(first, record.startUs);
+        last = std::max(last, record.startUs + record.durationUs);
+        byThread[record.thread].push_back(record);
+    }
+    if (!total) {
+        std::cerr << "trace is empty" << std::endl;
+        return 1;
+    }
+    // Records are written when a call returns, so sort each thread by start.
+    for (auto& entry : byThread)
+        std::sort(entry.second.begin(), entry.second.end(),
+                  [](const TraceRecord& a, const TraceRecord& b) { return a.startUs < b.startUs; });
+
+    DatabaseConfig config = DatabaseConfig::fromEnvironment(DatabaseConfig());
+    config.tracePath.clear();
+    std::cout << "Replaying " << total << " calls from " << byThread.size() << " threads at "
+              << (speed > 0.0 ? std::to_string(speed) + "x" : std::string("max speed")) << "\n";
+
+    std::vector<std::unique_ptr<Database>> connections;
+    try {
+        for (std::size_t t = 0; t < byThread.size(); ++t)
+            connections.push_back(std::make_unique<Database>(config));
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::mutex mutex;
+    Stats totals;
+    const auto origin = std::chrono::steady_clock::now();
+    auto worker = [&](Database& db, const std::vector<TraceRecord>& records) {
+        Stats stats;
+        for (const auto& record : records) {
+            if (speed > 0.0)
+                std::this_thread::sleep_until(origin + std::chrono::microseconds(
+                    static_cast<std::int64_t>((record.startUs - first) / speed)));
+            auto m = static_cast<std::size_t>(record.method);
+            if (m >= methodCount)
+                continue;
+            auto start = std::chrono::steady_clock::now();
+            try {
+                dispatch(db, record);
+            }
+            catch (const std::exception& e) {
+                if (stats.errors[m]++ == 0)
+                    std::cerr << traceMethodName(record.method) << " failed: " << e.what() << std::endl;
+            }
+            stats.replayedMs[m].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            stats.recordedMs[m].push_back(record.durationUs / 1000.0);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        totals.merge(stats);
+    };
+
+    std::vector<std::thread> pool;
+    std::size_t index = 0;
+    for (const auto& entry : byThread)
+        pool.emplace_back(worker, std::ref(*connections[index++]), std::cref(entry.second));
+    for (auto& t : pool)
+        t.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+
+    std::printf("\n%-32s %8s %8s %11s %11s %11s %11s\n", "method", "calls", "errors",
+                "rec mean", "rec p99", "mean ms", "p99 ms");
+    for (std::size_t m = 0; m < methodCount; ++m) {
+        auto& recorded = totals.recordedMs[m];
+        auto& replayed = totals.replayedMs[m];
+        if (replayed.empty() && !totals.errors[m])
+            continue;
+        std::sort(recorded.begin(), recorded.end());
+        std::sort(replayed.begin(), replayed.end());
+        std::printf("%-32s %8zu %8zu %11.2f %11.2f %11.2f %11.2f\n", traceMethodName(static_cast<TraceMethod>(m)),
+                    replayed.size(), totals.errors[m], mean(recorded), percentile(recorded, 99),
+                    mean(replayed), percentile(replayed, 99));
+    }
+    std::printf("\nrecorded span %.2f s, replayed in %.2f s\n", (last - first) / 1e6, seconds);
+    return 0;
+}
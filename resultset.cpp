@@ -0,0 +1,112 @@
+#include "resultset.h"
+#include <cstring>
+
+// X protocol string fields carry a trailing 0x00 in their raw encoding.
+static std::size_t rawStringLength(const mysqlx::bytes& raw)
+{
+    std::size_t len = raw.size();
+    if (len > 0 && raw.begin()[len - 1] == 0)
+        --len;
+    return len;
+}
+
+ResultSet::ResultSet(mysqlx::SqlResult& res)
+{
+    columns = res.getColumnCount();
+    mysqlx::Row row;
+    while ((row = res.fetchOne())) {
+        for (std::size_t col = 0; col < columns; ++col)
+            appendValue(row, col);
+        ++rows;
+    }
+}
+
+void ResultSet::appendValue(const mysqlx::Row& row, std::size_t col)
+{
+    Cell c;
+    const mysqlx::Value& v = row.get(col);
+    switch (v.getType()) {
+    case mysqlx::Value::STRING: {
+        mysqlx::bytes raw = row.getBytes(col);
+        c.offset = static_cast<std::uint32_t>(arena.size());
+        c.length = static_cast<std::uint32_t>(rawStringLength(raw));
+        arena.insert(arena.end(), raw.begin(), raw.begin() + c.length);
+        c.null = false;
+        break;
+    }
+    case mysqlx::Value::INT64:
+    case mysqlx::Value::UINT64:
+    case mysqlx::Value::BOOL:
+        c.number = v.get<std::int64_t>();
+        c.null = false;
+        break;
+    default:
+        break;
+    }
+    cells.push_back(c);
+}
+
+template <typename T>
+static void putRaw(std::string& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool getRaw(std::string_view& in, T& value)
+{
+    if (in.size() < sizeof(T))
+        return false;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+std::string ResultSet::toBytes() const
+{
+    std::string out;
+    out.reserve(3 * sizeof(std::uint64_t) + cells.size() * 17 + arena.size());
+    putRaw<std::uint64_t>(out, columns);
+    putRaw<std::uint64_t>(out, rows);
+    putRaw<std::uint64_t>(out, arena.size());
+    for (const Cell& c : cells) {
+        putRaw(out, c.number);
+        putRaw(out, c.offset);
+        putRaw(out, c.length);
+        out += c.null ? '\1' : '\0';
+    }
+    out.append(arena.data(), arena.size());
+    return out;
+}
+
+ResultSet ResultSet::fromBytes(std::string_view in)
+{
+    ResultSet rs;
+    std::uint64_t columns = 0, rows = 0, bytes = 0;
+    if (!getRaw(in, columns) || !getRaw(in, rows) || !getRaw(in, bytes))
+        return ResultSet();
+    // Rows of no columns have no cells to check, and each cell takes
+    // cellBytes of the image, so these bound columns * rows without
+    // overflowing.
+    if (!columns && rows)
+        return ResultSet();
+    constexpr std::size_t cellBytes = sizeof(Cell::number) + sizeof(Cell::offset) + sizeof(Cell::length) + 1;
+    if (columns && rows && (columns > in.size() / cellBytes || rows > in.size() / cellBytes / columns))
+        return ResultSet();
+    rs.cells.resize(columns * rows);
+    for (Cell& c : rs.cells) {
+        char null = 0;
+        if (!getRaw(in, c.number) || !getRaw(in, c.offset) || !getRaw(in, c.length) || !getRaw(in, null))
+            return ResultSet();
+        c.null = null != 0;
+    }
+    if (in.size() < bytes)
+        return ResultSet();
+    for (const Cell& c : rs.cells)
+        if (std::uint64_t(c.offset) + c.length > bytes)
+            return ResultSet();
+    rs.arena.assign(in.begin(), in.begin() + bytes);
+    rs.columns = columns;
+    rs.rows = rows;
+    return rs;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mysqlx/xdevapi.h>
+
+// Read-only copy of a query result. All string data of all rows lives in one
+// contiguous arena; rows hand out string_views into it, so a roster of N rows
+// costs a couple of buffer growths instead of one heap string per cell.
+// Views stay valid for as long as the ResultSet itself.
+class ResultSet {
+    struct Cell {
+        std::int64_t number = 0;
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+        bool null = true;
+    };
+
+    std::vector<char> arena;
+    std::vector<Cell> cells;
+    std::size_t columns = 0;
+    std::size_t rows = 0;
+
+    void appendValue(const mysqlx::Row& row, std::size_t col);
+
+public:
+    class Row {
+        const ResultSet* rs;
+        std::size_t index;
+        const Cell& cell(std::size_t col) const { return rs->cells[index * rs->columns + col]; }
+
+    public:
+        Row(const ResultSet* rs, std::size_t index) : rs(rs), index(index) {}
+
+        std::size_t size() const { return rs->columns; }
+        bool isNull(std::size_t col) const { return cell(col).null; }
+        std::string_view text(std::size_t col) const;
+        int integer(std::size_t col) const { return static_cast<int>(cell(col).number); }
+        std::string_view operator[](std::size_t col) const { return text(col); }
+    };
+
+    class const_iterator {
+        const ResultSet* rs;
+        std::size_t index;
+
+    public:
+        const_iterator(const ResultSet* rs, std::size_t index) : rs(rs), index(index) {}
+        Row operator*() const { return Row(rs, index); }
+        const_iterator& operator++() { ++index; return *this; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+    };
+
+    ResultSet() = default;
+    explicit ResultSet(mysqlx::SqlResult& res);
+
+    ResultSet(ResultSet&&) = default;
+    ResultSet& operator=(ResultSet&&) = default;
+    ResultSet(const ResultSet&) = delete;
+    ResultSet& operator=(const ResultSet&) = delete;
+
+    // Flat host-endian image for handing a result to another process on the
+    // same machine (cms_serviced). fromBytes() yields an empty set on a
+    // truncated image or one whose cells point outside its arena.
+    std::string toBytes() const;
+    static ResultSet fromBytes(std::string_view bytes);
+
+    std::size_t size() const { return rows; }
+    std::size_t columnCount() const { return columns; }
+    bool empty() const { return rows == 0; }
+    Row operator[](std::size_t i) const { return Row(this, i); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, rows); }
+};
+
+inline std::string_view ResultSet::Row::text(std::size_t col) const
+{
+    const Cell& c = cell(col);
+    return std::string_view(rs->arena.data() + c.offset, c.length);
+}
@@ -0,0 +1,409 @@
+#include "searchindex.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Bytes of multi-byte UTF-8 sequences count as letters, so accented names
+// stay whole words.
+bool wordByte(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+char lower(unsigned char c)
+{
+    return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+}
+
+void splitWords(std::string_view text, std::vector<std::string>& out)
+{
+    std::string word;
+    for (unsigned char c : text) {
+        if (wordByte(c)) {
+            word += lower(c);
+        } else if (!word.empty()) {
+            out.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty())
+        out.push_back(std::move(word));
+}
+
+std::string compact(std::string_view text)
+{
+    std::string out;
+    for (unsigned char c : text)
+        if (wordByte(c))
+            out += lower(c);
+    return out;
+}
+
+// Trigrams of the word padded with two spaces in front and one behind, so
+// short words have some and a shared start counts for more. Words with
+// digits are ids and numbers, where a near miss is a different record, and
+// get none.
+std::vector<std::uint32_t> trigrams(const std::string& word)
+{
+    std::vector<std::uint32_t> grams;
+    for (char ch : word)
+        if (ch >= '0' && ch <= '9')
+            return grams;
+    const std::string padded = "  " + word + " ";
+    for (std::size_t i = 0; i + 3 <= padded.size(); ++i)
+        grams.push_back(static_cast<std::uint32_t>(static_cast<unsigned char>(padded[i])) << 16 |
+                        static_cast<std::uint32_t>(static_cast<unsigned char>(padded[i + 1])) << 8 |
+                        static_cast<std::uint32_t>(static_cast<unsigned char>(padded[i + 2])));
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+bool anyStartsWith(const std::vector<std::string>& words, const std::string& prefix)
+{
+    for (const auto& w : words)
+        if (w.compare(0, prefix.size(), prefix) == 0)
+            return true;
+    return false;
+}
+
+ChangeFeed feedOf(SearchKind kind)
+{
+    switch (kind) {
+    case SearchKind::Student: return ChangeFeed::Students;
+    case SearchKind::Faculty: return ChangeFeed::Faculty;
+    case SearchKind::Course: break;
+    }
+    return ChangeFeed::Courses;
+}
+
+}
+
+void SearchIndex::clear()
+{
+    entries.clear();
+    live = 0;
+    for (auto& index : byKey)
+        index.clear();
+    nodes.assign(1, Node());
+    vocabulary.clear();
+    postings.clear();
+    trigramWords.clear();
+    stamp.clear();
+    shared.clear();
+}
+
+void SearchIndex::refresh()
+{
+    ChangeVersions now = db.changeVersions();
+    if (built && !now.changedSince(builtAt, {ChangeFeed::Students, ChangeFeed::Faculty, ChangeFeed::Courses}))
+        return;
+
+    clear();
+    db.streamStudents([&](Database::StudentInfo& row) { putStudent(row); });
+    db.streamFaculty([&](Database::FacultyInfo& row) { putFaculty(row); });
+    for (const auto& course : db.getAllCourses())
+        putCourse(course.first, course.second);
+
+    builtAt = now;
+    built = true;
+}
+
+void SearchIndex::load(const std::vector<Database::StudentInfo>& students, const std::vector<Database::FacultyInfo>& faculty,
+                       const std::vector<std::pair<std::string, std::string>>& courses)
+{
+    clear();
+    for (const auto& student : students)
+        putStudent(student);
+    for (const auto& member : faculty)
+        putFaculty(member);
+    for (const auto& course : courses)
+        putCourse(course.first, course.second);
+    built = true;
+}
+
+void SearchIndex::putStudent(const Database::StudentInfo& s)
+{
+    insert({SearchKind::Student, s.student_id,
+            s.student_id + " - " + s.first_name + " " + s.last_name + " <" + s.email + ">"},
+           {s.first_name, s.last_name}, {s.student_id, s.email});
+}
+
+void SearchIndex::putFaculty(const Database::FacultyInfo& f)
+{
+    insert({SearchKind::Faculty, f.email, f.first_name + " " + f.last_name + " <" + f.email + ">"},
+           {f.first_name, f.last_name, std::to_string(f.faculty_id)}, {f.email});
+}
+
+void SearchIndex::putCourse(const std::string& code, const std::string& name)
+{
+    insert({SearchKind::Course, code, code + " - " + name}, {name}, {code});
+}
+
+void SearchIndex::insert(SearchHit hit, std::initializer_list<std::string_view> words,
+                         std::initializer_list<std::string_view> keys)
+{
+    // A key already indexed is replaced in its slot.
+    auto& index = byKey[static_cast<int>(hit.kind)];
+    auto existing = index.find(hit.key);
+    std::uint32_t id;
+    if (existing != index.end()) {
+        id = existing->second;
+        dropPostings(id);
+    } else {
+        id = static_cast<std::uint32_t>(entries.size());
+        entries.emplace_back();
+        ++live;
+    }
+    Entry entry;
+    for (auto text : words)
+        splitWords(text, entry.words);
+    for (auto text : keys) {
+        splitWords(text, entry.words);
+        entry.words.push_back(compact(text));
+    }
+    std::sort(entry.words.begin(), entry.words.end());
+    entry.words.erase(std::unique(entry.words.begin(), entry.words.end()), entry.words.end());
+    if (!entry.words.empty() && entry.words.front().empty())
+        entry.words.erase(entry.words.begin());
+
+    for (const auto& word : entry.words)
+        insertWord(word, id);
+    index[hit.key] = id;
+    entry.hit = std::move(hit);
+    entries[id] = std::move(entry);
+}
+
+void SearchIndex::insertWord(const std::string& word, std::uint32_t entry)
+{
+    std::uint32_t node = 0;
+    for (char ch : word) {
+        std::uint32_t next = nodes[node].child;
+        while (next && nodes[next].ch != ch)
+            next = nodes[next].sibling;
+        if (!next) {
+            next = static_cast<std::uint32_t>(nodes.size());
+            Node child;
+            child.ch = ch;
+            child.sibling = nodes[node].child;
+            nodes.push_back(child);
+            nodes[node].child = next;
+        }
+        node = next;
+    }
+    if (!nodes[node].word) {
+        const auto id = static_cast<std::uint32_t>(vocabulary.size());
+        for (std::uint32_t gram : trigrams(word))
+            trigramWords[gram].push_back(id);
+        vocabulary.push_back(word);
+        postings.emplace_back();
+        nodes[node].word = id + 1;
+    }
+    // Kept in entry order; a replaced entry goes back into its old place.
+    auto& list = postings[nodes[node].word - 1];
+    auto pos = std::lower_bound(list.begin(), list.end(), entry);
+    if (pos == list.end() || *pos != entry)
+        list.insert(pos, entry);
+}
+
+void SearchIndex::dropPostings(std::uint32_t entry)
+{
+    for (const auto& word : entries[entry].words) {
+        auto& list = postings[nodes[findNode(word)].word - 1];
+        auto pos = std::lower_bound(list.begin(), list.end(), entry);
+        if (pos != list.end() && *pos == entry)
+            list.erase(pos);
+    }
+    entries[entry].words.clear();
+}
+
+std::uint32_t SearchIndex::findNode(const std::string& prefix) const
+{
+    std::uint32_t node = 0;
+    for (char ch : prefix) {
+        node = nodes[node].child;
+        while (node && nodes[node].ch != ch)
+            node = nodes[node].sibling;
+        if (!node)
+            return 0;
+    }
+    return node;
+}
+
+// Closest by trigram Jaccard similarity among the words sharing at least
+// half of this one's trigrams and still having entries.
+std::vector<std::string> SearchIndex::similarWords(const std::string& word)
+{
+    const std::vector<std::uint32_t> grams = trigrams(word);
+    shared.resize(vocabulary.size());
+    std::vector<std::uint32_t> touched;
+    for (std::uint32_t gram : grams) {
+        auto it = trigramWords.find(gram);
+        if (it == trigramWords.end())
+            continue;
+        for (std::uint32_t w : it->second)
+            if (shared[w]++ == 0)
+                touched.push_back(w);
+    }
+
+    const std::size_t need = (grams.size() + 1) / 2;
+    std::vector<std::pair<double, std::uint32_t>> scored;
+    for (std::uint32_t w : touched) {
+        if (need && shared[w] >= need && !postings[w].empty()) {
+            const std::size_t own = vocabulary[w].size() + 1;
+            scored.emplace_back(static_cast<double>(shared[w]) / static_cast<double>(grams.size() + own - shared[w]), w);
+        }
+        shared[w] = 0;
+    }
+    const std::size_t keep = std::min(corrections, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + keep, scored.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    std::vector<std::string> similar;
+    for (std::size_t i = 0; i < keep; ++i)
+        similar.push_back(vocabulary[scored[i].second]);
+    return similar;
+}
+
+std::vector<SearchHit> SearchIndex::find(const std::string& query, std::size_t limit, std::optional<SearchKind> kind,
+                                         const std::function<bool(const SearchHit&)>& accept)
+{
+    std::vector<SearchHit> hits;
+    if (limit == 0)
+        return hits;
+    auto wanted = [&](std::uint32_t e) {
+        const Entry& entry = entries[e];
+        return entry.live && (!kind || entry.hit.kind == *kind) && (!accept || accept(entry.hit));
+    };
+
+    std::vector<std::string> words;
+    splitWords(query, words);
+    if (words.empty()) {
+        for (std::uint32_t e = 0; e < entries.size() && hits.size() < limit; ++e)
+            if (wanted(e))
+                hits.push_back(entries[e].hit);
+        return hits;
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    // Each query word as typed, or the words it was probably meant to be.
+    struct Term {
+        std::vector<std::string> forms;
+        bool typed;
+    };
+    std::vector<Term> terms;
+    for (auto& word : words) {
+        if (findNode(word)) {
+            terms.push_back({{std::move(word)}, true});
+        } else {
+            terms.push_back({similarWords(word), false});
+            if (terms.back().forms.empty())
+                return hits;
+        }
+    }
+    // The longest word as typed narrows the most and leads; the others only
+    // have to start a word of the same entry.
+    std::stable_sort(terms.begin(), terms.end(), [](const Term& a, const Term& b) {
+        return a.typed != b.typed ? a.typed : a.forms.front().size() > b.forms.front().size();
+    });
+
+    stamp.resize(entries.size());
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    auto matchesRest = [&](std::uint32_t e) {
+        for (std::size_t t = 1; t < terms.size(); ++t) {
+            bool any = false;
+            for (std::size_t f = 0; f < terms[t].forms.size() && !any; ++f)
+                any = anyStartsWith(entries[e].words, terms[t].forms[f]);
+            if (!any)
+                return false;
+        }
+        return true;
+    };
+
+    // Breadth-first below the lead so an exact word, then the shortest
+    // completions, come first.
+    for (const auto& lead : terms.front().forms) {
+        std::uint32_t start = findNode(lead);
+        if (!start)
+            continue;
+        queue.assign(1, start);
+        for (std::size_t head = 0; head < queue.size() && hits.size() < limit; ++head) {
+            const Node& node = nodes[queue[head]];
+            if (node.word) {
+                for (std::uint32_t e : postings[node.word - 1]) {
+                    if (stamp[e] == generation)
+                        continue;
+                    stamp[e] = generation;
+                    if (matchesRest(e) && wanted(e)) {
+                        hits.push_back(entries[e].hit);
+                        if (hits.size() == limit)
+                            break;
+                    }
+                }
+            }
+            for (std::uint32_t child = node.child; child; child = nodes[child].sibling)
+                queue.push_back(child);
+        }
+        if (hits.size() == limit)
+            break;
+    }
+    return hits;
+}
+
+void SearchIndex::mirrored(ChangeFeed feed)
+{
+    ++builtAt.version[static_cast<std::size_t>(feed)];
+}
+
+void SearchIndex::addStudent(const Database::StudentInfo& student)
+{
+    if (!built)
+        return;
+    putStudent(student);
+    mirrored(ChangeFeed::Students);
+}
+
+void SearchIndex::addFaculty(const Database::FacultyInfo& faculty)
+{
+    if (!built)
+        return;
+    putFaculty(faculty);
+    mirrored(ChangeFeed::Faculty);
+}
+
+void SearchIndex::addCourse(const std::string& code, const std::string& name)
+{
+    if (!built)
+        return;
+    putCourse(code, name);
+    mirrored(ChangeFeed::Courses);
+}
+
+std::optional<SearchHit> SearchIndex::lookup(SearchKind kind, const std::string& key) const
+{
+    const auto& index = byKey[static_cast<int>(kind)];
+    auto it = index.find(key);
+    if (it == index.end())
+        return std::nullopt;
+    return entries[it->second].hit;
+}
+
+void SearchIndex::remove(SearchKind kind, const std::string& key)
+{
+    if (!built)
+        return;
+    auto& index = byKey[static_cast<int>(kind)];
+    auto it = index.find(key);
+    if (it != index.end()) {
+        dropPostings(it->second);
+        entries[it->second].live = false;
+        --live;
+        index.erase(it);
+    }
+    mirrored(feedOf(kind));
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "database.h"
+
+enum class SearchKind { Student, Faculty, Course };
+
+struct SearchHit {
+    SearchKind kind;
+    std::string key;        // student id, faculty email or course code
+    std::string label;      // what a picker shows
+};
+
+// Type-ahead index over students (id, name, email), faculty (name, email) and
+// courses (code, name). Every field is split into lower-case alphanumeric
+// words, and ids, emails and codes are also indexed with their separators
+// dropped, so "bscs21" finds BSCS-21-001. Words go into a trie: a query finds
+// the entries with a word starting with each of its words, shortest words
+// first. A query word that starts no indexed word is taken as a typo and
+// stands for the few indexed words sharing the most of its trigrams.
+//
+// Built from streaming reads; refresh() rebuilds it when the Students,
+// Faculty or Courses feed has moved. find() and lookup() never touch the
+// database, so a picker refreshes once when it opens and every keystroke
+// stays in memory. The add and remove calls mirror a write this process has
+// just made, so the index is only rebuilt once those feeds have moved
+// further than such writes.
+class SearchIndex {
+public:
+    explicit SearchIndex(Database& db) : db(db) {}
+
+    void refresh();
+    // Builds the index from rows already in memory instead of the database.
+    void load(const std::vector<Database::StudentInfo>& students, const std::vector<Database::FacultyInfo>& faculty,
+              const std::vector<std::pair<std::string, std::string>>& courses);
+
+    // Up to limit hits, best first, optionally of one kind and passing
+    // accept. An empty query lists the first entries in index order.
+    std::vector<SearchHit> find(const std::string& query, std::size_t limit, std::optional<SearchKind> kind = {},
+                                const std::function<bool(const SearchHit&)>& accept = {});
+    // The entry whose key is exactly key, if any.
+    std::optional<SearchHit> lookup(SearchKind kind, const std::string& key) const;
+
+    void addStudent(const Database::StudentInfo& student);
+    void addFaculty(const Database::FacultyInfo& faculty);
+    void addCourse(const std::string& code, const std::string& name);
+    void remove(SearchKind kind, const std::string& key);
+
+    std::size_t size() const { return live; }
+
+private:
+    struct Entry {
+        SearchHit hit;
+        std::vector<std::string> words;
+        bool live = true;
+    };
+    // First-child / next-sibling trie; index 0 is the root, so 0 also means
+    // "none" for child and sibling. word is 1-based into vocabulary.
+    struct Node {
+        std::uint32_t child = 0;
+        std::uint32_t sibling = 0;
+        std::uint32_t word = 0;
+        char ch = 0;
+    };
+    // Indexed words a misspelt query word stands for.
+    static constexpr std::size_t corrections = 3;
+
+    Database& db;
+    bool built = false;
+    ChangeVersions builtAt;
+
+    std::vector<Entry> entries;
+    std::size_t live = 0;
+    std::unordered_map<std::string, std::uint32_t> byKey[3];
+    std::vector<Node> nodes;
+    // Distinct words, the entries having each, and trigram -> words.
+    std::vector<std::string> vocabulary;
+    std::vector<std::vector<std::uint32_t>> postings;
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> trigramWords;
+
+    // Scratch for find(): an entry was seen by the current query when its
+    // stamp equals generation.
+    std::vector<std::uint32_t> stamp;
+    std::uint32_t generation = 0;
+    std::vector<std::uint32_t> queue;
+    std::vector<std::uint16_t> shared;
+
+    void clear();
+    void putStudent(const Database::StudentInfo& student);
+    void putFaculty(const Database::FacultyInfo& faculty);
+    void putCourse(const std::string& code, const std::string& name);
+    // words are indexed as split; keys also with their separators dropped.
+    void insert(SearchHit hit, std::initializer_list<std::string_view> words,
+                std::initializer_list<std::string_view> keys);
+    void insertWord(const std::string& word, std::uint32_t entry);
+    // Takes entry out of the postings of its words.
+    void dropPostings(std::uint32_t entry);
+    std::uint32_t findNode(const std::string& prefix) const;
+    std::vector<std::string> similarWords(const std::string& word);
+    void mirrored(ChangeFeed feed);
+};
@@ -0,0 +1,53 @@
+#include "serviceclient.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+ServiceClient::ServiceClient(const std::string& socketPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Service socket path too long: " + socketPath);
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::string reason = std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("Cannot reach enrollment service at " + socketPath + ": " + reason);
+    }
+}
+
+ServiceClient::~ServiceClient()
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+void ServiceClient::setQueueListener(QueueListener listener)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    queueListener = std::move(listener);
+}
+
+std::string ServiceClient::roundTrip(const std::string& request)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string reply;
+    if (!wire::writeFrame(fd, request))
+        throw std::runtime_error("Lost connection to the enrollment service");
+    for (;;) {
+        if (!wire::readFrame(fd, reply))
+            throw std::runtime_error("Lost connection to the enrollment service");
+        wire::Reader in(reply);
+        if (in.read<std::uint64_t>() != wire::replyQueued)
+            return reply;
+        auto position = in.read<std::uint64_t>();
+        auto depth = in.read<std::uint64_t>();
+        if (queueListener)
+            queueListener(position, depth);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "servicewire.h"
+#include "trace.h"
+
+// Connection to cms_serviced over its Unix socket. Calls are synchronous and
+// serialized per client; a Database in service mode owns one.
+class ServiceClient {
+public:
+    explicit ServiceClient(const std::string& socketPath);
+    ~ServiceClient();
+    ServiceClient(const ServiceClient&) = delete;
+    ServiceClient& operator=(const ServiceClient&) = delete;
+
+    // Called, on the calling thread, while a request waits for admission.
+    using QueueListener = std::function<void(std::size_t position, std::size_t depth)>;
+    void setQueueListener(QueueListener listener);
+
+    template <typename R, typename... Args>
+    R call(TraceMethod method, const Args&... args) {
+        wire::Writer request;
+        request.put(static_cast<std::uint64_t>(method));
+        (request.put(args), ...);
+        std::string reply = roundTrip(request.bytes);
+        wire::Reader in(reply);
+        if (in.read<std::uint64_t>() == wire::replyError)
+            throw std::runtime_error(in.read<std::string>());
+        if constexpr (!std::is_void_v<R>)
+            return in.read<R>();
+    }
+
+private:
+    int fd = -1;
+    std::mutex mutex;
+    QueueListener queueListener;
+
+    std::string roundTrip(const std::string& request);
+};
@@ -0,0 +1,105 @@
+// Enrollment service daemon. Owns a pool of database connections and serves
+// the student and faculty calls of any number of desktop clients over a
+// Unix socket; start the GUI with CMS_SERVICE=<socket> to use it.
+//
+//   cms_serviced [--socket PATH] [--connections N] [--student-rate R]
+//                [--global-rate R] [--max-queue N]
+//
+// Enrollment adds, drops and waitlist joins are admitted at most
+// --student-rate per second per student and --global-rate per second
+// overall; the rest wait in a fair queue of at most --max-queue requests.
+// Queue depth and admission wait are logged every 10 s while there is
+// traffic.
+//
+// The socket defaults to $CMS_SERVICE, else /tmp/cms_service.sock. Database
+// settings come from CMS_DB_HOST / CMS_DB_PORT / CMS_DB_USER /
+// CMS_DB_PASSWORD / CMS_DB_NAME, and reads go to the replicas in
+// CMS_DB_REPLICAS when it is set. SIGINT or SIGTERM shuts it down.
+
+#include "enrollmentservice.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+EnrollmentService* running = nullptr;
+
+void onSignal(int)
+{
+    if (running)
+        running->stop();
+}
+
+}
+
+int main(int argc, char** argv) {
+    DatabaseConfig config = DatabaseConfig::fromEnvironment(DatabaseConfig());
+    std::string socketPath = config.serviceSocket.empty() ? "/tmp/cms_service.sock" : config.serviceSocket;
+    unsigned connections = 8;
+    AdmissionLimits limits;
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (!std::strcmp(argv[i], "--socket")) socketPath = value();
+        else if (!std::strcmp(argv[i], "--connections")) connections = static_cast<unsigned>(std::atoi(value()));
+        else if (!std::strcmp(argv[i], "--student-rate")) limits.studentRate = std::atof(value());
+        else if (!std::strcmp(argv[i], "--global-rate")) limits.globalRate = std::atof(value());
+        else if (!std::strcmp(argv[i], "--max-queue")) limits.maxQueue = static_cast<std::size_t>(std::atoi(value()));
+        else {
+            std::cerr << "usage: cms_serviced [--socket PATH] [--connections N] [--student-rate R] "
+                         "[--global-rate R] [--max-queue N]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::unique_ptr<EnrollmentService> service;
+    try {
+        service = std::make_unique<EnrollmentService>(config, connections, limits);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    running = service.get();
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "Serving on " << socketPath << " with " << std::max(1u, connections) << " connections" << std::endl;
+    std::uint64_t lastRequests = 0;
+    auto metrics = [&lastRequests](const EnrollmentServiceStats& stats) {
+        if (stats.requests == lastRequests && !stats.admission.depth)
+            return;
+        lastRequests = stats.requests;
+        std::printf("requests %llu, coalesced %llu, errors %llu | admission queue %zu (peak %zu), "
+                    "wait p50 %.0f ms p99 %.0f ms max %.0f ms, admitted %llu, refused %llu\n",
+                    static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.coalesced),
+                    static_cast<unsigned long long>(stats.errors), stats.admission.depth, stats.admission.peakDepth,
+                    stats.admission.waitP50Ms, stats.admission.waitP99Ms, stats.admission.waitMaxMs,
+                    static_cast<unsigned long long>(stats.admission.admitted),
+                    static_cast<unsigned long long>(stats.admission.rejected));
+        std::fflush(stdout);
+    };
+    try {
+        service->run(socketPath, metrics);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    EnrollmentServiceStats stats = service->stats();
+    std::printf("%llu clients, %llu requests, %llu answered by a coalesced read, %llu errors\n",
+                static_cast<unsigned long long>(stats.clients), static_cast<unsigned long long>(stats.requests),
+                static_cast<unsigned long long>(stats.coalesced), static_cast<unsigned long long>(stats.errors));
+    std::printf("admission: %llu admitted, %llu refused, peak queue %zu, wait p99 %.0f ms\n",
+                static_cast<unsigned long long>(stats.admission.admitted),
+                static_cast<unsigned long long>(stats.admission.rejected), stats.admission.peakDepth,
+                stats.admission.waitP99Ms);
+    running = nullptr;
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "servicewire.h"
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// 64 MB; anything bigger is a corrupt length, not a real answer.
+constexpr std::uint32_t maxFrame = 64u << 20;
+
+bool sendAll(int fd, const char* data, std::size_t size)
+{
+    while (size) {
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool recvAll(int fd, char* data, std::size_t size)
+{
+    while (size) {
+        ssize_t n = ::recv(fd, data, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+}
+
+bool wire::writeFrame(int fd, const std::string& payload)
+{
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    const char header[4] = {static_cast<char>(size), static_cast<char>(size >> 8),
+                            static_cast<char>(size >> 16), static_cast<char>(size >> 24)};
+    return sendAll(fd, header, sizeof(header)) && sendAll(fd, payload.data(), payload.size());
+}
+
+bool wire::readFrame(int fd, std::string& payload)
+{
+    unsigned char header[4];
+    if (!recvAll(fd, reinterpret_cast<char*>(header), sizeof(header)))
+        return false;
+    const std::uint32_t size = header[0] | header[1] << 8 | header[2] << 16 | static_cast<std::uint32_t>(header[3]) << 24;
+    if (size > maxFrame)
+        return false;
+    payload.resize(size);
+    return recvAll(fd, &payload[0], size);
+}
+
+void wire::appendFrame(std::string& out, const std::string& payload)
+{
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    const char header[4] = {static_cast<char>(size), static_cast<char>(size >> 8),
+                            static_cast<char>(size >> 16), static_cast<char>(size >> 24)};
+    out.append(header, sizeof(header));
+    out += payload;
+}
+
+bool wire::sendPending(int fd, std::string& out)
+{
+    std::size_t sent = 0;
+    while (sent < out.size()) {
+        ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    out.erase(0, sent);
+    return true;
+}
+
+bool wire::FrameReader::receive(int fd)
+{
+    char chunk[64 * 1024];
+    ssize_t n;
+    do {
+        n = ::recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    if (n == 0)
+        return false;
+    buffer.append(chunk, static_cast<std::size_t>(n));
+    if (buffer.size() - start < 4)
+        return true;
+    const auto* header = reinterpret_cast<const unsigned char*>(buffer.data() + start);
+    const std::uint32_t size = header[0] | header[1] << 8 | header[2] << 16 | static_cast<std::uint32_t>(header[3]) << 24;
+    return size <= maxFrame;
+}
+
+bool wire::FrameReader::next(std::string& payload)
+{
+    if (buffer.size() - start < 4)
+        return false;
+    const auto* header = reinterpret_cast<const unsigned char*>(buffer.data() + start);
+    const std::uint32_t size = header[0] | header[1] << 8 | header[2] << 16 | static_cast<std::uint32_t>(header[3]) << 24;
+    if (buffer.size() - start - 4 < size)
+        return false;
+    payload.assign(buffer, start + 4, size);
+    start += 4 + size;
+    if (start == buffer.size()) {
+        buffer.clear();
+        start = 0;
+    } else if (start > buffer.size() / 2) {
+        buffer.erase(0, start);
+        start = 0;
+    }
+    return true;
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "database.h"
+
+// Message encoding between Database clients and cms_serviced. Every message
+// is a frame: a 4-byte little-endian length followed by the payload.
+//
+//   request  := method args...                 method is a TraceMethod
+//   response := 0x00 result | 0x01 message | 0x02 position depth
+//
+// 0x02 frames report a request still waiting for admission and precede the
+// final 0x00 or 0x01 frame.
+//
+// Integers are zigzag varints, doubles their 8 IEEE 754 bytes little-endian,
+// strings a varint length and the bytes, and vectors a varint count and the
+// elements. Records are their fields in
+// declaration order.
+namespace wire {
+
+constexpr std::uint64_t replyOk = 0;
+constexpr std::uint64_t replyError = 1;
+constexpr std::uint64_t replyQueued = 2;
+
+class Writer {
+public:
+    std::string bytes;
+
+    void put(std::uint64_t v) {
+        while (v >= 0x80) {
+            bytes += static_cast<char>((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        bytes += static_cast<char>(v);
+    }
+    void put(int v) { put((static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(v) >> 63)); }
+    void put(bool v) { bytes += v ? '\1' : '\0'; }
+    void put(double v) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        for (int i = 0; i < 8; ++i)
+            bytes += static_cast<char>(bits >> (8 * i));
+    }
+    void put(const std::string& v) {
+        put(static_cast<std::uint64_t>(v.size()));
+        bytes += v;
+    }
+    void put(const ResultSet& v) { put(v.toBytes()); }
+    template <typename A, typename B>
+    void put(const std::pair<A, B>& v) {
+        put(v.first);
+        put(v.second);
+    }
+    template <typename T>
+    void put(const std::vector<T>& v) {
+        put(static_cast<std::uint64_t>(v.size()));
+        for (const auto& e : v) put(e);
+    }
+
+    void put(const ChangeVersions& v) {
+        for (std::uint64_t n : v.version) put(n);
+    }
+    void put(const ScheduledCourse& v) {
+        put(v.schedule_id); put(v.course_code); put(v.course_name); put(v.department);
+        put(v.semester); put(v.faculty_id); put(v.timeslot_id);
+        put(v.faculty_name); put(v.day); put(v.start_time); put(v.end_time);
+        put(v.room_id); put(v.room_number); put(v.building);
+    }
+    void put(const Database::StudentInfo& v) {
+        put(v.student_id); put(v.first_name); put(v.last_name); put(v.email); put(v.semester); put(v.degree);
+    }
+    void put(const Database::Mark& v) {
+        put(v.assignment_name); put(v.total_marks); put(v.obtained_marks); put(v.course_name); put(v.course_code);
+    }
+    void put(const Database::CourseEnrollment& v) {
+        put(v.course_code); put(v.students);
+    }
+    void put(const CourseResult& v) {
+        put(v.student_id); put(v.course_code); put(v.term_id); put(v.semester); put(v.credits); put(v.percent); put(v.letter); put(v.points);
+    }
+    void put(const WaitlistEntry& v) {
+        put(v.schedule_id); put(v.course_code); put(v.course_name); put(v.position);
+    }
+    void put(const Database::StudentDashboard& v) {
+        put(v.semester); put(v.degree); put(v.enrolled); put(v.waitlists); put(v.courses); put(v.marks); put(v.versions);
+    }
+    void put(const Database::FacultyDashboard& v) {
+        put(v.timetable); put(v.courses); put(v.enrollment); put(v.versions);
+    }
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : in(bytes) {}
+
+    template <typename T>
+    T read() {
+        T v{};
+        get(v);
+        return v;
+    }
+
+    void get(std::uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t ch = byte();
+            v |= static_cast<std::uint64_t>(ch & 0x7f) << shift;
+            if (!(ch & 0x80))
+                return;
+        }
+        throw std::runtime_error("Malformed service message");
+    }
+    void get(int& v) {
+        std::uint64_t z = read<std::uint64_t>();
+        v = static_cast<int>(static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1));
+    }
+    void get(bool& v) { v = byte() != 0; }
+    void get(double& v) {
+        std::uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i)
+            bits |= static_cast<std::uint64_t>(byte()) << (8 * i);
+        std::memcpy(&v, &bits, sizeof(v));
+    }
+    void get(std::string& v) {
+        std::uint64_t n = read<std::uint64_t>();
+        if (n > in.size())
+            throw std::runtime_error("Malformed service message");
+        v.assign(in.data(), n);
+        in.remove_prefix(n);
+    }
+    void get(ResultSet& v) { v = ResultSet::fromBytes(read<std::string>()); }
+    template <typename A, typename B>
+    void get(std::pair<A, B>& v) {
+        get(v.first);
+        get(v.second);
+    }
+    template <typename T>
+    void get(std::vector<T>& v) {
+        std::uint64_t n = read<std::uint64_t>();
+        if (n > in.size())
+            throw std::runtime_error("Malformed service message");
+        v.resize(n);
+        for (auto& e : v) get(e);
+    }
+
+    void get(ChangeVersions& v) {
+        for (std::uint64_t& n : v.version) get(n);
+    }
+    void get(ScheduledCourse& v) {
+        get(v.schedule_id); get(v.course_code); get(v.course_name); get(v.department);
+        get(v.semester); get(v.faculty_id); get(v.timeslot_id);
+        get(v.faculty_name); get(v.day); get(v.start_time); get(v.end_time);
+        get(v.room_id); get(v.room_number); get(v.building);
+    }
+    void get(Database::StudentInfo& v) {
+        get(v.student_id); get(v.first_name); get(v.last_name); get(v.email); get(v.semester); get(v.degree);
+    }
+    void get(Database::Mark& v) {
+        get(v.assignment_name); get(v.total_marks); get(v.obtained_marks); get(v.course_name); get(v.course_code);
+    }
+    void get(Database::CourseEnrollment& v) {
+        get(v.course_code); get(v.students);
+    }
+    void get(CourseResult& v) {
+        get(v.student_id); get(v.course_code); get(v.term_id); get(v.semester); get(v.credits); get(v.percent); get(v.letter); get(v.points);
+    }
+    void get(WaitlistEntry& v) {
+        get(v.schedule_id); get(v.course_code); get(v.course_name); get(v.position);
+    }
+    void get(Database::StudentDashboard& v) {
+        get(v.semester); get(v.degree); get(v.enrolled); get(v.waitlists); get(v.courses); get(v.marks); get(v.versions);
+    }
+    void get(Database::FacultyDashboard& v) {
+        get(v.timetable); get(v.courses); get(v.enrollment); get(v.versions);
+    }
+
+private:
+    std::string_view in;
+
+    std::uint8_t byte() {
+        if (in.empty())
+            throw std::runtime_error("Malformed service message");
+        std::uint8_t ch = static_cast<std::uint8_t>(in.front());
+        in.remove_prefix(1);
+        return ch;
+    }
+};
+
+// Blocking frame I/O on a connected socket; false on EOF or error.
+bool writeFrame(int fd, const std::string& payload);
+bool readFrame(int fd, std::string& payload);
+
+// Non-blocking side, used by cms_serviced. appendFrame() queues a framed
+// payload on out and sendPending() writes as much of out as the socket
+// takes, erasing what went; it is false only on a send error.
+void appendFrame(std::string& out, const std::string& payload);
+bool sendPending(int fd, std::string& out);
+
+// Collects frames from a non-blocking socket across partial reads.
+class FrameReader {
+public:
+    // One read of whatever fd has ready. False on EOF, error or a frame
+    // length over the limit; a read that would block is not an error.
+    bool receive(int fd);
+    // Moves the next complete frame, if any, into payload.
+    bool next(std::string& payload);
+
+private:
+    std::string buffer;
+    std::size_t start = 0;
+};
+
+}
@@ -1,10 +1,15 @@
 #include "studentmenu.h"
+#include "timetableexport.h"
+#include "timetablerenderer.h"
+#include "imageassets.h"
+#include "grading.h"
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QGridLayout>
 #include <QLabel>
 #include <QInputDialog>
 #include <QMessageBox>
+#include <QApplication>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QPainter>
@@ -13,36 +18,26 @@
 #include <QRandomGenerator>
 #include <QFontMetrics>
 #include <QTimer>
+#include <QDialog>
+#include <QScrollArea>
+#include <QEventLoop>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QThreadPool>
 #include <fstream>
 
-StudentMenu::StudentMenu(Database *db, QString studentId, QString studentName, QString studentEmail, QWidget *parent)
+StudentMenu::StudentMenu(Database *db, QWidget *parent)
     : QWidget(parent),
-    db(db),
-    studentId(std::move(studentId)),
-    studentName(std::move(studentName)),
-    studentEmail(std::move(studentEmail))
+    db(db)
 {
     setWindowTitle("Student Menu");
     setMinimumSize(1000, 700);
 
-    backgroundImage.load("/Users/sufianzahid/Desktop/Qt/OOP/student.jpeg");
-
-    if (backgroundImage.isNull()) {
-        backgroundImage = QPixmap(size());
-        backgroundImage.fill(QColor(20, 25, 45));
-    }
+    background = new ScaledBackground(this, AssetPath::studentBackground, Qt::KeepAspectRatioByExpanding);
 
     titleLabel = new QLabel("STUDENT MENU", this);
     titleLabel->setAlignment(Qt::AlignCenter);
-    titleLabel->setStyleSheet(R"(
-        QLabel {
-            font-family: 'Georgia';
-            font-size: 50px;
-            font-weight: bold;
-            color: white;
-            background: transparent;
-        }
-    )");
+    titleLabel->setObjectName("studentTitle");
 
     addCourseBtn = new QPushButton("Add Course");
     dropCourseBtn = new QPushButton("Drop Course");
@@ -52,28 +47,18 @@ StudentMenu::StudentMenu(Database *db, QString studentId, QString studentName, Q
     exportTimetableBtn = new QPushButton("Export Timetable");
     changePasswordBtn = new QPushButton("Change Password");
     viewMarksBtn = new QPushButton("View Marks");
+    viewTranscriptBtn = new QPushButton("Transcript");
     logoutBtn = new QPushButton("Logout");
 
     QList<QPushButton*> buttons = {
         addCourseBtn, dropCourseBtn, viewTimetableBtn, viewTeachersBtn,
-        viewClassroomDetailsBtn, exportTimetableBtn, changePasswordBtn, viewMarksBtn, logoutBtn
+        viewClassroomDetailsBtn, exportTimetableBtn, changePasswordBtn, viewMarksBtn, viewTranscriptBtn, logoutBtn
     };
 
     for (QPushButton* btn : buttons) {
         btn->setMinimumSize(150, 150);
         btn->setMaximumSize(150, 150);
-        btn->setStyleSheet(R"(
-            QPushButton {
-                border-radius: 75px;
-                background-color: rgba(32, 71, 245, 200);
-                color: white;
-                font-size: 15px;
-                font-family: 'Arial Black', 'Arial', sans-serif;
-            }
-            QPushButton:hover {
-                background-color: rgba(0, 46, 207, 200);
-            }
-        )");
+        btn->setProperty("menuStyle", "round");
     }
 
     QGridLayout* grid = new QGridLayout();
@@ -87,8 +72,9 @@ StudentMenu::StudentMenu(Database *db, QString studentId, QString studentName, Q
     grid->addWidget(viewClassroomDetailsBtn,  1, 1, Qt::AlignCenter);
     grid->addWidget(exportTimetableBtn,       1, 3, Qt::AlignCenter);
     grid->addWidget(changePasswordBtn,        1, 5, Qt::AlignCenter);
-    grid->addWidget(viewMarksBtn,             2, 2, Qt::AlignCenter);
-    grid->addWidget(logoutBtn,                2, 4, Qt::AlignCenter);
+    grid->addWidget(viewMarksBtn,             2, 1, Qt::AlignCenter);
+    grid->addWidget(viewTranscriptBtn,        2, 3, Qt::AlignCenter);
+    grid->addWidget(logoutBtn,                2, 5, Qt::AlignCenter);
 
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
     mainLayout->setContentsMargins(20, 20, 20, 20);
@@ -106,19 +92,57 @@ StudentMenu::StudentMenu(Database *db, QString studentId, QString studentName, Q
     connect(exportTimetableBtn, &QPushButton::clicked, this, &StudentMenu::exportTimetable);
     connect(changePasswordBtn, &QPushButton::clicked, this, &StudentMenu::changePassword);
     connect(viewMarksBtn, &QPushButton::clicked, this, &StudentMenu::viewMarks);
+    connect(viewTranscriptBtn, &QPushButton::clicked, this, &StudentMenu::viewTranscript);
     connect(logoutBtn, &QPushButton::clicked, this, &StudentMenu::logout);
+
+    changePoll.setInterval(changePollMs);
+    connect(&changePoll, &QTimer::timeout, this, &StudentMenu::pollChanges);
+    changePoll.start();
 }
 
-void StudentMenu::resizeEvent(QResizeEvent *event)
+void StudentMenu::bindSession(QString studentId, QString studentName, QString studentEmail)
+{
+    this->studentId = std::move(studentId);
+    this->studentName = std::move(studentName);
+    this->studentEmail = std::move(studentEmail);
+    dashboard.reset();
+}
+
+const Database::StudentDashboard &StudentMenu::snapshot()
 {
-    if (!backgroundImage.isNull()) {
-        QPixmap scaled = backgroundImage.scaled(
-            event->size(),
-            Qt::KeepAspectRatioByExpanding,
-            Qt::SmoothTransformation
-            );
-        backgroundImage = scaled;
+    if (!dashboard)
+        dashboard = db->loadStudentDashboard(studentId.toStdString());
+    return *dashboard;
+}
+
+// Keeps the snapshot current while the window is open. Views copy what
+// they still need after showing a dialog, so this may run under one.
+// Tells the student when one of their waitlist places became a seat.
+void StudentMenu::pollChanges()
+{
+    if (!dashboard || enrolling || !isVisible())
+        return;
+    std::vector<WaitlistEntry> waiting = dashboard->waitlists;
+    try {
+        if (!db->refreshStudentDashboard(studentId.toStdString(), *dashboard))
+            return;
     }
+    catch (const std::exception &) {
+        // Try again on the next tick.
+        return;
+    }
+    QStringList promoted;
+    for (const auto &w : waiting)
+        for (const auto &sc : dashboard->enrolled)
+            if (sc.schedule_id == w.schedule_id)
+                promoted << QString::fromStdString(w.course_code + " - " + w.course_name);
+    if (!promoted.isEmpty())
+        QMessageBox::information(this, "Waitlist", "A seat freed up and you are now enrolled in:\n" + promoted.join("\n"));
+}
+
+void StudentMenu::resizeEvent(QResizeEvent *event)
+{
+    background->resized(event->size());
     QWidget::resizeEvent(event);
 }
 
@@ -126,10 +150,11 @@ void StudentMenu::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
 
-    if (!backgroundImage.isNull()) {
-        int x = (width() - backgroundImage.width()) / 2;
-        int y = (height() - backgroundImage.height()) / 2;
-        painter.drawPixmap(x, y, backgroundImage);
+    if (!background->isNull()) {
+        const QPixmap &bg = background->pixmap();
+        int x = (width() - bg.width()) / 2;
+        int y = (height() - bg.height()) / 2;
+        painter.drawPixmap(x, y, bg);
     }
     else {
         painter.fillRect(rect(), QColor(20, 25, 45));
@@ -139,9 +164,9 @@ void StudentMenu::paintEvent(QPaintEvent *event)
 }
 
 void StudentMenu::addCourse() {
-    int semester = db->getStudentSemester(studentId.toStdString());
-    std::string degree = db->getStudentDegree(studentId.toStdString());
-    auto courses = db->getAvailableScheduledCourses(semester, degree);
+    const auto &dash = snapshot();
+    auto courses = db->getAvailableScheduledCourses(dash.semester, dash.degree);
+    auto waitlists = dash.waitlists;
 
     if (courses.empty()) {
         QMessageBox::information(this, "Add Course", "No scheduled courses for your degree/semester.");
@@ -175,61 +200,153 @@ void StudentMenu::addCourse() {
         QMessageBox::information(this, "Add Course", "Already enrolled in this course.");
         return;
     }
+    for (const auto &w : waitlists) {
+        if (w.schedule_id == sc.schedule_id) {
+            QMessageBox::information(this, "Add Course", QString("You are number %1 on the waitlist for this course.").arg(w.position));
+            return;
+        }
+    }
     if (db->hasClash(studentId.toStdString(), sc.timeslot_id)) {
         QMessageBox::information(this, "Add Course", "Course timeslot clashes with your existing courses.");
         return;
     }
-    if (db->addEnrollment(studentId.toStdString(), sc.schedule_id))
+    const std::string id = studentId.toStdString();
+    const int scheduleId = sc.schedule_id;
+    auto enrolled = runEnrollment("Add Course", [this, id, scheduleId]() { return db->addEnrollment(id, scheduleId); });
+    if (!enrolled)
+        return;
+    if (*enrolled) {
+        dashboard.reset();
         QMessageBox::information(this, "Add Course", "Enrolled successfully.");
+        return;
+    }
+    if (QMessageBox::question(this, "Add Course",
+                              "This course is full.\nJoin the waitlist? You will be enrolled automatically when a seat frees up.")
+        != QMessageBox::Yes)
+        return;
+    int position = -1;
+    auto joined = runEnrollment("Join Waitlist", [this, id, scheduleId, &position]() {
+        position = db->joinWaitlist(id, scheduleId);
+        return position >= 0;
+    });
+    if (!joined)
+        return;
+    dashboard.reset();
+    if (position > 0)
+        QMessageBox::information(this, "Join Waitlist", QString("You are number %1 on the waitlist.").arg(position));
+    else if (position == 0)
+        QMessageBox::information(this, "Join Waitlist", "A seat freed up; you are now enrolled.");
     else
-        QMessageBox::warning(this, "Add Course", "Course full or error occurred.");
+        QMessageBox::warning(this, "Join Waitlist", "This course is no longer offered.");
 }
 
+std::optional<bool> StudentMenu::runEnrollment(const QString &title, const std::function<bool()> &call)
+{
+    if (!db->usesService()) {
+        try {
+            return call();
+        } catch (const std::exception &e) {
+            QMessageBox::warning(this, title, QString::fromStdString(e.what()));
+            return std::nullopt;
+        }
+    }
+
+    QProgressDialog progress("Submitting...", QString(), 0, 0, this);
+    progress.setWindowTitle(title);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(300);
+    QPointer<QProgressDialog> dialog(&progress);
+    db->setQueueListener([dialog](std::size_t position, std::size_t depth) {
+        QMetaObject::invokeMethod(qApp, [dialog, position, depth]() {
+            if (dialog)
+                dialog->setLabelText(QString("Registration is busy.\nYour place in the queue: %1 of %2").arg(position).arg(depth));
+        }, Qt::QueuedConnection);
+    });
+
+    bool result = false;
+    QString error;
+    QEventLoop loop;
+    enrolling = true;
+    QThreadPool::globalInstance()->start([&]() {
+        try {
+            result = call();
+        } catch (const std::exception &e) {
+            error = QString::fromStdString(e.what());
+        }
+        QMetaObject::invokeMethod(&loop, "quit", Qt::QueuedConnection);
+    });
+    loop.exec();
+    enrolling = false;
+    db->setQueueListener(nullptr);
+    progress.reset();
+
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, title, error);
+        return std::nullopt;
+    }
+    return result;
+}
+
+// Waitlist places are listed after the enrolled courses; picking one leaves
+// that waitlist.
 void StudentMenu::dropCourse() {
-    auto enrolled = db->getEnrolledCourses(studentId.toStdString());
-    if (enrolled.empty()) {
+    auto enrolled = snapshot().enrolled;
+    auto waitlists = snapshot().waitlists;
+    if (enrolled.empty() && waitlists.empty()) {
         QMessageBox::information(this, "Drop Course", "No enrolled courses.");
         return;
     }
     QStringList items;
     for (const auto& sc : enrolled)
         items << QString::fromStdString(sc.course_code + " - " + sc.course_name + " | " + sc.faculty_name);
+    for (const auto& w : waitlists)
+        items << QString("%1 - %2 | waitlist, number %3")
+                     .arg(QString::fromStdString(w.course_code))
+                     .arg(QString::fromStdString(w.course_name))
+                     .arg(w.position);
 
     bool ok;
     QString selected = QInputDialog::getItem(this, "Drop Course", "Select a course to drop:", items, 0, false, &ok);
     if (!ok || selected.isEmpty()) return;
 
     int idx = items.indexOf(selected);
+    const std::string id = studentId.toStdString();
+    if (idx >= static_cast<int>(enrolled.size())) {
+        const int scheduleId = waitlists[idx - enrolled.size()].schedule_id;
+        auto left = runEnrollment("Leave Waitlist", [this, id, scheduleId]() { return db->leaveWaitlist(id, scheduleId); });
+        if (!left)
+            return;
+        dashboard.reset();
+        if (*left)
+            QMessageBox::information(this, "Leave Waitlist", "Removed from the waitlist.");
+        else
+            QMessageBox::warning(this, "Leave Waitlist", "You are no longer on this waitlist.");
+        return;
+    }
     const auto& sc = enrolled[idx];
-    if (db->dropEnrollment(studentId.toStdString(), sc.schedule_id))
+    const int scheduleId = sc.schedule_id;
+    auto dropped = runEnrollment("Drop Course", [this, id, scheduleId]() { return db->dropEnrollment(id, scheduleId); });
+    if (!dropped)
+        return;
+    if (*dropped) {
+        dashboard.reset();
         QMessageBox::information(this, "Drop Course", "Dropped successfully.");
-    else
+    } else {
         QMessageBox::warning(this, "Drop Course", "Error or not enrolled.");
+    }
 }
 
 void StudentMenu::viewTimetable() {
-    auto tt = db->getEnrolledCourses(studentId.toStdString());
+    const auto &tt = snapshot().enrolled;
     if (tt.empty()) {
         QMessageBox::information(this, "Timetable", "No enrolled courses.");
         return;
     }
-    QString table = "Course | Name | Day | Start-End | Room | Bldg | Teacher\n"; 
-    for (const auto& t : tt) {
-        table += QString("%1 | %2 | %3 | %4-%5 | %6 %7 | %8\n")
-        .arg(QString::fromStdString(t.course_code))
-            .arg(QString::fromStdString(t.course_name))
-            .arg(QString::fromStdString(t.day))
-            .arg(QString::fromStdString(t.start_time))
-            .arg(QString::fromStdString(t.end_time))
-            .arg(QString::fromStdString(t.room_number))
-            .arg(QString::fromStdString(t.building))
-            .arg(QString::fromStdString(t.faculty_name));
-    }
-    QMessageBox::information(this, "Timetable", table);
+    showTimetableDialog(this, "Timetable - " + studentId, tt, true);
 }
 
 void StudentMenu::viewTeachers() {
-    auto tt = db->getEnrolledCourses(studentId.toStdString());
+    const auto &tt = snapshot().enrolled;
     if (tt.empty()) {
         QMessageBox::information(this, "Teachers", "No enrolled courses.");
         return;
@@ -243,7 +360,7 @@ void StudentMenu::viewTeachers() {
 }
 
 void StudentMenu::viewClassroomDetails() {
-    auto tt = db->getEnrolledCourses(studentId.toStdString());
+    const auto &tt = snapshot().enrolled;
     if (tt.empty()) {
         QMessageBox::information(this, "Classrooms", "No enrolled courses.");
         return;
@@ -257,7 +374,7 @@ void StudentMenu::viewClassroomDetails() {
 }
 
 void StudentMenu::exportTimetable() {
-    auto tt = db->getEnrolledCourses(studentId.toStdString());
+    auto tt = snapshot().enrolled;
     if (tt.empty()) {
         QMessageBox::information(this, "Export Timetable", "No enrolled courses.");
         return;
@@ -265,11 +382,7 @@ void StudentMenu::exportTimetable() {
     QString filename = QFileDialog::getSaveFileName(this, "Export Timetable", studentId + "_timetable.csv", "CSV files (*.csv)");
     if (filename.isEmpty()) return;
     std::ofstream out(filename.toStdString());
-    out << "Course,Name,Day,Start,End,Room,Bldg,Teacher\n";
-    for (const auto& t : tt) {
-        out << t.course_code << "," << t.course_name << "," << t.day << "," << t.start_time << ","
-            << t.end_time << "," << t.room_number << "," << t.building << "," << t.faculty_name << "\n";
-    }
+    TimetableExporter::writeCsv(out, tt, true);
     out.close();
     QMessageBox::information(this, "Export Timetable", "Timetable exported to " + filename);
 }
@@ -303,18 +416,20 @@ void StudentMenu::changePassword() {
 }
 
 void StudentMenu::viewMarks() {
-    auto courses = db->getStudentCourses(studentId.toStdString());
-    if (courses.empty()) {
+    const auto dash = snapshot();
+    if (dash.courses.empty()) {
         QMessageBox::information(this, "Marks", "You are not enrolled in any courses.");
         return;
     }
     bool ok;
     QStringList items;
-    for (const auto& c : courses) items << QString::fromStdString(c);
+    for (const auto& c : dash.courses) items << QString::fromStdString(c.first + " - " + c.second);
     QString selected = QInputDialog::getItem(this, "Marks", "Select course to view marks:", items, 0, false, &ok);
     if (!ok || selected.isEmpty()) return;
-    std::string course_code = selected.toStdString().substr(0, selected.indexOf(" - "));
-    auto marks = db->getStudentMarks(studentId.toStdString(), course_code);
+    const std::string &course_code = dash.courses[items.indexOf(selected)].first;
+    std::vector<Database::Mark> marks;
+    for (const auto& mark : dash.marks)
+        if (mark.course_code == course_code) marks.push_back(mark);
     if (marks.empty()) {
         QMessageBox::information(this, "Marks", "No marks available for the selected course.");
         return;
@@ -348,6 +463,53 @@ void StudentMenu::viewMarks() {
     layout.addWidget(&okBtn);
     dlg.exec();
 }
+// Shows the grades last published by cms_cli results, not a live
+// computation, so every student sees results graded under the same policy.
+void StudentMenu::viewTranscript()
+{
+    Transcript transcript = Transcript::of(db->getCourseResults(studentId.toStdString()));
+    if (transcript.courses.empty()) {
+        QMessageBox::information(this, "Transcript", "No results have been published for you yet.");
+        return;
+    }
+
+    QString html;
+    std::size_t next = 0;
+    for (const auto &term : transcript.semesters) {
+        html += QString("<h3>Semester %1</h3><table border='1' cellspacing='0' cellpadding='3'>"
+                        "<tr><th>Course</th><th>Credits</th><th>Percentage</th><th>Grade</th><th>Points</th></tr>")
+                    .arg(term.semester);
+        for (; next < transcript.courses.size() && transcript.courses[next].semester == term.semester; ++next) {
+            const auto &c = transcript.courses[next];
+            html += QString("<tr><td>%1</td><td>%2</td><td>%3%</td><td>%4</td><td>%5</td></tr>")
+                        .arg(QString::fromStdString(c.course_code))
+                        .arg(c.credits)
+                        .arg(QString::number(c.percent, 'f', 2))
+                        .arg(QString::fromStdString(c.letter))
+                        .arg(QString::number(c.points, 'f', 2));
+        }
+        html += QString("</table><p>Semester GPA: <b>%1</b> (%2 credits)</p>")
+                    .arg(QString::number(term.gpa, 'f', 2))
+                    .arg(term.credits);
+    }
+    html += QString("<h3>CGPA: %1 (%2 credits)</h3>").arg(QString::number(transcript.cgpa, 'f', 2)).arg(transcript.credits);
+
+    QDialog dlg(this);
+    dlg.setWindowTitle("Transcript");
+    QVBoxLayout layout(&dlg);
+    QScrollArea scroll;
+    QLabel label;
+    label.setTextFormat(Qt::RichText);
+    label.setText(html);
+    scroll.setWidget(&label);
+    scroll.setMinimumSize(700, 500);
+    layout.addWidget(&scroll);
+    QPushButton okBtn("OK");
+    QObject::connect(&okBtn, &QPushButton::clicked, &dlg, &QDialog::accept);
+    layout.addWidget(&okBtn);
+    dlg.exec();
+}
+
 void StudentMenu::logout()
 {
     QMessageBox::information(this, "Logout", "You have been logged out.");
@@ -4,17 +4,22 @@
 #include <QFont>
 #include <QTimer>
 #include <QPixmap>
+#include <functional>
+#include <optional>
 #include "database.h"
 
 class QLabel;
 class QPushButton;
+class ScaledBackground;
 
 class StudentMenu : public QWidget
 {
     Q_OBJECT
 
 public:
-    StudentMenu(Database *db, QString studentId, QString studentName, QString studentEmail, QWidget *parent = nullptr);
+    explicit StudentMenu(Database *db, QWidget *parent = nullptr);
+
+    void bindSession(QString studentId, QString studentName, QString studentEmail);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -25,7 +30,24 @@ private:
     QString studentId;
     QString studentName;
     QString studentEmail;
-    QPixmap backgroundImage;
+    ScaledBackground *background;
+
+    // Loaded on first use and shared by every view. Reloaded after this
+    // student's own add/drop and on login; changePoll refreshes the slices
+    // other clients change in the meantime.
+    std::optional<Database::StudentDashboard> dashboard;
+    const Database::StudentDashboard &snapshot();
+
+    static constexpr int changePollMs = 5000;
+    QTimer changePoll;
+
+    // Through the enrollment service, runs an add or drop off the GUI thread
+    // behind a progress dialog that shows the admission queue position. On a
+    // direct connection the call runs inline, since the MySQL session is not
+    // shared across threads and nothing queues. Returns the call's result, or
+    // nothing after reporting an error.
+    std::optional<bool> runEnrollment(const QString &title, const std::function<bool()> &call);
+    bool enrolling = false;
 
     QLabel *titleLabel;
     QPushButton *addCourseBtn;
@@ -36,9 +58,11 @@ private:
     QPushButton *exportTimetableBtn;
     QPushButton *changePasswordBtn;
     QPushButton *viewMarksBtn;
+    QPushButton *viewTranscriptBtn;
     QPushButton *logoutBtn;
 
 private slots:
+    void pollChanges();
     void addCourse();
     void dropCourse();
     void viewTimetable();
@@ -47,5 +71,6 @@ private slots:
     void exportTimetable();
     void changePassword();
     void viewMarks();
+    void viewTranscript();
     void logout();
 };
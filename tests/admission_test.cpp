@@ -0,0 +1,120 @@
+#include "check.h"
+#include "admission.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = TokenBucket::Clock;
+using std::chrono::milliseconds;
+
+void tokenBucket()
+{
+    const Clock::time_point t0{};
+    TokenBucket bucket(2.0, 3.0, t0);           // 2 per second, burst 3
+    CHECK(bucket.full(t0));
+    CHECK(bucket.take(t0));
+    CHECK(bucket.take(t0));
+    CHECK(bucket.take(t0));
+    CHECK(!bucket.take(t0));
+    CHECK(!bucket.full(t0));
+    CHECK(bucket.untilNext(t0) == std::chrono::duration_cast<Clock::duration>(milliseconds(500)));
+
+    TokenBucket early = bucket;
+    CHECK(!early.take(t0 + milliseconds(499)));
+    CHECK(bucket.take(t0 + milliseconds(500)));
+    CHECK(bucket.untilNext(t0 + milliseconds(750)) == std::chrono::duration_cast<Clock::duration>(milliseconds(250)));
+
+    // Refills stop at the burst.
+    CHECK(bucket.full(t0 + std::chrono::seconds(60)));
+    CHECK(bucket.take(t0 + std::chrono::seconds(60)));
+    CHECK(bucket.take(t0 + std::chrono::seconds(60)));
+    CHECK(bucket.take(t0 + std::chrono::seconds(60)));
+    CHECK(!bucket.take(t0 + std::chrono::seconds(60)));
+}
+
+// Collects job names in the order the dispatcher runs them.
+struct Log {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::string> ran;
+    bool released = false;
+
+    AdmissionControl::Job job(const std::string& name) {
+        return [this, name] {
+            std::lock_guard<std::mutex> lock(mutex);
+            ran.push_back(name);
+            changed.notify_all();
+        };
+    }
+    bool waitFor(std::size_t n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(5), [&] { return ran.size() >= n; });
+    }
+};
+
+void roundRobin()
+{
+    AdmissionLimits limits;
+    limits.studentRate = 0.001;                 // effectively no refill during the test
+    limits.studentBurst = 2;
+    limits.globalRate = 1000;
+    limits.globalBurst = 100;
+    AdmissionControl admission(limits);
+    Log log;
+
+    // Hold the dispatcher inside a job while the rest queue up, so the
+    // release order does not depend on timing.
+    std::mutex gate;
+    std::unique_lock<std::mutex> hold(gate);
+    CHECK(admission.enqueue("z", [&] { std::lock_guard<std::mutex> wait(gate); }, {}));
+    CHECK(admission.enqueue("a", log.job("a1"), {}));
+    CHECK(admission.enqueue("a", log.job("a2"), {}));
+    CHECK(admission.enqueue("a", log.job("a3"), {}));
+    CHECK(admission.enqueue("b", log.job("b1"), {}));
+    hold.unlock();
+
+    // a's burst of two lets a1 and a2 through, b1 goes between them, and a3
+    // waits for a token that does not come.
+    CHECK(log.waitFor(3));
+    std::this_thread::sleep_for(milliseconds(50));
+    std::lock_guard<std::mutex> lock(log.mutex);
+    CHECK((log.ran == std::vector<std::string>{"a1", "b1", "a2"}));
+    AdmissionStats stats = admission.stats();
+    CHECK(stats.admitted == 4);
+    CHECK(stats.depth == 1);
+    CHECK(stats.peakDepth >= 4);
+}
+
+void boundedQueue()
+{
+    AdmissionLimits limits;
+    limits.studentRate = 0.001;
+    limits.studentBurst = 0;                    // nothing is ever released
+    limits.maxQueue = 2;
+    std::atomic<std::size_t> lastPosition{0};
+    AdmissionControl admission(limits);
+    CHECK(admission.enqueue("a", [] {}, {}));
+    CHECK(admission.enqueue("b", [] {}, [&](std::size_t position, std::size_t) { lastPosition = position; }));
+    CHECK(lastPosition == 2);
+    CHECK(!admission.enqueue("c", [] {}, {}));
+    AdmissionStats stats = admission.stats();
+    CHECK(stats.depth == 2);
+    CHECK(stats.rejected == 1);
+    CHECK(stats.admitted == 0);
+}
+
+}
+
+int main()
+{
+    tokenBucket();
+    roundRobin();
+    boundedQueue();
+    return testResult();
+}
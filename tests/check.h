@@ -0,0 +1,38 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+
+// Minimal assertions for the unit tests. A failing CHECK prints the
+// expression and keeps going; main() returns testResult().
+inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline int testResult()
+{
+    if (testFailures())
+        std::cerr << testFailures() << " check(s) failed" << std::endl;
+    return testFailures() ? 1 : 0;
+}
+
+#define CHECK(expr)                                                                     \
+    do {                                                                                \
+        if (!(expr)) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed\n";  \
+            ++testFailures();                                                           \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps) CHECK(std::fabs((a) - (b)) <= (eps))
+
+#define CHECK_THROWS(expr)                                                              \
+    do {                                                                                \
+        bool thrown = false;                                                            \
+        try { expr; } catch (const std::exception&) { thrown = true; }                 \
+        if (!thrown) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #expr " did not throw\n";  \
+            ++testFailures();                                                           \
+        }                                                                               \
+    } while (0)
@@ -0,0 +1,139 @@
+#include "check.h"
+#include "grading.h"
+#include "parallel.h"
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+GradingPolicy parse(const std::string& text)
+{
+    std::istringstream in(text);
+    return GradingPolicy::parse(in);
+}
+
+MarkRecord mark(const std::string& assignment, int total, int obtained)
+{
+    return {"CS101", "S1", assignment, total, obtained, "CS", 3, 1, 1};
+}
+
+void emptyPolicyIsStandard()
+{
+    GradingPolicy policy = parse("# nothing but a comment\n\n");
+    CHECK(policy.weights.empty());
+    CHECK(policy.bands.size() == GradingPolicy::standard().bands.size());
+    CHECK(policy.band(85).letter == "A");
+    CHECK(policy.band(84.9).letter == "A-");
+    CHECK(policy.band(49.9).letter == "F");
+}
+
+void weightsAndGrades()
+{
+    GradingPolicy policy = parse("weight quiz 20   # quizzes\n"
+                                 "weight mid 30\n"
+                                 "weight * 50\n"
+                                 "grade P 50 1\n"
+                                 "grade H 80 4\n"
+                                 "grade F 0 0\n");
+    CHECK(policy.weights.size() == 3);
+    CHECK(policy.weights[0].first == "quiz");
+    CHECK_NEAR(policy.weights[2].second, 50.0, 1e-9);
+    // Grade lines replace the scale and are kept by descending minimum.
+    CHECK(policy.bands.size() == 3);
+    CHECK(policy.bands[0].letter == "H");
+    CHECK(policy.bands[2].letter == "F");
+    CHECK(policy.band(79.9).letter == "P");
+}
+
+void malformedLines()
+{
+    CHECK_THROWS(parse("weight quiz\n"));
+    CHECK_THROWS(parse("weight quiz -5\n"));
+    CHECK_THROWS(parse("weight quiz 10 extra\n"));
+    CHECK_THROWS(parse("grade A 85\n"));
+    CHECK_THROWS(parse("bonus 5\n"));
+    try {
+        parse("weight quiz 10\nweight mid x\n");
+        CHECK(false);
+    } catch (const std::runtime_error& e) {
+        CHECK(std::string(e.what()).find("line 2") != std::string::npos);
+    }
+}
+
+void coursePercent()
+{
+    GradingPolicy policy = parse("weight Quiz 25\nweight * 75\n");
+    // Quizzes 15/20 = 75% at weight 25, the rest 45/50 = 90% at weight 75;
+    // categories match case-insensitively by prefix.
+    std::vector<MarkRecord> marks = {mark("quiz 1", 10, 7), mark("QUIZ 2", 10, 8), mark("Final", 50, 45)};
+    CHECK_NEAR(policy.coursePercent(marks), 86.25, 1e-9);
+
+    // A category without marks drops out of the mean.
+    std::vector<MarkRecord> quizzesOnly = {mark("Quiz 1", 10, 7)};
+    CHECK_NEAR(policy.coursePercent(quizzesOnly), 70.0, 1e-9);
+
+    // Without weights every mark counts by its total.
+    CHECK_NEAR(GradingPolicy::standard().coursePercent(marks), 100.0 * 60 / 70, 1e-9);
+
+    CourseResult result = policy.grade(marks);
+    CHECK(result.student_id == "S1");
+    CHECK(result.letter == "A");
+    CHECK_NEAR(result.points, 4.0, 1e-9);
+}
+
+CourseResult result(const std::string& course, int term, int semester, int credits, double points)
+{
+    CourseResult r;
+    r.student_id = "S1";
+    r.course_code = course;
+    r.term_id = term;
+    r.semester = semester;
+    r.credits = credits;
+    r.points = points;
+    return r;
+}
+
+void transcriptRetakes()
+{
+    // CS101 failed in term 1 and retaken in term 3.
+    Transcript t = Transcript::of({result("CS101", 3, 1, 3, 3.0), result("MA101", 1, 1, 3, 4.0),
+                                   result("CS101", 1, 1, 3, 0.0), result("CS201", 3, 2, 4, 2.0)});
+    CHECK(t.courses.size() == 4);
+    CHECK(t.credits == 10);
+    CHECK_NEAR(t.cgpa, (3.0 * 3 + 4.0 * 3 + 2.0 * 4) / 10, 1e-9);
+    CHECK(t.semesters.size() == 2);
+    CHECK(t.semesters[0].credits == 6);
+    CHECK_NEAR(t.semesters[0].gpa, 3.5, 1e-9);
+}
+
+void parallelForRethrows()
+{
+    std::atomic<int> calls{0};
+    try {
+        parallelFor(1000000, 4, [&](std::size_t i) {
+            ++calls;
+            if (i == 3)
+                throw std::runtime_error("item 3");
+        });
+        CHECK(false);
+    } catch (const std::runtime_error& e) {
+        CHECK(std::string(e.what()) == "item 3");
+    }
+    // Indices stop being handed out once one has thrown.
+    CHECK(calls < 1000000);
+}
+
+}
+
+int main()
+{
+    emptyPolicyIsStandard();
+    weightsAndGrades();
+    malformedLines();
+    coursePercent();
+    transcriptRetakes();
+    parallelForRethrows();
+    return testResult();
+}
@@ -0,0 +1,73 @@
+#include "check.h"
+#include "markstats.h"
+#include <vector>
+
+namespace {
+
+void emptySample()
+{
+    MarkStats stats = MarkStats::of(std::vector<double>());
+    CHECK(stats.count == 0);
+    CHECK(stats.mean == 0.0);
+    CHECK(stats.histogram[0] == 0);
+}
+
+void summary()
+{
+    // 10, 20, ..., 100: odd length tails exercise the scalar remainder loops.
+    std::vector<double> v;
+    for (int i = 1; i <= 10; ++i)
+        v.push_back(10.0 * i);
+    MarkStats stats = MarkStats::of(v);
+    CHECK(stats.count == 10);
+    CHECK_NEAR(stats.mean, 55.0, 1e-9);
+    CHECK_NEAR(stats.stddev, 28.722813232690143, 1e-9);
+    CHECK_NEAR(stats.min, 10.0, 1e-9);
+    CHECK_NEAR(stats.max, 100.0, 1e-9);
+    CHECK_NEAR(stats.median, 55.0, 1e-9);
+    CHECK_NEAR(stats.p10, 19.0, 1e-9);
+    CHECK_NEAR(stats.p25, 32.5, 1e-9);
+    CHECK_NEAR(stats.p75, 77.5, 1e-9);
+    CHECK_NEAR(stats.p90, 91.0, 1e-9);
+    // 10..90 land one per bin from 1 up; 100 shares the last bin with 90.
+    CHECK(stats.histogram[0] == 0);
+    for (std::size_t bin = 1; bin < 9; ++bin)
+        CHECK(stats.histogram[bin] == 1);
+    CHECK(stats.histogram[9] == 2);
+}
+
+void fromMarks()
+{
+    const int obtained[] = {5, 0, 7, 3, 20};
+    const int total[] = {10, 0, 7, 4, 20};
+    MarkStats stats = MarkStats::of(obtained, total, 5);
+    CHECK(stats.count == 5);
+    CHECK_NEAR(stats.min, 0.0, 1e-9);            // zero total counts as 0%
+    CHECK_NEAR(stats.max, 100.0, 1e-9);
+    CHECK_NEAR(stats.mean, (50.0 + 0.0 + 100.0 + 75.0 + 100.0) / 5, 1e-9);
+    CHECK(stats.histogram[0] == 1);
+    CHECK(stats.histogram[5] == 1);
+    CHECK(stats.histogram[7] == 1);
+    CHECK(stats.histogram[9] == 2);
+}
+
+void columns()
+{
+    MarksColumns marks;
+    CHECK(!marks.has("CS101"));
+    // set() mirrors writes into courses that have been loaded; an unloaded
+    // course stays unknown.
+    marks.set("CS101", "S1", "Quiz 1", 10, 8);
+    CHECK(!marks.has("CS101"));
+}
+
+}
+
+int main()
+{
+    emptySample();
+    summary();
+    fromMarks();
+    columns();
+    return testResult();
+}
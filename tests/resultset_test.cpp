@@ -0,0 +1,95 @@
+#include "check.h"
+#include "resultset.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Builds the toBytes() image field by field.
+struct Image {
+    std::string bytes;
+
+    template <typename T>
+    Image& raw(T value) {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        return *this;
+    }
+    Image& header(std::uint64_t columns, std::uint64_t rows, std::uint64_t arena) {
+        return raw(columns).raw(rows).raw(arena);
+    }
+    Image& cell(std::int64_t number, std::uint32_t offset, std::uint32_t length, bool null) {
+        raw(number).raw(offset).raw(length);
+        bytes += null ? '\1' : '\0';
+        return *this;
+    }
+    Image& arena(const std::string& text) {
+        bytes += text;
+        return *this;
+    }
+};
+
+// Two rows of (name, credits, prerequisite).
+std::string twoCourses()
+{
+    return Image()
+        .header(3, 2, 9)
+        .cell(0, 0, 5, false).cell(3, 0, 0, false).cell(0, 0, 0, true)
+        .cell(0, 5, 4, false).cell(4, 0, 0, false).cell(0, 0, 5, false)
+        .arena("CS101MT20")
+        .bytes;
+}
+
+void roundTrip()
+{
+    const std::string image = twoCourses();
+    ResultSet rs = ResultSet::fromBytes(image);
+    CHECK(rs.size() == 2 && rs.columnCount() == 3);
+    CHECK(rs[0].text(0) == "CS101");
+    CHECK(rs[0].integer(1) == 3);
+    CHECK(rs[0].isNull(2) && !rs[0].isNull(1));
+    CHECK(rs[1][0] == "MT20");
+    CHECK(rs[1].text(2) == "CS101");            // cells may share arena bytes
+    std::size_t rows = 0;
+    for (auto row : rs) {
+        CHECK(row.size() == 3);
+        ++rows;
+    }
+    CHECK(rows == 2);
+    CHECK(rs.toBytes() == image);
+
+    ResultSet none;
+    CHECK(ResultSet::fromBytes(none.toBytes()).empty());
+    // Columns without rows still describe the result.
+    ResultSet noRows = ResultSet::fromBytes(Image().header(4, 0, 0).bytes);
+    CHECK(noRows.empty() && noRows.columnCount() == 4);
+}
+
+void rejected()
+{
+    const std::string image = twoCourses();
+    for (std::size_t cut = 0; cut < image.size(); ++cut)
+        CHECK(ResultSet::fromBytes(std::string_view(image).substr(0, cut)).empty());
+
+    // A cell reaching past the arena.
+    std::string outside = image;
+    const std::uint32_t offset = 6;             // 6 + 4 > 9 for the second row's name
+    std::memcpy(&outside[24 + 3 * 17 + 8], &offset, sizeof(offset));
+    CHECK(ResultSet::fromBytes(outside).empty());
+
+    // Counts whose product overflows, and counts the image cannot hold.
+    CHECK(ResultSet::fromBytes(Image().header(~0ull, 2, 0).arena(std::string(64, '\0')).bytes).empty());
+    CHECK(ResultSet::fromBytes(Image().header(1ull << 32, 1ull << 32, 0).arena(std::string(64, '\0')).bytes).empty());
+    CHECK(ResultSet::fromBytes(Image().header(1, 1000, 0).cell(0, 0, 0, true).bytes).empty());
+    // Rows without columns would index cells that do not exist.
+    CHECK(ResultSet::fromBytes(Image().header(0, 5, 0).bytes).empty());
+}
+
+}
+
+int main()
+{
+    roundTrip();
+    rejected();
+    return testResult();
+}
@@ -0,0 +1,99 @@
+#include "check.h"
+#include "searchindex.h"
+#include <cstdio>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// SearchIndex holds a Database but load(), find(), lookup() and the mirror
+// calls never use it. A service-mode Database only needs a socket that
+// accepts the connection, so point one at a listener nobody serves.
+struct IdleService {
+    std::string path = "/tmp/cms_searchindex_test." + std::to_string(::getpid());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    IdleService() {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        ::unlink(path.c_str());
+        ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        ::listen(fd, 1);
+    }
+    ~IdleService() {
+        ::close(fd);
+        ::unlink(path.c_str());
+    }
+};
+
+bool has(const std::vector<SearchHit>& hits, const std::string& key)
+{
+    for (const auto& hit : hits)
+        if (hit.key == key)
+            return true;
+    return false;
+}
+
+}
+
+int main()
+{
+    IdleService service;
+    DatabaseConfig config;
+    config.serviceSocket = service.path;
+    Database db(config);
+
+    SearchIndex index(db);
+    index.load({{"BSCS-21-001", "Ayesha", "Khan", "ayesha.khan@uni.edu", 3, "BSCS"},
+                {"BSCS-21-002", "Bilal", "Ahmed", "bilal.ahmed@uni.edu", 3, "BSCS"},
+                {"BSSE-22-010", "Sara", "Ali", "sara.ali@uni.edu", 1, "BSSE"}},
+               {{7, "Usman", "Tariq", "usman.tariq@uni.edu"}},
+               {{"CS101", "Programming Fundamentals"}, {"MT201", "Linear Algebra"}});
+    CHECK(index.size() == 6);
+
+    // Ids are indexed with their separators dropped.
+    auto hits = index.find("bscs21", 10);
+    CHECK(hits.size() == 2);
+    CHECK(has(hits, "BSCS-21-001") && has(hits, "BSCS-21-002"));
+
+    // Every query word has to start a word of the entry.
+    hits = index.find("ay kh", 10);
+    CHECK(hits.size() == 1 && hits[0].key == "BSCS-21-001");
+    CHECK(index.find("ayesha ahmed", 10).empty());
+
+    // A misspelt word stands for the indexed words it is closest to.
+    hits = index.find("progrmming", 10);
+    CHECK(hits.size() == 1 && hits[0].key == "CS101");
+
+    // Kind filter, accept filter and limit.
+    hits = index.find("", 10, SearchKind::Course);
+    CHECK(hits.size() == 2 && hits[0].kind == SearchKind::Course);
+    hits = index.find("", 10, {}, [](const SearchHit& hit) { return hit.kind == SearchKind::Faculty; });
+    CHECK(hits.size() == 1 && hits[0].key == "usman.tariq@uni.edu");
+    CHECK(index.find("", 2).size() == 2);
+    CHECK(index.find("ali", 0).empty());
+
+    auto exact = index.lookup(SearchKind::Student, "BSSE-22-010");
+    CHECK(exact && exact->label.find("Sara Ali") != std::string::npos);
+    CHECK(!index.lookup(SearchKind::Course, "BSSE-22-010"));
+
+    // Mirrored writes.
+    index.addCourse("CS102", "Object Oriented Programming");
+    CHECK(has(index.find("object", 10), "CS102"));
+    index.remove(SearchKind::Student, "BSCS-21-002");
+    CHECK(!index.lookup(SearchKind::Student, "BSCS-21-002"));
+    CHECK(index.find("bilal", 10).empty());
+    CHECK(index.size() == 6);
+
+    // Re-adding a key replaces its entry and its words.
+    index.addCourse("CS102", "Advanced Programming");
+    CHECK(index.size() == 6);
+    CHECK(index.find("object", 10).empty());
+    hits = index.find("advanced", 10);
+    CHECK(hits.size() == 1 && hits[0].label == "CS102 - Advanced Programming");
+
+    return testResult();
+}
@@ -0,0 +1,133 @@
+#include "check.h"
+#include "servicewire.h"
+#include <climits>
+#include <cstdint>
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void scalars()
+{
+    wire::Writer out;
+    out.put(std::uint64_t(0));
+    out.put(std::uint64_t(300));
+    out.put(~std::uint64_t(0));
+    out.put(-1);
+    out.put(INT_MIN);
+    out.put(INT_MAX);
+    out.put(true);
+    out.put(-2.5);
+    out.put(std::string());
+    out.put(std::string("x\0y", 3));
+
+    wire::Reader in(out.bytes);
+    CHECK(in.read<std::uint64_t>() == 0);
+    CHECK(in.read<std::uint64_t>() == 300);
+    CHECK(in.read<std::uint64_t>() == ~std::uint64_t(0));
+    CHECK(in.read<int>() == -1);
+    CHECK(in.read<int>() == INT_MIN);
+    CHECK(in.read<int>() == INT_MAX);
+    CHECK(in.read<bool>());
+    CHECK(in.read<double>() == -2.5);
+    CHECK(in.read<std::string>().empty());
+    CHECK(in.read<std::string>() == std::string("x\0y", 3));
+    CHECK_THROWS(in.read<int>());
+}
+
+void encodings()
+{
+    // Varints are 7 bits a byte, low first; ints are zigzagged.
+    wire::Writer out;
+    out.put(std::uint64_t(300));
+    CHECK(out.bytes == "\xac\x02");
+    out.bytes.clear();
+    out.put(-1);
+    CHECK(out.bytes == "\x01");
+    out.bytes.clear();
+    out.put(1);
+    CHECK(out.bytes == "\x02");
+}
+
+void records()
+{
+    CourseResult result;
+    result.student_id = "S1";
+    result.course_code = "CS101";
+    result.term_id = 4;
+    result.semester = 2;
+    result.credits = 3;
+    result.percent = 86.25;
+    result.letter = "A";
+    result.points = 4.0;
+    std::vector<std::pair<std::string, std::pair<int, int>>> marks = {{"S1", {10, 7}}, {"S2", {10, -1}}};
+
+    wire::Writer out;
+    out.put(std::vector<CourseResult>{result});
+    out.put(marks);
+    wire::Reader in(out.bytes);
+    auto results = in.read<std::vector<CourseResult>>();
+    CHECK(results.size() == 1);
+    CHECK(results[0].student_id == "S1" && results[0].course_code == "CS101");
+    CHECK(results[0].term_id == 4 && results[0].semester == 2 && results[0].credits == 3);
+    CHECK(results[0].percent == 86.25 && results[0].letter == "A" && results[0].points == 4.0);
+    CHECK((in.read<std::vector<std::pair<std::string, std::pair<int, int>>>>() == marks));
+
+    // A vector count past the end of the message is malformed.
+    std::string truncated = out.bytes.substr(0, out.bytes.size() - 1);
+    wire::Reader cut(truncated);
+    cut.read<std::vector<CourseResult>>();
+    CHECK_THROWS((cut.read<std::vector<std::pair<std::string, std::pair<int, int>>>>()));
+}
+
+void frames()
+{
+    int sv[2];
+    CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    ::fcntl(sv[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(sv[1], F_SETFL, O_NONBLOCK);
+
+    // Bigger than the socket buffer, so both sides see partial transfers.
+    const std::string big(3 << 20, 'x');
+    std::string pending;
+    wire::appendFrame(pending, "hello");
+    wire::appendFrame(pending, big);
+    wire::appendFrame(pending, "");
+    wire::FrameReader reader;
+    std::vector<std::string> got;
+    std::string payload;
+    for (int rounds = 0; got.size() < 3 && rounds < 100000; ++rounds) {
+        CHECK(wire::sendPending(sv[0], pending));
+        CHECK(reader.receive(sv[1]));
+        while (reader.next(payload))
+            got.push_back(payload);
+    }
+    CHECK(got.size() == 3 && got[0] == "hello" && got[1] == big && got[2].empty());
+    CHECK(pending.empty());
+    CHECK(reader.receive(sv[1]));               // nothing ready is not an error
+
+    // A length over the limit ends the connection.
+    std::string oversized("\xff\xff\xff\xff", 4);
+    CHECK(wire::sendPending(sv[0], oversized));
+    CHECK(!reader.receive(sv[1]));
+
+    ::close(sv[0]);
+    wire::FrameReader after;
+    CHECK(!after.receive(sv[1]));
+    ::close(sv[1]);
+}
+
+}
+
+int main()
+{
+    scalars();
+    encodings();
+    records();
+    frames();
+    return testResult();
+}
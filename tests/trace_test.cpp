@@ -0,0 +1,83 @@
+#include "check.h"
+#include "trace.h"
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+const std::string path = "/tmp/cms_trace_test." + std::to_string(::getpid());
+
+void roundTrip()
+{
+    CHECK(TraceWriter::start(path));
+    const std::string longText(300, 'q');      // length needs a two-byte varint
+    {
+        TraceScope outer(TraceMethod::AddMarks, std::string("CS101"), std::string(), longText, INT_MIN, INT_MAX);
+        // Nested calls fold into the outer one.
+        TraceScope inner(TraceMethod::StudentExists, std::string("S1"));
+    }
+    {
+        TraceScope scope(TraceMethod::GetStudentTermMarks, std::string("S1"), -1);
+    }
+    TraceWriter::stop();
+
+    TraceReader reader(path);
+    CHECK(reader.ok());
+    TraceRecord record;
+    CHECK(reader.next(record));
+    CHECK(record.method == TraceMethod::AddMarks);
+    CHECK(record.args.size() == 5);
+    if (record.args.size() == 5) {
+        CHECK(record.args[0].isText && record.args[0].text == "CS101");
+        CHECK(record.args[1].isText && record.args[1].text.empty());
+        CHECK(record.args[2].isText && record.args[2].text == longText);
+        CHECK(!record.args[3].isText && record.args[3].number == INT_MIN);
+        CHECK(!record.args[4].isText && record.args[4].number == INT_MAX);
+    }
+    CHECK(reader.next(record));
+    CHECK(record.method == TraceMethod::GetStudentTermMarks);
+    CHECK(record.args.size() == 2 && record.args[1].number == -1);
+    CHECK(!reader.next(record));
+}
+
+void badFiles()
+{
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "NOTATRACE";
+    }
+    CHECK(!TraceReader(path).ok());
+
+    // Traces from before the method numbering changed are refused.
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write("CMSTRC1\0", 8);
+    }
+    CHECK(!TraceReader(path).ok());
+
+    // A record cut short ends the trace instead of yielding garbage.
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write("CMSTRC2\0", 8);
+        out.write("\x05\x00\x01\x01\x01\x01\x90", 7);  // string arg whose length varint never ends
+    }
+    TraceReader reader(path);
+    CHECK(reader.ok());
+    TraceRecord record;
+    CHECK(!reader.next(record));
+    CHECK(std::string(traceMethodName(TraceMethod::Count)) == "unknown");
+    CHECK(std::string(traceMethodName(TraceMethod::GetStudentFootprint)) == "getStudentFootprint");
+}
+
+}
+
+int main()
+{
+    roundTrip();
+    badFiles();
+    std::remove(path.c_str());
+    return testResult();
+}
@@ -0,0 +1,319 @@
+#include "timetableexport.h"
+#include "filenames.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using PersonTimetable = std::pair<std::string, std::vector<ScheduledCourse>>;
+
+struct ExportJob {
+    fs::path path;
+    const PersonTimetable* person;
+    bool withTeacher;
+};
+
+// Appends row to key's timetable; rows need not arrive grouped.
+std::vector<ScheduledCourse>& timetableOf(std::vector<PersonTimetable>& people,
+                                          std::unordered_map<std::string, std::size_t>& index, const std::string& key)
+{
+    auto it = index.find(key);
+    if (it == index.end()) {
+        it = index.emplace(key, people.size()).first;
+        people.emplace_back(key, std::vector<ScheduledCourse>());
+    }
+    return people[it->second].second;
+}
+
+// Distinct IDs can map to the same file name ("a/b" and "a_b"); the later
+// ones get _2, _3, ... instead of overwriting the first.
+fs::path uniquePath(std::unordered_set<std::string>& taken, const fs::path& dir, const std::string& stem,
+                    const std::string& ext)
+{
+    std::string name = stem + ext;
+    for (int n = 2; !taken.insert((dir / name).string()).second; ++n)
+        name = stem + "_" + std::to_string(n) + ext;
+    return dir / name;
+}
+
+std::string csvField(const std::string& value)
+{
+    if (value.find_first_of(",\"\n") == std::string::npos)
+        return value;
+    std::string quoted = "\"";
+    for (char ch : value) {
+        if (ch == '"') quoted += '"';
+        quoted += ch;
+    }
+    return quoted + "\"";
+}
+
+std::string jsonString(const std::string& value)
+{
+    std::string out = "\"";
+    for (char ch : value) {
+        switch (ch) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(ch)));
+                out += buf;
+            } else {
+                out += ch;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+std::string icsText(const std::string& value)
+{
+    std::string out;
+    for (char ch : value) {
+        if (ch == ',' || ch == ';' || ch == '\\') out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date, and back.
+long daysFromCivil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long>(doe) - 719468;
+}
+
+std::string civilFromDays(long z)
+{
+    z += 719468;
+    const long era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const long y = static_cast<long>(yoe) + era * 400 + (m <= 2);
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%04ld%02u%02u", y, m, d);
+    return buf;
+}
+
+// 0 for Monday to 6 for Sunday; -1 for anything else.
+int dayOffset(const std::string& day)
+{
+    static const char* days[] = {"Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday"};
+    for (int i = 0; i < 7; ++i)
+        if (day == days[i]) return i;
+    return -1;
+}
+
+// A YYYY-MM-DD calendar date as days since 1970-01-01.
+std::optional<long> parseDate(const std::string& date)
+{
+    int y = 0, m = 0, d = 0;
+    char end = 0;
+    if (std::sscanf(date.c_str(), "%4d-%2d-%2d%c", &y, &m, &d, &end) != 3 || m < 1 || m > 12 || d < 1 || d > 31)
+        return std::nullopt;
+    const long day = daysFromCivil(y, static_cast<unsigned>(m), static_cast<unsigned>(d));
+    char canonical[48];
+    std::snprintf(canonical, sizeof(canonical), "%04d%02d%02d", y, m, d);
+    if (civilFromDays(day) != canonical)
+        return std::nullopt;   // e.g. 2025-02-30
+    return day;
+}
+
+const char* rruleDay(int offset)
+{
+    static const char* codes[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+    return codes[offset];
+}
+
+std::string icsTime(const std::string& hhmmss)
+{
+    std::string out;
+    for (char ch : hhmmss)
+        if (ch != ':') out += ch;
+    while (out.size() < 6) out += '0';
+    return out.substr(0, 6);
+}
+
+}
+
+bool TimetableExporter::validTermStart(const std::string& date)
+{
+    auto day = parseDate(date);
+    return day && (*day + 3) % 7 == 0;     // 1970-01-01 was a Thursday
+}
+
+const char* TimetableExporter::extension(TimetableFormat format)
+{
+    switch (format) {
+    case TimetableFormat::Csv: return ".csv";
+    case TimetableFormat::ICalendar: return ".ics";
+    case TimetableFormat::Json: return ".json";
+    }
+    return ".csv";
+}
+
+void TimetableExporter::writeCsv(std::ostream& out, const std::vector<ScheduledCourse>& courses, bool withTeacher)
+{
+    out << (withTeacher ? "Course,Name,Day,Start,End,Room,Bldg,Teacher\n" : "Course,Name,Day,Start,End,Room,Bldg\n");
+    for (const auto& t : courses) {
+        out << csvField(t.course_code) << "," << csvField(t.course_name) << "," << t.day << "," << t.start_time << ","
+            << t.end_time << "," << csvField(t.room_number) << "," << csvField(t.building);
+        if (withTeacher)
+            out << "," << csvField(t.faculty_name);
+        out << "\n";
+    }
+}
+
+void TimetableExporter::writeICalendar(std::ostream& out, const std::vector<ScheduledCourse>& courses,
+                                       const std::string& owner, const std::string& termStart, int termWeeks)
+{
+    if (!validTermStart(termStart))
+        throw std::invalid_argument("Term start " + termStart + " is not a Monday in YYYY-MM-DD form");
+    const long monday = *parseDate(termStart);
+    for (const auto& t : courses)
+        if (dayOffset(t.day) < 0)
+            throw std::invalid_argument("Section " + std::to_string(t.schedule_id) + " has unknown day " + t.day);
+
+    out << "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//SCIT CMS//Timetable//EN\r\n";
+    for (const auto& t : courses) {
+        const int offset = dayOffset(t.day);
+        const std::string date = civilFromDays(monday + offset);
+        out << "BEGIN:VEVENT\r\n"
+            << "UID:" << t.schedule_id << "-" << safeFileName(owner) << "@scit-cms\r\n"
+            << "DTSTAMP:" << civilFromDays(monday) << "T000000\r\n"
+            << "DTSTART:" << date << "T" << icsTime(t.start_time) << "\r\n"
+            << "DTEND:" << date << "T" << icsTime(t.end_time) << "\r\n"
+            << "RRULE:FREQ=WEEKLY;COUNT=" << termWeeks << ";BYDAY=" << rruleDay(offset) << "\r\n"
+            << "SUMMARY:" << icsText(t.course_code + " - " + t.course_name) << "\r\n"
+            << "LOCATION:" << icsText("Room " + t.room_number + ", " + t.building) << "\r\n"
+            << "DESCRIPTION:" << icsText(t.faculty_name) << "\r\n"
+            << "END:VEVENT\r\n";
+    }
+    out << "END:VCALENDAR\r\n";
+}
+
+void TimetableExporter::writeJson(std::ostream& out, const std::vector<ScheduledCourse>& courses, const std::string& owner)
+{
+    out << "{\"owner\":" << jsonString(owner) << ",\"courses\":[";
+    for (std::size_t i = 0; i < courses.size(); ++i) {
+        const auto& t = courses[i];
+        if (i) out << ",";
+        out << "{\"schedule_id\":" << t.schedule_id
+            << ",\"course_code\":" << jsonString(t.course_code)
+            << ",\"course_name\":" << jsonString(t.course_name)
+            << ",\"faculty\":" << jsonString(t.faculty_name)
+            << ",\"day\":" << jsonString(t.day)
+            << ",\"start\":" << jsonString(t.start_time)
+            << ",\"end\":" << jsonString(t.end_time)
+            << ",\"room\":" << jsonString(t.room_number)
+            << ",\"building\":" << jsonString(t.building) << "}";
+    }
+    out << "]}\n";
+}
+
+TimetableExportSummary TimetableExporter::exportAll(const TimetableExportOptions& options)
+{
+    if (options.format == TimetableFormat::ICalendar && !validTermStart(options.termStart))
+        throw std::invalid_argument("Term start " + options.termStart + " is not a Monday in YYYY-MM-DD form");
+    TimetableExportSummary summary;
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<PersonTimetable> students;
+    std::vector<PersonTimetable> faculty;
+    std::unordered_map<std::string, std::size_t> index;
+    if (options.students) {
+        db.streamEnrolledTimetables([&](EnrolledTimetableRow& row) {
+            timetableOf(students, index, row.student_id).push_back(std::move(static_cast<ScheduledCourse&>(row)));
+            ++summary.rows;
+        });
+    }
+    index.clear();
+    if (options.faculty) {
+        db.streamScheduledCourses([&](ScheduledCourse& row) {
+            timetableOf(faculty, index, std::to_string(row.faculty_id)).push_back(std::move(row));
+            ++summary.rows;
+        });
+    }
+
+    const std::string ext = extension(options.format);
+    std::vector<ExportJob> jobs;
+    jobs.reserve(students.size() + faculty.size());
+    fs::path root(options.directory);
+    std::error_code ec;
+    std::unordered_set<std::string> taken;
+    if (!students.empty())
+        fs::create_directories(root / "students", ec);
+    for (const auto& p : students)
+        jobs.push_back({uniquePath(taken, root / "students", safeFileName(p.first) + "_timetable", ext), &p, true});
+    if (!faculty.empty())
+        fs::create_directories(root / "faculty", ec);
+    for (const auto& p : faculty)
+        jobs.push_back({uniquePath(taken, root / "faculty", "faculty_" + safeFileName(p.first) + "_timetable", ext), &p, false});
+
+    std::atomic<std::size_t> written{0};
+    std::mutex errorMutex;
+    parallelFor(jobs.size(), options.threads, [&](std::size_t i) {
+        const ExportJob& job = jobs[i];
+        std::ofstream out(job.path, std::ios::binary);
+        if (!out) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            summary.errors.push_back("Cannot write " + job.path.string());
+            return;
+        }
+        try {
+            switch (options.format) {
+            case TimetableFormat::Csv:
+                writeCsv(out, job.person->second, job.withTeacher);
+                break;
+            case TimetableFormat::ICalendar:
+                writeICalendar(out, job.person->second, job.person->first, options.termStart, options.termWeeks);
+                break;
+            case TimetableFormat::Json:
+                writeJson(out, job.person->second, job.person->first);
+                break;
+            }
+            out.flush();
+            if (!out)
+                throw std::runtime_error("write failed");
+        }
+        catch (const std::exception& e) {
+            out.close();
+            std::error_code ignored;
+            fs::remove(job.path, ignored);
+            std::lock_guard<std::mutex> lock(errorMutex);
+            summary.errors.push_back(job.path.string() + ": " + e.what());
+            return;
+        }
+        ++written;
+    });
+
+    summary.files = written;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "database.h"
+
+enum class TimetableFormat { Csv, ICalendar, Json };
+
+struct TimetableExportOptions {
+    std::string directory;
+    TimetableFormat format = TimetableFormat::Csv;
+    std::string termStart = "2025-09-01";   // Monday of week one, used by .ics
+    int termWeeks = 16;
+    unsigned threads = 0;                   // 0 = hardware concurrency
+    bool students = true;
+    bool faculty = true;
+};
+
+struct TimetableExportSummary {
+    std::size_t files = 0;
+    std::size_t rows = 0;
+    double seconds = 0.0;
+    std::vector<std::string> errors;
+};
+
+// Writes one timetable file per student and per faculty member. Rows come from
+// one streaming query per population, are grouped by person in memory and the
+// files are written by a pool of worker threads.
+class TimetableExporter {
+    Database& db;
+
+public:
+    explicit TimetableExporter(Database& db) : db(db) {}
+
+    // Throws std::invalid_argument up front when .ics output has a bad
+    // termStart; a file that cannot be written is reported in errors.
+    TimetableExportSummary exportAll(const TimetableExportOptions& options);
+
+    static const char* extension(TimetableFormat format);
+    // True for a Monday written as YYYY-MM-DD.
+    static bool validTermStart(const std::string& date);
+    static void writeCsv(std::ostream& out, const std::vector<ScheduledCourse>& courses, bool withTeacher);
+    // Throws std::invalid_argument for a bad termStart or a section on an
+    // unknown day.
+    static void writeICalendar(std::ostream& out, const std::vector<ScheduledCourse>& courses,
+                               const std::string& owner, const std::string& termStart, int termWeeks);
+    static void writeJson(std::ostream& out, const std::vector<ScheduledCourse>& courses, const std::string& owner);
+};
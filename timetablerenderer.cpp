@@ -0,0 +1,266 @@
+#include "timetablerenderer.h"
+#include "filenames.h"
+#include "parallel.h"
+#include <QColor>
+#include <QDialog>
+#include <QDir>
+#include <QFont>
+#include <QHash>
+#include <QLabel>
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPixmap>
+#include <QPushButton>
+#include <QScrollArea>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+const char* dayNames[] = {"Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+constexpr int dayCount = 6;
+
+int dayIndex(const std::string& day)
+{
+    for (int i = 0; i < dayCount; ++i)
+        if (day == dayNames[i]) return i;
+    return -1;
+}
+
+int minutesOf(const std::string& hhmmss)
+{
+    int h = 0, m = 0;
+    std::sscanf(hhmmss.c_str(), "%d:%d", &h, &m);
+    return h * 60 + m;
+}
+
+QColor courseColor(const std::string& code)
+{
+    uint hash = qHash(QString::fromStdString(code));
+    return QColor::fromHsv(static_cast<int>(hash % 360), 110, 235);
+}
+
+QFont pixelFont(const char* family, int px, bool bold)
+{
+    QFont font(family);
+    font.setPixelSize(px);
+    font.setBold(bold);
+    return font;
+}
+
+}
+
+TimetableRenderer::TimetableRenderer(QSize pageSize)
+    : layout(layoutFor(pageSize))
+{
+}
+
+std::shared_ptr<const TimetableRenderer::Layout> TimetableRenderer::layoutFor(QSize size)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, std::shared_ptr<const Layout>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_pair(size.width(), size.height());
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    auto l = std::make_shared<Layout>();
+    const double margin = size.width() * 0.02;
+    const double titleHeight = size.height() * 0.08;
+    const double headerHeight = size.height() * 0.05;
+    const double timeWidth = size.width() * 0.07;
+
+    l->size = size;
+    l->titleRect = QRectF(margin, margin, size.width() - 2 * margin, titleHeight);
+    double top = margin + titleHeight + headerHeight;
+    double bottom = size.height() - margin;
+    l->timeColumn = QRectF(margin, top, timeWidth, bottom - top);
+    l->grid = QRectF(margin + timeWidth, top, size.width() - 2 * margin - timeWidth, bottom - top);
+    l->dayWidth = l->grid.width() / dayCount;
+    l->minuteHeight = l->grid.height() / ((lastHour - firstHour) * 60.0);
+    for (int d = 0; d < dayCount; ++d)
+        l->dayHeaders.emplace_back(l->grid.left() + d * l->dayWidth, top - headerHeight, l->dayWidth, headerHeight);
+
+    cache.emplace(key, l);
+    return l;
+}
+
+void TimetableRenderer::paint(QPainter& painter, const QString& title, const std::vector<ScheduledCourse>& courses, bool showTeacher) const
+{
+    const Layout& l = *layout;
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.fillRect(QRect(QPoint(0, 0), l.size), Qt::white);
+
+    painter.setPen(QColor(32, 71, 245));
+    painter.setFont(pixelFont("Georgia", static_cast<int>(l.titleRect.height() * 0.5), true));
+    painter.drawText(l.titleRect, Qt::AlignCenter, title);
+
+    painter.setFont(pixelFont("Arial", static_cast<int>(l.dayHeaders.front().height() * 0.45), true));
+    for (int d = 0; d < dayCount; ++d) {
+        painter.fillRect(l.dayHeaders[d], QColor(32, 71, 245));
+        painter.setPen(Qt::white);
+        painter.drawText(l.dayHeaders[d], Qt::AlignCenter, dayNames[d]);
+    }
+
+    painter.setFont(pixelFont("Arial", static_cast<int>(60 * l.minuteHeight * 0.25), false));
+    for (int h = firstHour; h <= lastHour; ++h) {
+        double y = l.grid.top() + (h - firstHour) * 60 * l.minuteHeight;
+        painter.setPen(QColor(210, 214, 230));
+        painter.drawLine(QPointF(l.grid.left(), y), QPointF(l.grid.right(), y));
+        if (h < lastHour) {
+            painter.setPen(QColor(60, 60, 80));
+            painter.drawText(QRectF(l.timeColumn.left(), y, l.timeColumn.width() - 6, 60 * l.minuteHeight),
+                             Qt::AlignRight | Qt::AlignTop, QString("%1:00").arg(h, 2, 10, QChar('0')));
+        }
+    }
+    painter.setPen(QColor(210, 214, 230));
+    for (int d = 0; d <= dayCount; ++d) {
+        double x = l.grid.left() + d * l.dayWidth;
+        painter.drawLine(QPointF(x, l.grid.top()), QPointF(x, l.grid.bottom()));
+    }
+
+    const QFont codeFont = pixelFont("Arial", std::max(9, static_cast<int>(l.dayWidth * 0.065)), true);
+    const QFont detailFont = pixelFont("Arial", std::max(8, static_cast<int>(l.dayWidth * 0.055)), false);
+    for (const auto& c : courses) {
+        int d = dayIndex(c.day);
+        if (d < 0) continue;
+        int start = std::max(minutesOf(c.start_time), firstHour * 60);
+        int end = std::min(minutesOf(c.end_time), lastHour * 60);
+        if (end <= start) continue;
+
+        QRectF block(l.grid.left() + d * l.dayWidth + 3,
+                     l.grid.top() + (start - firstHour * 60) * l.minuteHeight + 2,
+                     l.dayWidth - 6,
+                     (end - start) * l.minuteHeight - 4);
+        QColor color = courseColor(c.course_code);
+        painter.setPen(color.darker(140));
+        painter.setBrush(color);
+        painter.drawRoundedRect(block, 6, 6);
+
+        QRectF text = block.adjusted(6, 4, -6, -4);
+        painter.setPen(QColor(20, 25, 45));
+        painter.setFont(codeFont);
+        painter.drawText(text, Qt::AlignLeft | Qt::AlignTop, QString::fromStdString(c.course_code));
+        QString details = QString::fromStdString(c.course_name) + "\n"
+                          + QString::fromStdString(c.start_time.substr(0, 5) + "-" + c.end_time.substr(0, 5)) + "  "
+                          + QString::fromStdString("Room " + c.room_number + " " + c.building);
+        if (showTeacher)
+            details += "\n" + QString::fromStdString(c.faculty_name);
+        painter.setFont(detailFont);
+        painter.drawText(text.adjusted(0, codeFont.pixelSize() + 4, 0, 0),
+                         Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap, details);
+    }
+}
+
+QImage TimetableRenderer::renderImage(const QString& title, const std::vector<ScheduledCourse>& courses, bool showTeacher) const
+{
+    QImage image(layout->size, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    paint(painter, title, courses, showTeacher);
+    return image;
+}
+
+bool TimetableRenderer::renderPdf(const QString& path, const QString& title, const std::vector<ScheduledCourse>& courses, bool showTeacher) const
+{
+    QPdfWriter pdf(path);
+    pdf.setPageSize(QPageSize(QPageSize::A4));
+    pdf.setPageOrientation(QPageLayout::Landscape);
+    pdf.setTitle(title);
+    QPainter painter;
+    if (!painter.begin(&pdf))
+        return false;
+    painter.scale(pdf.width() / double(layout->size.width()), pdf.height() / double(layout->size.height()));
+    paint(painter, title, courses, showTeacher);
+    return painter.end();
+}
+
+TimetableRenderSummary TimetableRenderer::renderAll(Database& db, const std::string& directory,
+                                                    TimetableImageFormat format, unsigned threads)
+{
+    TimetableRenderSummary summary;
+    auto started = std::chrono::steady_clock::now();
+
+    struct Job {
+        QString path;
+        QString title;
+        std::vector<ScheduledCourse> courses;
+        bool showTeacher;
+    };
+    std::vector<Job> jobs;
+    std::map<std::string, std::vector<ScheduledCourse>> rooms;
+
+    std::string currentStudent;
+    db.streamEnrolledTimetables([&](EnrolledTimetableRow& row) {
+        if (jobs.empty() || currentStudent != row.student_id) {
+            currentStudent = row.student_id;
+            jobs.push_back({QString(), QString::fromStdString(row.student_id), {}, true});
+        }
+        jobs.back().courses.push_back(std::move(static_cast<ScheduledCourse&>(row)));
+    });
+    db.streamScheduledCourses([&](ScheduledCourse& row) {
+        rooms[row.room_id].push_back(std::move(row));
+    });
+
+    const char* ext = format == TimetableImageFormat::Pdf ? ".pdf" : ".png";
+    QDir root(QString::fromStdString(directory));
+    root.mkpath("students");
+    root.mkpath("rooms");
+    for (auto& job : jobs)
+        job.path = root.filePath("students/" + QString::fromStdString(safeFileName(job.title.toStdString())) + ext);
+    for (auto& room : rooms) {
+        const auto& first = room.second.front();
+        QString title = QString::fromStdString("Room " + first.room_number + " " + first.building);
+        jobs.push_back({root.filePath("rooms/" + QString::fromStdString(safeFileName(room.first)) + ext),
+                        title, std::move(room.second), true});
+    }
+
+    TimetableRenderer renderer;
+    std::atomic<std::size_t> written{0};
+    std::mutex errorMutex;
+    parallelFor(jobs.size(), threads, [&](std::size_t i) {
+        const Job& job = jobs[i];
+        bool ok = format == TimetableImageFormat::Pdf
+                      ? renderer.renderPdf(job.path, job.title, job.courses, job.showTeacher)
+                      : renderer.renderImage(job.title, job.courses, job.showTeacher).save(job.path, "PNG");
+        if (ok) {
+            ++written;
+        } else {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            summary.errors.push_back("Cannot write " + job.path.toStdString());
+        }
+    });
+
+    summary.files = written;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return summary;
+}
+
+void showTimetableDialog(QWidget* parent, const QString& title,
+                         const std::vector<ScheduledCourse>& courses, bool showTeacher)
+{
+    QImage image = TimetableRenderer(QSize(1400, 900)).renderImage(title, courses, showTeacher);
+
+    QDialog dlg(parent);
+    dlg.setWindowTitle("Timetable");
+    QVBoxLayout layout(&dlg);
+    QScrollArea scroll;
+    QLabel label;
+    label.setPixmap(QPixmap::fromImage(image));
+    scroll.setWidget(&label);
+    scroll.setMinimumSize(1000, 650);
+    layout.addWidget(&scroll);
+    QPushButton okBtn("OK");
+    QObject::connect(&okBtn, &QPushButton::clicked, &dlg, &QDialog::accept);
+    layout.addWidget(&okBtn);
+    dlg.exec();
+}
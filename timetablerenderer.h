@@ -0,0 +1,61 @@
+#pragma once
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <memory>
+#include <string>
+#include <vector>
+#include "database.h"
+
+class QPainter;
+class QWidget;
+
+enum class TimetableImageFormat { Png, Pdf };
+
+struct TimetableRenderSummary {
+    std::size_t files = 0;
+    double seconds = 0.0;
+    std::vector<std::string> errors;
+};
+
+// Paints a weekly grid (Monday-Saturday, 08:00-20:00) for one person or room.
+// Grid geometry depends only on the page size and is computed once per size,
+// so painting is just the course blocks. Works on QImage and QPdfWriter and
+// does not touch any widget, so it is safe to use from worker threads.
+class TimetableRenderer {
+public:
+    struct Layout {
+        QSize size;
+        QRectF titleRect;
+        QRectF timeColumn;
+        QRectF grid;
+        std::vector<QRectF> dayHeaders;
+        double dayWidth = 0;
+        double minuteHeight = 0;
+    };
+
+    static constexpr int firstHour = 8;
+    static constexpr int lastHour = 20;
+
+    explicit TimetableRenderer(QSize pageSize = QSize(1600, 1000));
+
+    void paint(QPainter& painter, const QString& title, const std::vector<ScheduledCourse>& courses, bool showTeacher) const;
+    QImage renderImage(const QString& title, const std::vector<ScheduledCourse>& courses, bool showTeacher) const;
+    bool renderPdf(const QString& path, const QString& title, const std::vector<ScheduledCourse>& courses, bool showTeacher) const;
+
+    // Renders every student's and every room's timetable into directory/students
+    // and directory/rooms using all cores.
+    static TimetableRenderSummary renderAll(Database& db, const std::string& directory,
+                                            TimetableImageFormat format, unsigned threads = 0);
+
+private:
+    std::shared_ptr<const Layout> layout;
+
+    static std::shared_ptr<const Layout> layoutFor(QSize size);
+};
+
+// Shows a rendered timetable in a modal, scrollable dialog. Unlike the
+// renderer this needs the GUI thread.
+void showTimetableDialog(QWidget* parent, const QString& title,
+                         const std::vector<ScheduledCourse>& courses, bool showTeacher);
@@ -0,0 +1,199 @@
+#include "trace.h"
+#include <cstring>
+
+namespace {
+
+const char magic[8] = {'C', 'M', 'S', 'T', 'R', 'C', '2', '\0'};
+
+void putVarint(std::string& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+bool getVarint(std::istream& in, std::uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int ch = in.get();
+        if (ch == EOF)
+            return false;
+        v |= static_cast<std::uint64_t>(ch & 0x7f) << shift;
+        if (!(ch & 0x80))
+            return true;
+    }
+    return false;
+}
+
+std::uint32_t threadIndex()
+{
+    static std::atomic<std::uint32_t> next{0};
+    thread_local std::uint32_t index = next++;
+    return index;
+}
+
+}
+
+const char* traceMethodName(TraceMethod method)
+{
+    static const char* names[] = {
+        "studentExists", "validateStudentPassword", "changeStudentPassword",
+        "resetStudentPassword", "getStudentSemester", "getStudentDegree",
+        "facultyExists", "validateFacultyPassword", "getFacultyId",
+        "getFacultyName", "changeFacultyPassword", "resetFacultyPassword",
+        "getAvailableScheduledCourses", "isAlreadyEnrolled", "hasClash",
+        "addEnrollment", "dropEnrollment", "getEnrolledCourses",
+        "addStudent", "removeStudent", "addFaculty",
+        "removeFaculty", "addCourse", "removeCourse",
+        "addClassroom", "removeClassroom", "addTimeslot",
+        "removeTimeslot", "getUnscheduledCourses", "getAllCourses",
+        "getAllFaculty", "getAllTimeslots", "getAvailableRooms",
+        "getAvailableFaculty", "addCourseSchedule", "getAllCourseSchedules",
+        "getCourseSchedulesPage", "removeCourseSchedule", "getFacultyCourses",
+        "getAllStudents", "getEnrolledStudentsInCourse", "getEnrolledStudentsPage",
+        "getFacultyTimetable",
+        "getTotalEnrolledStudents", "addMarks", "updateMarks",
+        "getAssignmentsForCourse", "getStudentMarksForAssignment", "fetchStudentMarksForAssignment",
+        "getStudentMarks", "getStudentCourses", "loadStudentDashboard",
+        "loadFacultyDashboard", "changeVersions", "joinWaitlist",
+        "leaveWaitlist", "getStudentWaitlists", "getCourseResults",
+        "currentTerm", "getTerms", "startTerm",
+        "closeTerm", "archiveTerm", "getStudentTermMarks",
+        "getScheduleRoster", "getTimeslotRosters", "getClassroomRosters",
+        "getFacultyRosters", "getCourseRosters", "getStudentFootprint",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<std::size_t>(TraceMethod::Count),
+                  "traceMethodName out of sync with TraceMethod");
+    auto i = static_cast<std::size_t>(method);
+    return i < static_cast<std::size_t>(TraceMethod::Count) ? names[i] : "unknown";
+}
+
+TraceWriter TraceWriter::instance;
+std::atomic<TraceWriter*> TraceWriter::current{nullptr};
+thread_local int TraceScope::depth = 0;
+
+bool TraceWriter::start(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    if (instance.out.is_open())
+        return true;
+    instance.out.open(path, std::ios::binary | std::ios::trunc);
+    if (!instance.out)
+        return false;
+    instance.out.write(magic, sizeof(magic));
+    instance.origin = std::chrono::steady_clock::now();
+    current = &instance;
+    return true;
+}
+
+void TraceWriter::stop()
+{
+    current = nullptr;
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    if (instance.out.is_open()) {
+        instance.flush();
+        instance.out.close();
+    }
+}
+
+TraceWriter* TraceWriter::active()
+{
+    return current.load(std::memory_order_relaxed);
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (out.is_open()) {
+        flush();
+        out.close();
+    }
+}
+
+std::uint64_t TraceWriter::nowUs() const
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count());
+}
+
+void TraceWriter::record(TraceMethod method, std::uint64_t startUs, std::uint32_t durationUs, const std::string& encodedArgs, std::uint32_t argc)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!out.is_open())
+        return;
+    putVarint(buffer, static_cast<std::uint64_t>(method));
+    putVarint(buffer, threadIndex());
+    putVarint(buffer, startUs);
+    putVarint(buffer, durationUs);
+    putVarint(buffer, argc);
+    buffer += encodedArgs;
+    if (buffer.size() >= flushBytes)
+        flush();
+}
+
+void TraceWriter::flush()
+{
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+}
+
+TraceScope::~TraceScope()
+{
+    --depth;
+    if (writer)
+        writer->record(method, start, static_cast<std::uint32_t>(writer->nowUs() - start), args, argc);
+}
+
+void TraceScope::encode(int value)
+{
+    std::int64_t v = value;
+    args += '\0';
+    putVarint(args, (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+    ++argc;
+}
+
+void TraceScope::encode(const std::string& value)
+{
+    args += '\1';
+    putVarint(args, value.size());
+    args += value;
+    ++argc;
+}
+
+TraceReader::TraceReader(const std::string& path)
+    : in(path, std::ios::binary)
+{
+    char header[sizeof(magic)] = {};
+    valid = in.read(header, sizeof(header)) && std::memcmp(header, magic, sizeof(magic)) == 0;
+}
+
+bool TraceReader::next(TraceRecord& record)
+{
+    std::uint64_t method, thread, start, duration, argc;
+    if (!valid || !getVarint(in, method) || !getVarint(in, thread) || !getVarint(in, start)
+        || !getVarint(in, duration) || !getVarint(in, argc))
+        return false;
+    record.method = static_cast<TraceMethod>(method);
+    record.thread = static_cast<std::uint32_t>(thread);
+    record.startUs = start;
+    record.durationUs = static_cast<std::uint32_t>(duration);
+    record.args.assign(argc, TraceArg());
+    for (auto& arg : record.args) {
+        int tag = in.get();
+        std::uint64_t v;
+        if (tag == EOF || !getVarint(in, v))
+            return false;
+        if (tag == 0) {
+            arg.number = static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+        } else {
+            arg.isText = true;
+            arg.text.resize(v);
+            if (!in.read(&arg.text[0], static_cast<std::streamsize>(v)) && v)
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Workload capture for Database. When a trace is open every public Database
+// call made from the outside (nested calls are folded into their caller) is
+// appended to a compact binary file:
+//
+//   file    := "CMSTRC2\0" record*
+//   record  := method thread start_us duration_us argc arg*     (varints)
+//   arg     := 0x00 zigzag-varint | 0x01 length-varint bytes
+//
+// Passwords are recorded as empty strings. cms_replay reads the file back.
+//
+// Not traced: the grading pipeline's bulk calls (stream*, resultsDirtyMark,
+// storeCourseResults), whose callbacks and result batches have no argument
+// encoding and which cms_cli drives itself; the operational calls
+// checkReplicas, analyzeTables and warmUp; isAdminPasswordCorrect, which does
+// not reach the database; and refresh*Dashboard, which is recorded as the
+// changeVersions and slice queries it issues.
+enum class TraceMethod : std::uint16_t {
+    StudentExists, ValidateStudentPassword, ChangeStudentPassword, ResetStudentPassword,
+    GetStudentSemester, GetStudentDegree, FacultyExists, ValidateFacultyPassword,
+    GetFacultyId, GetFacultyName, ChangeFacultyPassword, ResetFacultyPassword,
+    GetAvailableScheduledCourses, IsAlreadyEnrolled, HasClash, AddEnrollment,
+    DropEnrollment, GetEnrolledCourses, AddStudent, RemoveStudent,
+    AddFaculty, RemoveFaculty, AddCourse, RemoveCourse,
+    AddClassroom, RemoveClassroom, AddTimeslot, RemoveTimeslot,
+    GetUnscheduledCourses, GetAllCourses, GetAllFaculty, GetAllTimeslots,
+    GetAvailableRooms, GetAvailableFaculty, AddCourseSchedule, GetAllCourseSchedules,
+    GetCourseSchedulesPage, RemoveCourseSchedule, GetFacultyCourses, GetAllStudents,
+    GetEnrolledStudentsInCourse, GetEnrolledStudentsPage,
+    GetFacultyTimetable, GetTotalEnrolledStudents, AddMarks, UpdateMarks,
+    GetAssignmentsForCourse, GetStudentMarksForAssignment, FetchStudentMarksForAssignment, GetStudentMarks,
+    GetStudentCourses, LoadStudentDashboard, LoadFacultyDashboard, ChangeVersions,
+    JoinWaitlist, LeaveWaitlist, GetStudentWaitlists, GetCourseResults,
+    CurrentTerm, GetTerms, StartTerm, CloseTerm,
+    ArchiveTerm, GetStudentTermMarks, GetScheduleRoster, GetTimeslotRosters,
+    GetClassroomRosters, GetFacultyRosters, GetCourseRosters, GetStudentFootprint,
+    Count
+};
+
+const char* traceMethodName(TraceMethod method);
+
+struct TraceArg {
+    bool isText = false;
+    std::int64_t number = 0;
+    std::string text;
+};
+
+struct TraceRecord {
+    TraceMethod method = TraceMethod::Count;
+    std::uint32_t thread = 0;
+    std::uint64_t startUs = 0;
+    std::uint32_t durationUs = 0;
+    std::vector<TraceArg> args;
+};
+
+class TraceWriter {
+public:
+    // Starts capturing into path for the whole process. Returns false when
+    // the file cannot be created; a second start() while open is a no-op.
+    static bool start(const std::string& path);
+    static void stop();
+    static TraceWriter* active();
+
+    std::uint64_t nowUs() const;
+    void record(TraceMethod method, std::uint64_t startUs, std::uint32_t durationUs, const std::string& encodedArgs, std::uint32_t argc);
+
+    ~TraceWriter();
+
+private:
+    static constexpr std::size_t flushBytes = 64 * 1024;
+    static TraceWriter instance;
+    static std::atomic<TraceWriter*> current;
+
+    std::mutex mutex;
+    std::ofstream out;
+    std::string buffer;
+    std::chrono::steady_clock::time_point origin;
+
+    void flush();
+};
+
+// Placed first in a Database method; records the call when it returns.
+class TraceScope {
+public:
+    template <typename... Args>
+    explicit TraceScope(TraceMethod method, const Args&... args)
+        : writer(depth++ == 0 ? TraceWriter::active() : nullptr), method(method)
+    {
+        if (writer) {
+            (encode(args), ...);
+            start = writer->nowUs();
+        }
+    }
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    static thread_local int depth;
+
+    TraceWriter* writer;
+    TraceMethod method;
+    std::uint64_t start = 0;
+    std::uint32_t argc = 0;
+    std::string args;
+
+    void encode(int value);
+    void encode(const std::string& value);
+};
+
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& path);
+    bool ok() const { return valid; }
+    bool next(TraceRecord& record);
+
+private:
+    std::ifstream in;
+    bool valid = false;
+};